@@ -70,7 +70,7 @@ void BUFFER_Free(BUFFER_t* Buffer) {
 }
 
 uint16_t BUFFER_Write(BUFFER_t* Buffer, uint8_t* Data, uint16_t count) {
-	uint8_t i = 0;
+	uint16_t i = 0;
 	
 	/* Check buffer structure */
 	if (Buffer == NULL) {
@@ -316,6 +316,92 @@ int16_t BUFFER_Find(BUFFER_t* Buffer, uint8_t* Data, uint16_t Size) {
 	return -1;
 }
 
+uint16_t BUFFER_Peek(BUFFER_t* Buffer, uint8_t* Data, uint16_t count) {
+	uint16_t i = 0, Out;
+	
+	/* Check buffer structure */
+	if (Buffer == NULL) {
+		return 0;
+	}
+	
+	/* Create temporary variable */
+	Out = Buffer->Out;
+	
+	/* Check output pointer */
+	if (Out >= Buffer->Size) {
+		Out = 0;
+	}
+	
+	/* Go through all elements */
+	while (count--) {
+		/* Check if pointers are same = no more data */
+		if (Out == Buffer->In) {
+			break;
+		}
+		
+		/* Save to user buffer */
+		*Data++ = Buffer->Buffer[Out++];
+		
+		/* Increase pointers */
+		i++;
+		
+		/* Check output overflow */
+		if (Out >= Buffer->Size) {
+			Out = 0;
+		}
+	}
+	
+	/* Return number of elements copied from buffer */
+	return i;
+}
+
+uint16_t BUFFER_Skip(BUFFER_t* Buffer, uint16_t count) {
+	uint16_t full;
+	
+	/* Check buffer structure */
+	if (Buffer == NULL) {
+		return 0;
+	}
+	
+	/* Check number of elements in buffer */
+	full = BUFFER_GetFull(Buffer);
+	if (count > full) {
+		count = full;
+	}
+	
+	/* Move output pointer */
+	Buffer->Out += count;
+	if (Buffer->Out >= Buffer->Size) {
+		Buffer->Out -= Buffer->Size;
+	}
+	
+	/* Return number of elements removed from buffer */
+	return count;
+}
+
+uint8_t* BUFFER_GetLinearBlock(BUFFER_t* Buffer, uint16_t* count) {
+	/* Check buffer structure */
+	if (Buffer == NULL || Buffer->In == Buffer->Out) {
+		*count = 0;
+		return NULL;
+	}
+	
+	/* Check output pointer */
+	if (Buffer->Out >= Buffer->Size) {
+		Buffer->Out = 0;
+	}
+	
+	/* Data are until input pointer or until end of memory */
+	if (Buffer->In > Buffer->Out) {
+		*count = Buffer->In - Buffer->Out;
+	} else {
+		*count = Buffer->Size - Buffer->Out;
+	}
+	
+	/* Return pointer to first element */
+	return &Buffer->Buffer[Buffer->Out];
+}
+
 uint16_t BUFFER_WriteString(BUFFER_t* Buffer, char* buff) {
 	/* Write string to buffer */
 	return BUFFER_Write(Buffer, (uint8_t *)buff, strlen(buff));
@@ -202,6 +202,32 @@ int16_t BUFFER_FindElement(BUFFER_t* Buffer, uint8_t Element);
  */
 int16_t BUFFER_Find(BUFFER_t* Buffer, uint8_t* Data, uint16_t Size);
 
+/**
+ * @brief  Reads data from buffer without removing them
+ * @param  *Buffer: Pointer to @ref BUFFER_t structure
+ * @param  *Data: Pointer to data where read values will be stored
+ * @param  count: Number of elements of type unsigned char to read
+ * @retval Number of elements copied from buffer
+ */
+uint16_t BUFFER_Peek(BUFFER_t* Buffer, uint8_t* Data, uint16_t count);
+
+/**
+ * @brief  Removes data from buffer without reading them
+ * @param  *Buffer: Pointer to @ref BUFFER_t structure
+ * @param  count: Number of elements of type unsigned char to remove
+ * @retval Number of elements removed from buffer
+ */
+uint16_t BUFFER_Skip(BUFFER_t* Buffer, uint16_t count);
+
+/**
+ * @brief  Gets pointer to first element in buffer and number of elements stored linearly from it
+ * @note   Use @ref BUFFER_Skip to remove elements from buffer when processed
+ * @param  *Buffer: Pointer to @ref BUFFER_t structure
+ * @param  *count: Pointer to save number of linear elements to
+ * @retval Pointer to first element or NULL if buffer is empty
+ */
+uint8_t* BUFFER_GetLinearBlock(BUFFER_t* Buffer, uint16_t* count);
+
 /**
  * @brief  Sets string delimiter character when reading from buffer as string
  * @param  Buffer: Pointer to @ref BUFFER_t structure
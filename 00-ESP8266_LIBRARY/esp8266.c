@@ -52,11 +52,45 @@
 #define ESP8266_COMMAND_CWLIF          27
 #define ESP8266_COMMAND_CIPSTATUS      28
 #define ESP8266_COMMAND_SENDDATA       29
+#if ESP8266_USE_TRANSPARENT
+#define ESP8266_COMMAND_CIPMODE        30
+#define ESP8266_COMMAND_TRANSPARENT    31
+#define ESP8266_COMMAND_TCIPSTART      34
+#define ESP8266_COMMAND_TCIPSEND       35
+#define ESP8266_COMMAND_TESCAPE        36
+#endif
+#if ESP8266_USE_PASSIVE_RECEIVE
+#define ESP8266_COMMAND_CIPRECVMODE    32
+#define ESP8266_COMMAND_CIPRECVDATA    33
+#endif
+
+#if ESP8266_USE_TRANSPARENT
+/* Transparent mode start and stop steps, each step waits for its command */
+#define ESP8266_TRANSPARENT_NONE       0
+#define ESP8266_TRANSPARENT_SERVER_OFF 1
+#define ESP8266_TRANSPARENT_MUX_OFF    2
+#define ESP8266_TRANSPARENT_MODE_ON    3
+#define ESP8266_TRANSPARENT_CONNECT    4
+#define ESP8266_TRANSPARENT_SEND       5
+#define ESP8266_TRANSPARENT_DATA       6
+#define ESP8266_TRANSPARENT_GUARD      7
+#define ESP8266_TRANSPARENT_ESCAPE     8
+#define ESP8266_TRANSPARENT_MODE_OFF   9
+#define ESP8266_TRANSPARENT_CLOSE      10
+#define ESP8266_TRANSPARENT_MUX_ON     11
+#define ESP8266_TRANSPARENT_SERVER_ON  12
+#endif
 
 #if ESP8266_USE_PING
 #define ESP8266_COMMAND_PING           18
 #endif
 
+/* HTTP head parser states */
+#define ESP8266_HEADER_STATE_FIRSTLINE 0
+#define ESP8266_HEADER_STATE_HEADERS   1
+#define ESP8266_HEADER_STATE_DONE      2
+#define ESP8266_HEADER_STATE_NOTHTTP   3
+
 #define ESP8266_DEFAULT_BAUDRATE       115200 /*!< Default ESP8266 baudrate */
 #define ESP8266_TIMEOUT                30000  /*!< Timeout value is milliseconds */
 
@@ -66,6 +100,41 @@
 /* Maximum number of return data size in one +IPD from ESP8266 module */
 #define ESP8255_MAX_BUFF_SIZE          5842
 
+/* Maximum number of bytes ESP8266 accepts in one AT+CIPSEND command */
+#define ESP8266_MAX_SEND_SIZE          2048
+
+#if ESP8266_SEND_CHUNK_SIZE > ESP8266_MAX_SEND_SIZE
+#error ESP8266_SEND_CHUNK_SIZE can not be greater than 2048 bytes!
+#endif
+
+/* Send scheduler visits after which connection with data has credit again, one send charges at most ESP8266_MAX_SEND_SIZE bytes and each round adds quantum */
+#define ESP8266_SEND_SCHEDULE_VISITS   (ESP8266_MAX_CONNECTIONS * (ESP8266_MAX_SEND_SIZE / ESP8266_SEND_QUANTUM + 2))
+
+/* Size of one stream chunk, limited by send buffer where data are prepared */
+#if ESP8266_SEND_CHUNK_SIZE > ESP8266_SEND_BUFFER_SIZE
+#define ESP8266_SEND_CHUNK_MAX         ESP8266_SEND_BUFFER_SIZE
+#else
+#define ESP8266_SEND_CHUNK_MAX         ESP8266_SEND_CHUNK_SIZE
+#endif
+
+/* Maximal number of bytes user can fill on single send request, leave space for "\0" at the end */
+#if ESP8266_SEND_BUFFER_SIZE > (ESP8266_MAX_SEND_SIZE - 2)
+#define ESP8266_SEND_DATA_MAX          (ESP8266_MAX_SEND_SIZE - 2)
+#else
+#define ESP8266_SEND_DATA_MAX          ESP8266_SEND_BUFFER_SIZE
+#endif
+
+#if ESP8266_USE_PINGPONG_RECEIVE && (ESP8266_USE_SINGLE_CONNECTION_BUFFER == 1 || ESP8266_USE_BUFFER_POOL)
+#error ESP8266_USE_PINGPONG_RECEIVE needs separate buffer for each connection!
+#endif
+
+/* Maximal number of bytes read with one AT+CIPRECVDATA command, entire response must fit to USART buffer */
+#if ESP8266_CONNECTION_BUFFER_SIZE > (ESP8266_USARTBUFFER_SIZE / 2)
+#define ESP8266_RECEIVE_DATA_MAX       (ESP8266_USARTBUFFER_SIZE / 2)
+#else
+#define ESP8266_RECEIVE_DATA_MAX       ESP8266_CONNECTION_BUFFER_SIZE
+#endif
+
 /* Temporary buffer */
 static BUFFER_t TMP_Buffer;
 static BUFFER_t USART_Buffer;
@@ -78,10 +147,33 @@ static ESP8266_APs_t ESP8266_APs;
 #endif
 
 /* Create data array for connections */
-#if ESP8266_USE_SINGLE_CONNECTION_BUFFER == 1
+#if ESP8266_USE_BUFFER_POOL
+static char BufferPool[ESP8266_BUFFER_POOL_BLOCKS * ESP8266_BUFFER_POOL_BLOCK_SIZE]; /*!< Blocks for connection data */
+static uint8_t BufferPoolOwner[ESP8266_BUFFER_POOL_BLOCKS];                          /*!< Connection index + 1 which owns block, 0 when block is free */
+#elif ESP8266_USE_SINGLE_CONNECTION_BUFFER == 1
 static char ConnectionData[ESP8266_CONNECTION_BUFFER_SIZE]; /*!< Data array */
 #endif
 
+/* Size of data buffer for connection */
+#if ESP8266_USE_BUFFER_POOL
+#define ESP8266_DATA_BUFFER_SIZE(conn)  ((conn)->DataBufferSize)
+#elif ESP8266_USE_PINGPONG_RECEIVE
+#define ESP8266_DATA_BUFFER_SIZE(conn)  (ESP8266_CONNECTION_BUFFER_SIZE / 2)
+#define ESP8266_PINGPONG_DATA(conn)     (&(conn)->DataMemory[(conn)->DataHalf * (ESP8266_CONNECTION_BUFFER_SIZE / 2)])
+#else
+#define ESP8266_DATA_BUFFER_SIZE(conn)  ESP8266_CONNECTION_BUFFER_SIZE
+#endif
+
+/* Check if connection has data sink */
+#if ESP8266_USE_DATA_SINK
+#define ESP8266_HAS_SINK(conn)          ((conn)->DataSink != NULL)
+#else
+#define ESP8266_HAS_SINK(conn)          0
+#endif
+
+/* Data array for outgoing data, filled by user in send data callbacks */
+static char SendBuffer[ESP8266_SEND_BUFFER_SIZE];
+
 /* Private functions */
 #if ESP8266_USE_APSEARCH
 static void ParseCWLAP(ESP8266_t* ESP8266, char* Buffer);
@@ -100,7 +192,49 @@ static ESP8266_Result_t SendCommand(ESP8266_t* ESP8266, uint8_t Command, char* C
 static ESP8266_Result_t SendUARTCommand(ESP8266_t* ESP8266, uint32_t baudrate, char* cmd);
 static ESP8266_Result_t SendMACCommand(ESP8266_t* ESP8266, uint8_t* addr, char* cmd, uint8_t command);
 static void CallConnectionCallbacks(ESP8266_t* ESP8266);
+static void CallDataReceivedCallback(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void CloseSchedule(ESP8266_t* ESP8266);
+static void ResetHeaders(ESP8266_Connection_t* Connection);
+static void ParseHeaders(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const char* data, uint16_t length);
+static void ParseHeaderLine(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+#if ESP8266_USE_DATA_SINK
+static void CallDataSink(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const uint8_t* data, uint16_t length);
+#endif
+#if ESP8266_USE_PINGPONG_RECEIVE
+static uint8_t PingPongReady(ESP8266_t* ESP8266, BUFFER_t* Buffer);
+#endif
+#if ESP8266_USE_BUFFER_POOL
+static void BufferPoolAllocate(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint32_t length);
+static void BufferPoolFree(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+#endif
+static void StartIPD(ESP8266_t* ESP8266, uint8_t number, uint32_t length, char* Received, uint16_t offset, uint16_t bufflen, uint8_t from_usart_buffer);
+#if ESP8266_USE_PASSIVE_RECEIVE
+static void ReceiveSchedule(ESP8266_t* ESP8266);
+#endif
 static void ProcessSendData(ESP8266_t* ESP8266);
+static ESP8266_Result_t SendDataCommand(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static ESP8266_Result_t SendChunkCommand(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static ESP8266_Result_t StartConnection(ESP8266_t* ESP8266, const char* type, char* name, char* location, uint16_t port, uint16_t local_port, uint8_t mode, void* user_parameters);
+static uint8_t SendPending(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void SendSchedule(ESP8266_t* ESP8266);
+static void SendSegmentsData(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void SendDataCompleted(ESP8266_t* ESP8266, uint8_t success);
+static void SendDataFinished(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t success);
+#if ESP8266_USE_SENDBUF
+static void SendBufAccepted(ESP8266_t* ESP8266);
+static void SendBufAcknowledged(ESP8266_t* ESP8266, char* Received, uint8_t success);
+static void SendBufContinue(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+#endif
+#if ESP8266_USE_TRANSPARENT
+static void TransparentReceive(ESP8266_t* ESP8266);
+static void TransparentSchedule(ESP8266_t* ESP8266);
+static void TransparentStep(ESP8266_t* ESP8266, uint8_t step);
+#endif
+#if ESP8266_USE_WRITEBUFFER
+static uint8_t WriteBufferReady(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static ESP8266_Result_t WriteBufferStart(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void WriteBufferFlushed(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t success);
+#endif
 void* mem_mem(void* haystack, size_t haystacksize, void* needle, size_t needlesize);
 
 #define CHARISNUM(x)    ((x) >= '0' && (x) <= '9')
@@ -115,13 +249,16 @@ static uint32_t ESP8266_Baudrate[] = {
 	9600, 57600, 115200, 921600
 };
 
-/* Check IDLE */
+/* Check IDLE, commands can not be started from received data callbacks */
 #define ESP8266_CHECK_IDLE(ESP8266)                         \
 do {                                                        \
 	if (                                                    \
-		(ESP8266)->ActiveCommand != ESP8266_COMMAND_IDLE    \
+		(ESP8266)->ActiveCommand != ESP8266_COMMAND_IDLE || \
+		(ESP8266)->Flags.F.InCallback                       \
 	) {                                                     \
-		ESP8266_Update(ESP8266);                            \
+		if (!(ESP8266)->Flags.F.InCallback) {               \
+			ESP8266_Update(ESP8266);                        \
+		}                                                   \
 		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_BUSY);        \
 	}                                                       \
 } while (0);
@@ -143,17 +280,38 @@ do {                                                        \
 	return status;                                          \
 } while (0); 
 
+/* Call connection handler function, commands called from handler are only queued */
+#define ESP8266_CALLHANDLER(ESP8266, conn, func, args)      \
+do {                                                        \
+	if ((conn)->Handler->func != NULL) {                    \
+		uint8_t in_callback = (ESP8266)->Flags.F.InCallback; \
+		(ESP8266)->Flags.F.InCallback = 1;                  \
+		(conn)->Handler->func args;                         \
+		(ESP8266)->Flags.F.InCallback = in_callback;        \
+	}                                                       \
+} while (0);
+
 /* Reset ESP connection */
 #define ESP8266_RESETCONNECTION(ESP8266, conn)              \
 do {                                                        \
 	(conn)->Active = 0;                                     \
 	(conn)->Client = 0;                                     \
+	(conn)->Udp = 0;                                        \
 	(conn)->FirstPacket = 0;                                \
 	(conn)->HeadersDone = 0;                                \
+	(conn)->ClosePending = 0;                               \
 } while (0);                                                \
 
 /* Reset all connections */
+#if ESP8266_USE_BUFFER_POOL
+#define ESP8266_RESET_CONNECTIONS(ESP8266)                  \
+do {                                                        \
+	memset(ESP8266->Connection, 0, sizeof(ESP8266->Connection)); \
+	memset(BufferPoolOwner, 0, sizeof(BufferPoolOwner));    \
+} while (0);
+#else
 #define ESP8266_RESET_CONNECTIONS(ESP8266)                  memset(ESP8266->Connection, 0, sizeof(ESP8266->Connection));
+#endif
 
 /******************************************/
 /*          Basic AT commands Set         */
@@ -175,7 +333,12 @@ ESP8266_Result_t ESP8266_Init(ESP8266_t* ESP8266, uint32_t baudrate) {
 		/* Return from function */
 		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_NOHEAP);
 	}
-
+	
+#if ESP8266_USE_BUFFER_POOL
+	/* All pool blocks are free */
+	memset(BufferPoolOwner, 0, sizeof(BufferPoolOwner));
+#endif
+	
 	/* Init RESET pin */
 	ESP8266_RESET_INIT;
 	
@@ -205,7 +368,7 @@ ESP8266_Result_t ESP8266_Init(ESP8266_t* ESP8266, uint32_t baudrate) {
 	
 	/* Wait till idle */
 	ESP8266_WaitReady(ESP8266);
-
+	
 	/* Check status */
 	if (!ESP8266->Flags.F.LastOperationStatus) {
 		/* Check for baudrate, try with predefined baudrates */
@@ -264,6 +427,15 @@ ESP8266_Result_t ESP8266_Init(ESP8266_t* ESP8266, uint32_t baudrate) {
 	/* Enable IP and PORT to be shown on +IPD statement */
 	while (ESP8266_Setdinfo(ESP8266, 1) != ESP_OK);
 	
+#if ESP8266_USE_PASSIVE_RECEIVE
+	/* Enable passive receive mode */
+	SendCommand(ESP8266, ESP8266_COMMAND_CIPRECVMODE, "AT+CIPRECVMODE=1\r\n", "AT+CIPRECVMODE");
+	ESP8266_WaitReady(ESP8266);
+	if (!ESP8266->Flags.F.LastOperationStatus) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
+	}
+#endif
+	
 	/* Get station MAC */
 	while (ESP8266_GetSTAMAC(ESP8266) != ESP_OK);
 	
@@ -365,6 +537,46 @@ ESP8266_Result_t ESP8266_Update(ESP8266_t* ESP8266) {
 	uint8_t lastcmd;
 	uint16_t stringlength;
 	
+	/* Update can not be called from received data callback */
+	if (ESP8266->Flags.F.InCallback) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_BUSY);
+	}
+	
+#if ESP8266_USE_TRANSPARENT
+	/* In transparent mode, everything received are raw data for user */
+	if (ESP8266->ActiveCommand == ESP8266_COMMAND_TRANSPARENT || ESP8266->ActiveCommand == ESP8266_COMMAND_TESCAPE) {
+		TransparentReceive(ESP8266);
+		
+#if ESP8266_TRANSPARENT_TIMEOUT
+		/* Leave transparent mode when there was no data for too long */
+		if (ESP8266->ActiveCommand == ESP8266_COMMAND_TRANSPARENT && (ESP8266->Time - ESP8266->StartTime) > ESP8266_TRANSPARENT_TIMEOUT) {
+			ESP8266_TransparentStop(ESP8266);
+			
+			/* Call user function */
+			ESP8266_Callback_TransparentTimeout(ESP8266);
+		}
+#endif
+		
+		/* "+++" must be standalone packet, nothing is sent for guard time before and after it */
+		if (ESP8266->ActiveCommand == ESP8266_COMMAND_TESCAPE && (ESP8266->Time - ESP8266->StartTime) >= ESP8266_TRANSPARENT_GUARD_TIME) {
+			if (ESP8266->TransparentState == ESP8266_TRANSPARENT_GUARD) {
+				/* Send sequence and wait guard time again */
+				ESP8266_LL_USARTSend((uint8_t *)"+++", 3);
+				ESP8266->TransparentState = ESP8266_TRANSPARENT_ESCAPE;
+				ESP8266->StartTime = ESP8266->Time;
+			} else {
+				/* Back to AT command mode, continue with next step immediately */
+				ESP8266->ActiveCommand = ESP8266_COMMAND_IDLE;
+				ESP8266->Flags.F.LastOperationStatus = 1;
+				TransparentSchedule(ESP8266);
+			}
+		}
+		
+		/* Return OK */
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+	}
+#endif
+	
 	/* If timeout is set to 0 */
 	if (ESP8266->Timeout == 0) {
 		ESP8266->Timeout = 30000;
@@ -384,32 +596,17 @@ ESP8266_Result_t ESP8266_Update(ESP8266_t* ESP8266) {
 			ESP8266_RESETCONNECTION(ESP8266, &ESP8266->Connection[ESP8266->StartConnectionSent]);
 			
 			/* Call user function */
-			ESP8266_Callback_ClientConnectionTimeout(ESP8266, &ESP8266->Connection[ESP8266->StartConnectionSent]);
-		}
-	}
-	
-	/* We are waiting to send data */
-	if (ESP8266_COMMAND_SENDDATA) {
-		/* Check what we are searching for */
-		if (ESP8266->Flags.F.WaitForWrapper) {
-			int16_t found;
-			uint8_t dummy[2];
-			/* Wait for character */
-			if ((found = BUFFER_Find(&USART_Buffer, (uint8_t *)"> ", 2)) >= 0) {
-				if (found == 0) {
-					/* Make a dummy read */
-					BUFFER_Read(&USART_Buffer, dummy, 2);
-				}
-			} else if ((found = BUFFER_Find(&TMP_Buffer, (uint8_t *)"> ", 0)) >= 0) {
-				if (found == 0) {
-					/* Make 2 dummy reads */
-					BUFFER_Read(&TMP_Buffer, dummy, 2);
-				}
-			}
-			if (found >= 0) {
-				/* Send data */
-				ProcessSendData(ESP8266);
+			if (ESP8266->Connection[ESP8266->StartConnectionSent].Handler != NULL) {
+				ESP8266_CALLHANDLER(ESP8266, &ESP8266->Connection[ESP8266->StartConnectionSent], Error, (ESP8266, &ESP8266->Connection[ESP8266->StartConnectionSent]));
+			} else {
+				ESP8266_Callback_ClientConnectionTimeout(ESP8266, &ESP8266->Connection[ESP8266->StartConnectionSent]);
 			}
+		} else if (lastcmd == ESP8266_COMMAND_SEND || lastcmd == ESP8266_COMMAND_SENDDATA) {
+			/* We are not waiting for wrapper anymore */
+			ESP8266->Flags.F.WaitForWrapper = 0;
+			
+			/* Sending data failed */
+			SendDataCompleted(ESP8266, 0);
 		}
 	}
 	
@@ -437,6 +634,9 @@ ESP8266_Result_t ESP8266_Update(ESP8266_t* ESP8266) {
 	/* Get string from USART buffer if we are not in IPD mode */
 	while (
 		!ESP8266->IPD.InIPD &&                                                             /*!< Not in IPD mode */
+#if ESP8266_USE_PINGPONG_RECEIVE
+		PingPongReady(ESP8266, &USART_Buffer) &&                                           /*!< Free buffer half if next string starts +IPD data */
+#endif
 		//!ESP8266->Flags.F.WaitForWrapper &&
 		(stringlength = BUFFER_ReadString(&USART_Buffer, Received, sizeof(Received))) > 0 /*!< Something in USART buffer */
 	) {		
@@ -444,9 +644,56 @@ ESP8266_Result_t ESP8266_Update(ESP8266_t* ESP8266) {
 		ParseReceived(ESP8266, Received, 1, stringlength);
 	}
 	
+	/* We are waiting to send data */
+	if (
+		ESP8266->ActiveCommand == ESP8266_COMMAND_SENDDATA && /*!< Module accepted send command */
+		ESP8266->Flags.F.WaitForWrapper &&                    /*!< We are still waiting for "> " wrapper */
+		!ESP8266->IPD.InIPD                                   /*!< We are not in IPD mode */
+	) {
+		uint8_t dummy[2];
+		
+		/* Wrapper must be first in buffer, all strings before it are already processed */
+		if (BUFFER_Find(&USART_Buffer, (uint8_t *)"> ", 2) == 0) {
+			/* Make a dummy read */
+			BUFFER_Read(&USART_Buffer, dummy, 2);
+			
+			/* Send data */
+			ProcessSendData(ESP8266);
+		}
+	}
+	
+#if ESP8266_USE_TRANSPARENT
+	/* Module accepted AT+CIPSEND in transparent mode and we wait for ">" character */
+	if (
+		ESP8266->ActiveCommand == ESP8266_COMMAND_TCIPSEND && /*!< Module accepted send command */
+		ESP8266->Flags.F.WaitForWrapper &&                    /*!< We are still waiting for ">" wrapper */
+		BUFFER_Find(&USART_Buffer, (uint8_t *)">", 1) == 0    /*!< Wrapper is first in buffer */
+	) {
+		char dummy;
+		
+		/* Make a dummy read */
+		BUFFER_Read(&USART_Buffer, (uint8_t *)&dummy, 1);
+		ESP8266->Flags.F.WaitForWrapper = 0;
+		
+		/* We are in transparent mode now, start time is used for inactivity timeout */
+		ESP8266->ActiveCommand = ESP8266_COMMAND_TRANSPARENT;
+		ESP8266->TransparentState = ESP8266_TRANSPARENT_DATA;
+		ESP8266->StartTime = ESP8266->Time;
+		
+		/* Call user function */
+		ESP8266_Callback_TransparentConnected(ESP8266);
+		
+		/* Return OK */
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+	}
+#endif
+	
 	/* Get string from TMP buffer when no command active */
 	while (
 		!ESP8266->IPD.InIPD &&                                                             /*!< Not in IPD mode */
+#if ESP8266_USE_PINGPONG_RECEIVE
+		PingPongReady(ESP8266, &TMP_Buffer) &&                                             /*!< Free buffer half if next string starts +IPD data */
+#endif
 		//!ESP8266->Flags.F.WaitForWrapper &&
 		ESP8266->ActiveCommand == ESP8266_COMMAND_IDLE &&                                  /*!< We are in IDLE mode */
 		(stringlength = BUFFER_ReadString(&TMP_Buffer, Received, sizeof(Received))) > 0 /*!< Something in TMP buffer */
@@ -465,14 +712,51 @@ ESP8266_Result_t ESP8266_Update(ESP8266_t* ESP8266) {
 			buff = &TMP_Buffer;
 		}
 		
+#if ESP8266_USE_DATA_SINK
+		/* Pass data to sink directly from buffer */
+		if (ESP8266_HAS_SINK(&ESP8266->Connection[ESP8266->IPD.ConnNumber])) {
+			uint8_t* block;
+			uint16_t count;
+			
+			while (
+				ESP8266->IPD.PtrTotal < ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived && /*!< Still not everything received */
+				(block = BUFFER_GetLinearBlock(buff, &count)) != NULL                       /*!< Data are available in buffer */
+			) {
+				/* Check number of bytes for this packet */
+				if (count > ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived - ESP8266->IPD.PtrTotal) {
+					count = ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived - ESP8266->IPD.PtrTotal;
+				}
+				
+				/* Call sink and remove data from buffer */
+				CallDataSink(ESP8266, &ESP8266->Connection[ESP8266->IPD.ConnNumber], block, count);
+				BUFFER_Skip(buff, count);
+				
+				/* Increase pointers */
+				ESP8266->IPD.InPtr += count;
+				ESP8266->IPD.PtrTotal += count;
+			}
+		}
+#endif
+		
 		/* If anything received */
 		while (
-			ESP8266->IPD.InPtr < ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived && /*!< Still not everything received */
+			ESP8266->IPD.PtrTotal < ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived && /*!< Still not everything received */
+#if ESP8266_USE_PINGPONG_RECEIVE
+			!(ESP8266->Connection[ESP8266->IPD.ConnNumber].DataHeld & (1 << ESP8266->Connection[ESP8266->IPD.ConnNumber].DataHalf)) && /*!< Buffer half is not held by application */
+#endif
 			BUFFER_GetFull(buff) > 0                                                    /*!< Data are available in buffer */
 		) {
 			/* Read from buffer */
 			BUFFER_Read(buff, (uint8_t *)&ch, 1);
 			
+#if ESP8266_USE_BUFFER_POOL
+			/* Connection has no buffer, drop data */
+			if (ESP8266->Connection[ESP8266->IPD.ConnNumber].Data == NULL) {
+				ESP8266->IPD.PtrTotal++;
+				continue;
+			}
+#endif
+			
 			/* Add from USART buffer */
 			ESP8266->Connection[ESP8266->IPD.ConnNumber].Data[ESP8266->IPD.InPtr] = ch;
 			
@@ -480,19 +764,15 @@ ESP8266_Result_t ESP8266_Update(ESP8266_t* ESP8266) {
 			ESP8266->IPD.InPtr++;
 			ESP8266->IPD.PtrTotal++;
 			
-#if ESP8266_CONNECTION_BUFFER_SIZE < ESP8255_MAX_BUFF_SIZE
+#if ESP8266_USE_BUFFER_POOL || ESP8266_USE_PINGPONG_RECEIVE || ESP8266_CONNECTION_BUFFER_SIZE < ESP8255_MAX_BUFF_SIZE
 			/* Check for pointer */
-			if (ESP8266->IPD.InPtr >= ESP8266_CONNECTION_BUFFER_SIZE && ESP8266->IPD.InPtr != ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived) {
+			if (ESP8266->IPD.InPtr >= ESP8266_DATA_BUFFER_SIZE(&ESP8266->Connection[ESP8266->IPD.ConnNumber]) && ESP8266->IPD.PtrTotal != ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived) {
 				/* Set connection buffer size */
 				ESP8266->Connection[ESP8266->IPD.ConnNumber].DataSize = ESP8266->IPD.InPtr;
 				ESP8266->Connection[ESP8266->IPD.ConnNumber].LastPart = 0;
 				
 				/* Buffer is full, call user function */
-				if (ESP8266->Connection[ESP8266->IPD.ConnNumber].Client) {
-					ESP8266_Callback_ClientConnectionDataReceived(ESP8266, &ESP8266->Connection[ESP8266->IPD.ConnNumber], ESP8266->Connection[ESP8266->IPD.ConnNumber].Data);
-				} else {
-					ESP8266_Callback_ServerConnectionDataReceived(ESP8266, &ESP8266->Connection[ESP8266->IPD.ConnNumber], ESP8266->Connection[ESP8266->IPD.ConnNumber].Data);
-				}
+				CallDataReceivedCallback(ESP8266, &ESP8266->Connection[ESP8266->IPD.ConnNumber]);
 				
 				/* Reset input pointer */
 				ESP8266->IPD.InPtr = 0;
@@ -502,8 +782,6 @@ ESP8266_Result_t ESP8266_Update(ESP8266_t* ESP8266) {
 		
 		/* Check if everything received */
 		if (ESP8266->IPD.PtrTotal >= ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived) {
-			char* ptr;
-			
 			/* Not in IPD anymore */
 			ESP8266->IPD.InIPD = 0;
 			
@@ -511,26 +789,40 @@ ESP8266_Result_t ESP8266_Update(ESP8266_t* ESP8266) {
 			ESP8266->Connection[ESP8266->IPD.ConnNumber].DataSize = ESP8266->IPD.InPtr;
 			ESP8266->Connection[ESP8266->IPD.ConnNumber].LastPart = 1;
 			
-			/* We have data, lets see if Content-Length exists and save it */
-			if (
-				ESP8266->Connection[ESP8266->IPD.ConnNumber].FirstPacket &&
-				(ptr = strstr(ESP8266->Connection[ESP8266->IPD.ConnNumber].Data, "Content-Length: ")) != NULL
-			) {
-				/* Increase pointer and parse number */
-				ptr += 16;
-				
-				/* Parse content length */
-				ESP8266->Connection[ESP8266->IPD.ConnNumber].ContentLength = ParseNumber(ptr, NULL);
+#if ESP8266_USE_BUFFER_POOL
+			/* Data were dropped, nothing to call */
+			if (ESP8266->Connection[ESP8266->IPD.ConnNumber].Data == NULL && !ESP8266_HAS_SINK(&ESP8266->Connection[ESP8266->IPD.ConnNumber])) {
+				ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
 			}
+#endif
 			
 			/* Set flag to trigger callback for data received */
 			ESP8266->Connection[ESP8266->IPD.ConnNumber].CallDataReceived = 1;
+			
+			/* Deliver data immediately, before anything else is read to buffer */
+			CallConnectionCallbacks(ESP8266);
 		}
 	}
 	
 	/* Call user functions on connections if needed */
 	CallConnectionCallbacks(ESP8266);
 	
+#if ESP8266_USE_TRANSPARENT
+	/* Continue transparent mode start or stop when previous step is finished */
+	TransparentSchedule(ESP8266);
+#endif
+	
+	/* Close connections requested while module was busy */
+	CloseSchedule(ESP8266);
+	
+#if ESP8266_USE_PASSIVE_RECEIVE
+	/* Read available data from module if module is free */
+	ReceiveSchedule(ESP8266);
+#endif
+	
+	/* Start next send if module is free */
+	SendSchedule(ESP8266);
+	
 	/* Return OK */
 	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
 }
@@ -543,17 +835,14 @@ void ESP8266_TimeUpdate(ESP8266_t* ESP8266, uint32_t time_increase) {
 ESP8266_Result_t ESP8266_WaitReady(ESP8266_t* ESP8266) {
 	/* Do job */
 	do {
-		/* Check for wrapper */
-		if (ESP8266->Flags.F.WaitForWrapper) {
-			/* We have found it, stop execution here */
-			if (BUFFER_Find(&USART_Buffer, (uint8_t *)"> ", 2) >= 0) {
-				ESP8266->Flags.F.WaitForWrapper = 0;
-				break;
-			}
-		}
 		/* Update device */
 		ESP8266_Update(ESP8266);
-	} while (ESP8266->ActiveCommand != ESP8266_COMMAND_IDLE);
+	} while (ESP8266->ActiveCommand != ESP8266_COMMAND_IDLE && !ESP8266->Flags.F.InCallback);
+	
+	/* Module can not be updated from received data callback */
+	if (ESP8266->ActiveCommand != ESP8266_COMMAND_IDLE) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_BUSY);
+	}
 	
 	/* Return OK */
 	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
@@ -580,7 +869,7 @@ ESP8266_Result_t ESP8266_SetMode(ESP8266_t* ESP8266, ESP8266_Mode_t Mode) {
 	
 	/* Save mode we sent */
 	ESP8266->SentMode = Mode;
-
+	
 	/* Wait till command end */
 	ESP8266_WaitReady(ESP8266);
 	
@@ -594,148 +883,480 @@ ESP8266_Result_t ESP8266_SetMode(ESP8266_t* ESP8266, ESP8266_Mode_t Mode) {
 	return ESP8266_GetAP(ESP8266);
 }
 
-ESP8266_Result_t ESP8266_RequestSendData(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
-	char command[30];
+ESP8266_Result_t ESP8266_SetConnectionPriority(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t priority) {
+	/* Save priority */
+	Connection->Priority = priority;
 	
-	/* Check idle state */
-	ESP8266_CHECK_IDLE(ESP8266);
-	
-	/* Format command */
-	sprintf(command, "AT+CIPSENDEX=%d,2048\r\n", Connection->Number);
-	
-	/* Send command */
-	if (SendCommand(ESP8266, ESP8266_COMMAND_SEND, command, "AT+CIPSENDEX") != ESP_OK) {
-		return ESP8266->Result;
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
+
+ESP8266_Result_t ESP8266_RequestSendData(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	/* Check connection */
+	if (!Connection->Active) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_LINKNOTVALID);
 	}
 	
-	/* We are waiting for "> " response */
-	Connection->WaitForWrapper = 1;
-	ESP8266->Flags.F.WaitForWrapper = 1;
+	/* Check if connection is already sending */
+	if (Connection->SendRequest || Connection->SendLength) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_BUSY);
+	}
 	
-	/* Save connection pointer */
-	ESP8266->SendDataConnection = Connection;
+	/* This is not a stream */
+	Connection->SendSegments = NULL;
 	
-	/* Return from function */
-	return ESP8266->Result;
-}
-
-ESP8266_Result_t ESP8266_CloseConnection(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
-	char tmp[30];
+	/* Queue request */
+	Connection->SendRequest = 1;
 	
-	/* Format connection */
-	sprintf(tmp, "AT+CIPCLOSE=%d\r\n", Connection->Number);
+	/* Start sending if module is free */
+	SendSchedule(ESP8266);
 	
-	/* Send command */
-	return SendCommand(ESP8266, ESP8266_COMMAND_CLOSE, tmp, "AT+CIPCLOSE");
-}
-
-ESP8266_Result_t ESP8266_CloseAllConnections(ESP8266_t* ESP8266) {
-	/* Send command */
-	return SendCommand(ESP8266, ESP8266_COMMAND_CLOSE, "AT+CIPCLOSE=5\r\n", "AT+CIPCLOSE");
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
 }
 
-ESP8266_Result_t ESP8266_AllConectionsClosed(ESP8266_t* ESP8266) {
-	uint8_t i;
+ESP8266_Result_t ESP8266_RequestSendStream(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint32_t length) {
+	/* Check connection */
+	if (!Connection->Active) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_LINKNOTVALID);
+	}
 	
-	/* Go through all connections */
-	for (i = 0; i < ESP8266_MAX_CONNECTIONS; i++) {
-		/* Check if active */
-		if (ESP8266->Connection[i].Active) {
-			ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
-		}
+	/* Check if connection is already sending */
+	if (Connection->SendRequest || Connection->SendLength) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_BUSY);
+	}
+	
+	/* Check length */
+	if (length == 0) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
 	}
 	
+	/* Save stream informations */
+	Connection->SendLength = length;
+	Connection->SendOffset = 0;
+	Connection->SendError = 0;
+	Connection->SendSegments = NULL;
+	
+	/* Start sending if module is free */
+	SendSchedule(ESP8266);
+	
 	/* Return OK */
 	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
 }
 
-ESP8266_Result_t ESP8266_SetMux(ESP8266_t* ESP8266, uint8_t mux) {
-	char tmp[30];
+ESP8266_Result_t ESP8266_RequestSendSegments(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const ESP8266_Segment_t* Segments, uint8_t count) {
+	uint32_t length = 0;
+	uint8_t i;
 	
-	/* Format command */
-	sprintf(tmp, "AT+CIPMUX=%d\r\n", mux);
+	/* Check connection */
+	if (!Connection->Active) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_LINKNOTVALID);
+	}
 	
-	/* Send command */
-	if (SendCommand(ESP8266, ESP8266_COMMAND_CIPMUX, tmp, "AT+CIPMUX") != ESP_OK) {
-		return ESP8266->Result;
+	/* Check if connection is already sending */
+	if (Connection->SendRequest || Connection->SendLength) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_BUSY);
 	}
 	
-	/* Wait till command end */
-	ESP8266_WaitReady(ESP8266);
+	/* Calculate total length of all segments */
+	for (i = 0; i < count; i++) {
+		length += Segments[i].Length;
+	}
 	
-	/* Check last status */
-	if (!ESP8266->Flags.F.LastOperationStatus) {
-		/* Return error */
+	/* Check length */
+	if (length == 0) {
 		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
 	}
 	
+	/* Save stream informations */
+	Connection->SendLength = length;
+	Connection->SendOffset = 0;
+	Connection->SendError = 0;
+	
+	/* Save segments and reset segment position */
+	Connection->SendSegments = Segments;
+	Connection->SendSegmentsCount = count;
+	Connection->SendSegmentIndex = 0;
+	Connection->SendSegmentOffset = 0;
+	
+	/* Start sending if module is free */
+	SendSchedule(ESP8266);
+	
 	/* Return OK */
 	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
 }
 
-ESP8266_Result_t ESP8266_Setdinfo(ESP8266_t* ESP8266, uint8_t info) {
-	char tmp[30];
-	
-	/* Format string */
-	sprintf(tmp, "AT+CIPDINFO=%d\r\n", info);
-
-	/* Send command and wait */
-	if (SendCommand(ESP8266, ESP8266_COMMAND_CIPDINFO, tmp, "AT+CIPDINFO") != ESP_OK) {
-		return ESP8266->Result;
+#if ESP8266_USE_WRITEBUFFER
+ESP8266_Result_t ESP8266_Write(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const void* data, uint16_t length) {
+	/* Check connection */
+	if (!Connection->Active) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_LINKNOTVALID);
 	}
-
-	/* Wait till command end */
-	ESP8266_WaitReady(ESP8266);
 	
-	/* Check last status */
-	if (!ESP8266->Flags.F.LastOperationStatus) {
-		/* Return error */
+	/* Check length */
+	if (length == 0 || length > ESP8266_WRITEBUFFER_SIZE) {
 		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
 	}
 	
+	/* Check free memory */
+	if (length > (ESP8266_WRITEBUFFER_SIZE - Connection->WriteLength)) {
+		/* Start flush to make space */
+		Connection->WriteFlushRequest = 1;
+		SendSchedule(ESP8266);
+		
+		/* Return busy */
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_BUSY);
+	}
+	
+	/* Save time of first byte */
+	if (Connection->WriteLength == Connection->WriteFlushing) {
+		Connection->WriteTime = ESP8266->Time;
+	}
+	
+	/* Copy data to buffer */
+	memcpy(&Connection->WriteBuffer[Connection->WriteLength], data, length);
+	Connection->WriteLength += length;
+	Connection->WriteRecords++;
+	Connection->WriteCount++;
+	
+	/* Check if buffer should be flushed */
+	SendSchedule(ESP8266);
+	
 	/* Return OK */
 	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
 }
 
-ESP8266_Result_t ESP8266_ServerEnable(ESP8266_t* ESP8266, uint16_t port) {
-	char tmp[30];
+ESP8266_Result_t ESP8266_Flush(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	/* Check connection */
+	if (!Connection->Active) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_LINKNOTVALID);
+	}
 	
-	/* Format string */
-	sprintf(tmp, "AT+CIPSERVER=1,%d\r\n", port);
-
-	/* Send command and wait */
-	if (SendCommand(ESP8266, ESP8266_COMMAND_CIPSERVER, tmp, "AT+CIPSERVER") != ESP_OK) {
-		return ESP8266->Result;
+	/* Request flush */
+	if (Connection->WriteLength > Connection->WriteFlushing) {
+		Connection->WriteFlushRequest = 1;
+		SendSchedule(ESP8266);
 	}
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
+#endif
 
-	/* Wait till command end */
-	ESP8266_WaitReady(ESP8266);
+#if ESP8266_USE_PASSIVE_RECEIVE
+ESP8266_Result_t ESP8266_SetReceiveHold(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t hold) {
+	/* Save hold status */
+	Connection->ReceiveHold = hold;
+	
+	/* Start reading if data are waiting */
+	if (!hold) {
+		ReceiveSchedule(ESP8266);
+	}
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
+#endif
 
-	/* Check last status */
-	if (!ESP8266->Flags.F.LastOperationStatus) {
-		/* Return error */
+#if ESP8266_USE_BUFFER_POOL
+ESP8266_Result_t ESP8266_SetConnectionBufferBlocks(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t blocks) {
+	/* Check value */
+	if (blocks == 0 || blocks > ESP8266_BUFFER_POOL_BLOCKS) {
 		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
 	}
 	
+	/* Save new limit, used on next +IPD packet */
+	Connection->DataBufferBlocks = blocks;
+	
 	/* Return OK */
 	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
 }
+#endif
 
-ESP8266_Result_t ESP8266_ServerDisable(ESP8266_t* ESP8266) {
-	/* Send command and wait */
-	if (SendCommand(ESP8266, ESP8266_COMMAND_CIPSERVER, "AT+CIPSERVER=0\r\n", "AT+CIPSERVER") != ESP_OK) {
+#if ESP8266_USE_RECEIVE_STREAM
+uint16_t ESP8266_Read(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, void* data, uint16_t count) {
+	/* Read from stream */
+	return BUFFER_Read(&Connection->ReceiveStream, (uint8_t *)data, count);
+}
+
+uint16_t ESP8266_Available(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	/* Get number of bytes in stream */
+	return BUFFER_GetFull(&Connection->ReceiveStream);
+}
+
+uint16_t ESP8266_Peek(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, void* data, uint16_t count) {
+	/* Copy from stream */
+	return BUFFER_Peek(&Connection->ReceiveStream, (uint8_t *)data, count);
+}
+
+uint16_t ESP8266_Skip(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint16_t count) {
+	/* Remove from stream */
+	return BUFFER_Skip(&Connection->ReceiveStream, count);
+}
+#endif
+
+ESP8266_Result_t ESP8266_ResetHeaders(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	/* Reset parser */
+	ResetHeaders(Connection);
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
+
+ESP8266_Result_t ESP8266_ParseHeaders(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const char* data, uint16_t length) {
+	/* Parse head */
+	ParseHeaders(ESP8266, Connection, data, length);
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
+
+uint8_t ESP8266_HeaderMatch(const char* str, const char* name) {
+	char ch;
+	
+	/* Compare case insensitive, name is lower case */
+	while (*name) {
+		ch = *str++;
+		if (ch >= 'A' && ch <= 'Z') {
+			ch += 'a' - 'A';
+		}
+		if (ch != *name++) {
+			return 0;
+		}
+	}
+	
+	/* String starts with name */
+	return 1;
+}
+
+const char* ESP8266_SkipSpaces(const char* str) {
+	/* Skip spaces and tabs */
+	while (*str == ' ' || *str == '\t') {
+		str++;
+	}
+	return str;
+}
+
+uint32_t ESP8266_ParseDecimal(const char** str) {
+	uint32_t num = 0;
+	
+	/* Parse decimal digits */
+	while (**str >= '0' && **str <= '9') {
+		num = 10 * num + (**str - '0');
+		(*str)++;
+	}
+	
+	/* Return number */
+	return num;
+}
+
+char* ESP8266_NumberToString(char* buffer, uint32_t num) {
+	char tmp[10];
+	uint8_t i = 0;
+	
+	/* Get digits in reverse order */
+	do {
+		tmp[i++] = '0' + num % 10;
+		num /= 10;
+	} while (num);
+	
+	/* Copy to buffer */
+	while (i) {
+		*buffer++ = tmp[--i];
+	}
+	*buffer = 0;
+	
+	/* Return pointer to termination */
+	return buffer;
+}
+
+#if ESP8266_USE_DATA_SINK
+ESP8266_Result_t ESP8266_SetDataSink(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, ESP8266_DataSink_t sink) {
+	/* Sink can not be changed in the middle of +IPD packet */
+	if (ESP8266->IPD.InIPD && ESP8266->IPD.ConnNumber == Connection->Number) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_BUSY);
+	}
+	
+	/* Save sink */
+	Connection->DataSink = sink;
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
+#endif
+
+#if ESP8266_USE_PINGPONG_RECEIVE
+ESP8266_Result_t ESP8266_HoldData(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	/* Data can be held only from data received callback */
+	if (!ESP8266->Flags.F.InCallback) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
+	}
+	
+	/* Keep buffer when callback returns */
+	Connection->DataHold = 1;
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
+
+ESP8266_Result_t ESP8266_ReleaseData(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer) {
+	/* Check which half buffer belongs to */
+	if (Buffer == Connection->DataMemory) {
+		Connection->DataHeld &= ~0x01;
+	} else if (Buffer == &Connection->DataMemory[ESP8266_CONNECTION_BUFFER_SIZE / 2]) {
+		Connection->DataHeld &= ~0x02;
+	} else {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
+	}
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
+#endif
+
+ESP8266_Result_t ESP8266_CloseConnection(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	char tmp[30];
+	
+	/* Module is busy or called from callback, close connection from update when module is free */
+	if (ESP8266->ActiveCommand != ESP8266_COMMAND_IDLE || ESP8266->Flags.F.InCallback) {
+		/* Close connection later */
+		Connection->ClosePending = 1;
+		
+		/* Return OK */
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+	}
+	
+	/* Clear pending flag */
+	Connection->ClosePending = 0;
+	
+	/* Format connection */
+	sprintf(tmp, "AT+CIPCLOSE=%d\r\n", Connection->Number);
+	
+	/* Send command */
+	return SendCommand(ESP8266, ESP8266_COMMAND_CLOSE, tmp, "AT+CIPCLOSE");
+}
+
+ESP8266_Result_t ESP8266_CloseAllConnections(ESP8266_t* ESP8266) {
+	/* Send command */
+	return SendCommand(ESP8266, ESP8266_COMMAND_CLOSE, "AT+CIPCLOSE=5\r\n", "AT+CIPCLOSE");
+}
+
+ESP8266_Result_t ESP8266_AllConectionsClosed(ESP8266_t* ESP8266) {
+	uint8_t i;
+	
+	/* Go through all connections */
+	for (i = 0; i < ESP8266_MAX_CONNECTIONS; i++) {
+		/* Check if active */
+		if (ESP8266->Connection[i].Active) {
+			ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
+		}
+	}
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
+
+ESP8266_Result_t ESP8266_SetMux(ESP8266_t* ESP8266, uint8_t mux) {
+	char tmp[30];
+	
+	/* Format command */
+	sprintf(tmp, "AT+CIPMUX=%d\r\n", mux);
+	
+	/* Send command */
+	if (SendCommand(ESP8266, ESP8266_COMMAND_CIPMUX, tmp, "AT+CIPMUX") != ESP_OK) {
+		return ESP8266->Result;
+	}
+	
+	/* Wait till command end */
+	ESP8266_WaitReady(ESP8266);
+	
+	/* Check last status */
+	if (!ESP8266->Flags.F.LastOperationStatus) {
+		/* Return error */
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
+	}
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
+
+ESP8266_Result_t ESP8266_Setdinfo(ESP8266_t* ESP8266, uint8_t info) {
+	char tmp[30];
+	
+	/* Format string */
+	sprintf(tmp, "AT+CIPDINFO=%d\r\n", info);
+	
+	/* Send command and wait */
+	if (SendCommand(ESP8266, ESP8266_COMMAND_CIPDINFO, tmp, "AT+CIPDINFO") != ESP_OK) {
 		return ESP8266->Result;
 	}
+	
+	/* Wait till command end */
+	ESP8266_WaitReady(ESP8266);
+	
+	/* Check last status */
+	if (!ESP8266->Flags.F.LastOperationStatus) {
+		/* Return error */
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
+	}
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
 
+ESP8266_Result_t ESP8266_ServerEnable(ESP8266_t* ESP8266, uint16_t port) {
+	char tmp[30];
+	
+	/* Format string */
+	sprintf(tmp, "AT+CIPSERVER=1,%d\r\n", port);
+	
+	/* Send command and wait */
+	if (SendCommand(ESP8266, ESP8266_COMMAND_CIPSERVER, tmp, "AT+CIPSERVER") != ESP_OK) {
+		return ESP8266->Result;
+	}
+	
 	/* Wait till command end */
 	ESP8266_WaitReady(ESP8266);
+	
+	/* Check last status */
+	if (!ESP8266->Flags.F.LastOperationStatus) {
+		/* Return error */
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
+	}
+	
+	/* Save server port */
+	ESP8266->ServerPort = port;
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
 
+ESP8266_Result_t ESP8266_ServerDisable(ESP8266_t* ESP8266) {
+	/* Send command and wait */
+	if (SendCommand(ESP8266, ESP8266_COMMAND_CIPSERVER, "AT+CIPSERVER=0\r\n", "AT+CIPSERVER") != ESP_OK) {
+		return ESP8266->Result;
+	}
+	
+	/* Wait till command end */
+	ESP8266_WaitReady(ESP8266);
+	
 	/* Check last status */
 	if (!ESP8266->Flags.F.LastOperationStatus) {
 		/* Return error */
 		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
 	}
 	
+	/* Server is not active anymore */
+	ESP8266->ServerPort = 0;
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
+
+ESP8266_Result_t ESP8266_SetServerHandler(ESP8266_t* ESP8266, const ESP8266_Handler_t* Handler) {
+	/* Save handler for next server connections */
+	ESP8266->ServerHandler = Handler;
+	
 	/* Return OK */
 	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
 }
@@ -745,15 +1366,15 @@ ESP8266_Result_t ESP8266_SetServerTimeout(ESP8266_t* ESP8266, uint16_t timeout)
 	
 	/* Format string */
 	sprintf(tmp, "AT+CIPSTO=%d\r\n", timeout);
-
+	
 	/* Send command and wait */
 	if (SendCommand(ESP8266, ESP8266_COMMAND_CIPSTO, tmp, NULL) != ESP_OK) {
 		return ESP8266->Result;
 	}
-
+	
 	/* Wait till command end */
 	ESP8266_WaitReady(ESP8266);
-
+	
 	/* Check last status */
 	if (!ESP8266->Flags.F.LastOperationStatus) {
 		/* Return error */
@@ -809,7 +1430,7 @@ ESP8266_Result_t ESP8266_GetSTAIPBlocking(ESP8266_t* ESP8266) {
 	if (ESP8266_GetSTAIP(ESP8266) != ESP_OK) {
 	
 	}
-
+	
 	/* Wait till command end */
 	ESP8266_WaitReady(ESP8266);
 	
@@ -822,7 +1443,7 @@ ESP8266_Result_t ESP8266_GetAPIPBlocking(ESP8266_t* ESP8266) {
 	if (ESP8266_GetAPIP(ESP8266) != ESP_OK) {
 	
 	}
-
+	
 	/* Wait till command end */
 	return ESP8266_WaitReady(ESP8266);
 }
@@ -1027,6 +1648,49 @@ ESP8266_Result_t ESP8266_GetConnectedStations(ESP8266_t* ESP8266) {
 /*               TCP CLIENT               */
 /******************************************/
 ESP8266_Result_t ESP8266_StartClientConnection(ESP8266_t* ESP8266, char* name, char* location, uint16_t port, void* user_parameters) {
+	/* Start TCP connection */
+	return StartConnection(ESP8266, "TCP", name, location, port, 0, 0, user_parameters);
+}
+
+/******************************************/
+/*                UDP LINK                */
+/******************************************/
+ESP8266_Result_t ESP8266_StartUDPConnection(ESP8266_t* ESP8266, char* name, char* location, uint16_t port, uint16_t local_port, ESP8266_UDPMode_t mode, void* user_parameters) {
+	/* Start UDP link */
+	return StartConnection(ESP8266, "UDP", name, location, port, local_port, mode, user_parameters);
+}
+
+ESP8266_Result_t ESP8266_RequestSendDatagram(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const void* data, uint16_t length, const uint8_t* ip, uint16_t port) {
+	/* Check connection */
+	if (!Connection->Active) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_LINKNOTVALID);
+	}
+	
+	/* Datagram must fit to single AT+CIPSEND cycle on UDP link */
+	if (!Connection->Udp || length > ESP8266_SEND_CHUNK_SIZE) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
+	}
+	
+	/* Check if connection is already sending */
+	if (Connection->SendRequest || Connection->SendLength) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_BUSY);
+	}
+	
+	/* Save remote address, it is added to AT+CIPSEND command */
+	if (ip != NULL) {
+		memcpy(Connection->SendIP, ip, 4);
+		Connection->SendPort = port;
+	} else {
+		Connection->SendPort = 0;
+	}
+	
+	/* Send datagram directly from user memory */
+	Connection->SendDatagram.Data = data;
+	Connection->SendDatagram.Length = length;
+	return ESP8266_RequestSendSegments(ESP8266, Connection, &Connection->SendDatagram, 1);
+}
+
+static ESP8266_Result_t StartConnection(ESP8266_t* ESP8266, const char* type, char* name, char* location, uint16_t port, uint16_t local_port, uint8_t mode, void* user_parameters) {
 	int8_t conn = -1;
 	uint8_t i = 0;
 	
@@ -1049,8 +1713,12 @@ ESP8266_Result_t ESP8266_StartClientConnection(ESP8266_t* ESP8266, char* name, c
 	/* Try it */
 	if (conn != -1) {
 		char tmp[100];
-		/* Format command */
-		sprintf(tmp, "AT+CIPSTART=%d,\"TCP\",\"%s\",%d\r\n", conn, location, port);
+		/* Format command, UDP link can have local port and mode */
+		if (local_port) {
+			sprintf(tmp, "AT+CIPSTART=%d,\"%s\",\"%s\",%d,%d,%d\r\n", conn, type, location, port, local_port, mode);
+		} else {
+			sprintf(tmp, "AT+CIPSTART=%d,\"%s\",\"%s\",%d\r\n", conn, type, location, port);
+		}
 		
 		/* Send command */
 		if (SendCommand(ESP8266, ESP8266_COMMAND_CIPSTART, tmp, NULL) != ESP_OK) {
@@ -1060,9 +1728,10 @@ ESP8266_Result_t ESP8266_StartClientConnection(ESP8266_t* ESP8266, char* name, c
 		/* We are active now as client */
 		ESP8266->Connection[i].Active = 1;
 		ESP8266->Connection[i].Client = 1;
+		ESP8266->Connection[i].Udp = type[0] == 'U';
 		ESP8266->Connection[i].TotalBytesReceived = 0;
 		ESP8266->Connection[i].Number = conn;
-#if ESP8266_USE_SINGLE_CONNECTION_BUFFER == 1
+#if ESP8266_USE_SINGLE_CONNECTION_BUFFER == 1 && !ESP8266_USE_BUFFER_POOL && !ESP8266_USE_PINGPONG_RECEIVE
 		ESP8266->Connection[i].Data = ConnectionData;
 #endif
 		ESP8266->StartConnectionSent = i;
@@ -1070,6 +1739,7 @@ ESP8266_Result_t ESP8266_StartClientConnection(ESP8266_t* ESP8266, char* name, c
 		/* Copy values */
 		strncpy(ESP8266->Connection[i].Name, name, sizeof(ESP8266->Connection[i].Name));
 		ESP8266->Connection[i].UserParameters = user_parameters;
+		ESP8266->Connection[i].Handler = NULL;
 		
 		/* Return OK */
 		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
@@ -1080,39 +1750,210 @@ ESP8266_Result_t ESP8266_StartClientConnection(ESP8266_t* ESP8266, char* name, c
 }
 
 /******************************************/
-/*              PING SUPPORT              */
+/*        TRANSPARENT MODE SUPPORT        */
 /******************************************/
-#if ESP8266_USE_PING
-ESP8266_Result_t ESP8266_Ping(ESP8266_t* ESP8266, char* addr) {
-	char tmp[100];
+#if ESP8266_USE_TRANSPARENT
+ESP8266_Result_t ESP8266_TransparentStart(ESP8266_t* ESP8266, char* location, uint16_t port) {
+	uint8_t i;
 	
-	/* Check idle */
+	/* Check if IDLE */
 	ESP8266_CHECK_IDLE(ESP8266);
 	
-	/* Device must be connected to wifi */
+	/* Check if connected to network */
 	ESP8266_CHECK_WIFICONNECTED(ESP8266);
 	
-	/* Save ping address information */
-	strcpy(ESP8266->PING.Address, addr);
+	/* All connections must be closed */
+	for (i = 0; i < ESP8266_MAX_CONNECTIONS; i++) {
+		if (ESP8266->Connection[i].Active) {
+			ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
+		}
+	}
 	
-	/* Format command for pinging */
-	sprintf(tmp, "AT+PING=\"%s\"\r\n", addr);
+	/* Save server, connection is started after module is in single connection mode */
+	ESP8266->TransparentLocation = location;
+	ESP8266->TransparentPort = port;
 	
-	/* Reset flag */
-	ESP8266->PING.Success = 0;
+	/* Disable server first, single connection mode is not possible when server is active */
+	TransparentStep(ESP8266, ESP8266->ServerPort ? ESP8266_TRANSPARENT_SERVER_OFF : ESP8266_TRANSPARENT_MUX_OFF);
 	
-	/* Send command */
-	if (SendCommand(ESP8266, ESP8266_COMMAND_PING, tmp, "+") == ESP_OK) {
-		/* Call user function */
-		ESP8266_Callback_PingStarted(ESP8266, addr);
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
+
+ESP8266_Result_t ESP8266_TransparentSend(ESP8266_t* ESP8266, const void* data, uint16_t length) {
+	/* Check mode */
+	if (ESP8266->ActiveCommand != ESP8266_COMMAND_TRANSPARENT) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP_ERROR);
 	}
 	
-	/* Return status */
-	return ESP8266->Result;
+	/* Send data directly */
+	ESP8266_LL_USARTSend((uint8_t *)data, length);
+	
+	/* Increase number of bytes sent and save time of activity */
+	ESP8266->TotalBytesSent += length;
+	ESP8266->StartTime = ESP8266->Time;
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
 }
-#endif
 
-uint16_t ESP8266_DataReceived(uint8_t* ch, uint16_t count) {
+ESP8266_Result_t ESP8266_TransparentStop(ESP8266_t* ESP8266) {
+	/* Start or stop is already in progress */
+	if (ESP8266->TransparentState != ESP8266_TRANSPARENT_DATA) {
+		ESP8266_RETURNWITHSTATUS(ESP8266, ESP8266->TransparentState == ESP8266_TRANSPARENT_NONE ? ESP_OK : ESP_BUSY);
+	}
+	
+	/* Wait guard time before "+++" sequence, received data are still passed to user */
+	TransparentStep(ESP8266, ESP8266_TRANSPARENT_GUARD);
+	
+	/* Return OK */
+	ESP8266_RETURNWITHSTATUS(ESP8266, ESP_OK);
+}
+
+static void TransparentReceive(ESP8266_t* ESP8266) {
+	uint8_t Received[256];
+	uint16_t length;
+	
+	/* Everything received are raw data for user */
+	while ((length = BUFFER_Read(&USART_Buffer, Received, sizeof(Received))) > 0) {
+		/* Increase number of bytes received */
+		ESP8266->TotalBytesReceived += length;
+		
+		/* Save time of activity, during escape sequence time is used for guard time */
+		if (ESP8266->ActiveCommand == ESP8266_COMMAND_TRANSPARENT) {
+			ESP8266->StartTime = ESP8266->Time;
+		}
+		
+		/* Call user function */
+		ESP8266_Callback_TransparentDataReceived(ESP8266, Received, length);
+	}
+}
+
+static void TransparentSchedule(ESP8266_t* ESP8266) {
+	uint8_t step = ESP8266->TransparentState;
+	
+	/* Previous step must be finished, commands can not be sent from callbacks */
+	if (
+		step == ESP8266_TRANSPARENT_NONE ||
+		ESP8266->ActiveCommand != ESP8266_COMMAND_IDLE ||
+		ESP8266->Flags.F.InCallback
+	) {
+		return;
+	}
+	
+	/* Failed start step leaves transparent mode the same way as stop */
+	if (step < ESP8266_TRANSPARENT_DATA && !ESP8266->Flags.F.LastOperationStatus) {
+		TransparentStep(ESP8266, ESP8266_TRANSPARENT_MODE_OFF);
+		return;
+	}
+	
+	/* Go to next step, steps of stop are done even if previous step failed */
+	if (step == ESP8266_TRANSPARENT_SEND) {
+		/* Module did not send ">" before timeout */
+		TransparentStep(ESP8266, ESP8266_TRANSPARENT_MODE_OFF);
+	} else if (step == ESP8266_TRANSPARENT_SERVER_ON || (step == ESP8266_TRANSPARENT_MUX_ON && !ESP8266->ServerPort)) {
+		/* Server could not be enabled again */
+		if (step == ESP8266_TRANSPARENT_SERVER_ON && !ESP8266->Flags.F.LastOperationStatus) {
+			ESP8266->ServerPort = 0;
+		}
+		
+		/* Back in multiple connections mode */
+		ESP8266->TransparentState = ESP8266_TRANSPARENT_NONE;
+		
+		/* Call user function */
+		ESP8266_Callback_TransparentClosed(ESP8266);
+	} else {
+		TransparentStep(ESP8266, step + 1);
+	}
+}
+
+static void TransparentStep(ESP8266_t* ESP8266, uint8_t step) {
+	char tmp[100];
+	
+	/* Save step and reset status of previous command */
+	ESP8266->TransparentState = step;
+	ESP8266->Flags.F.LastOperationStatus = 0;
+	
+	/* Send command of step */
+	switch (step) {
+		case ESP8266_TRANSPARENT_SERVER_OFF:
+			SendCommand(ESP8266, ESP8266_COMMAND_CIPSERVER, "AT+CIPSERVER=0\r\n", "AT+CIPSERVER");
+			break;
+		case ESP8266_TRANSPARENT_MUX_OFF:
+			SendCommand(ESP8266, ESP8266_COMMAND_CIPMUX, "AT+CIPMUX=0\r\n", "AT+CIPMUX");
+			break;
+		case ESP8266_TRANSPARENT_MODE_ON:
+			SendCommand(ESP8266, ESP8266_COMMAND_CIPMODE, "AT+CIPMODE=1\r\n", "AT+CIPMODE");
+			break;
+		case ESP8266_TRANSPARENT_CONNECT:
+			sprintf(tmp, "AT+CIPSTART=\"TCP\",\"%s\",%d\r\n", ESP8266->TransparentLocation, ESP8266->TransparentPort);
+			SendCommand(ESP8266, ESP8266_COMMAND_TCIPSTART, tmp, "AT+CIPSTART");
+			break;
+		case ESP8266_TRANSPARENT_SEND:
+			/* Module returns "OK" and ">" after it */
+			ESP8266->Flags.F.WaitForWrapper = 0;
+			SendCommand(ESP8266, ESP8266_COMMAND_TCIPSEND, "AT+CIPSEND\r\n", "AT+CIPSEND");
+			break;
+		case ESP8266_TRANSPARENT_GUARD:
+			/* Guard time is timed from update, nothing is sent to module */
+			ESP8266->ActiveCommand = ESP8266_COMMAND_TESCAPE;
+			ESP8266->StartTime = ESP8266->Time;
+			break;
+		case ESP8266_TRANSPARENT_MODE_OFF:
+			SendCommand(ESP8266, ESP8266_COMMAND_CIPMODE, "AT+CIPMODE=0\r\n", "AT+CIPMODE");
+			break;
+		case ESP8266_TRANSPARENT_CLOSE:
+			/* Connection may be already closed */
+			SendCommand(ESP8266, ESP8266_COMMAND_CLOSE, "AT+CIPCLOSE\r\n", "AT+CIPCLOSE");
+			break;
+		case ESP8266_TRANSPARENT_MUX_ON:
+			SendCommand(ESP8266, ESP8266_COMMAND_CIPMUX, "AT+CIPMUX=1\r\n", "AT+CIPMUX");
+			break;
+		case ESP8266_TRANSPARENT_SERVER_ON:
+			/* Server is enabled again on every exit path */
+			sprintf(tmp, "AT+CIPSERVER=1,%d\r\n", ESP8266->ServerPort);
+			SendCommand(ESP8266, ESP8266_COMMAND_CIPSERVER, tmp, "AT+CIPSERVER");
+			break;
+		default:
+			break;
+	}
+}
+#endif
+
+/******************************************/
+/*              PING SUPPORT              */
+/******************************************/
+#if ESP8266_USE_PING
+ESP8266_Result_t ESP8266_Ping(ESP8266_t* ESP8266, char* addr) {
+	char tmp[100];
+	
+	/* Check idle */
+	ESP8266_CHECK_IDLE(ESP8266);
+	
+	/* Device must be connected to wifi */
+	ESP8266_CHECK_WIFICONNECTED(ESP8266);
+	
+	/* Save ping address information */
+	strcpy(ESP8266->PING.Address, addr);
+	
+	/* Format command for pinging */
+	sprintf(tmp, "AT+PING=\"%s\"\r\n", addr);
+	
+	/* Reset flag */
+	ESP8266->PING.Success = 0;
+	
+	/* Send command */
+	if (SendCommand(ESP8266, ESP8266_COMMAND_PING, tmp, "+") == ESP_OK) {
+		/* Call user function */
+		ESP8266_Callback_PingStarted(ESP8266, addr);
+	}
+	
+	/* Return status */
+	return ESP8266->Result;
+}
+#endif
+
+uint16_t ESP8266_DataReceived(uint8_t* ch, uint16_t count) {
 	/* Writes data to USART buffer */
 	return BUFFER_Write(&USART_Buffer, ch, count);
 }
@@ -1273,6 +2114,15 @@ __weak void ESP8266_Callback_ClientConnectionError(ESP8266_t* ESP8266, ESP8266_C
 	*/
 }
 
+#if ESP8266_USE_BUFFER_POOL
+/* Called when received data were dropped because buffer pool was full */
+__weak void ESP8266_Callback_ConnectionDataLost(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	/* NOTE: This function Should not be modified, when the callback is needed,
+           the ESP8266_Callback_ConnectionDataLost could be implemented in the user file
+	*/
+}
+#endif
+
 /* Called when timeout is reached on AT+CIPSTART command */
 __weak void ESP8266_Callback_ClientConnectionTimeout(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
 	/* NOTE: This function Should not be modified, when the callback is needed,
@@ -1303,6 +2153,36 @@ __weak void ESP8266_Callback_PingFinished(ESP8266_t* ESP8266, ESP8266_Ping_t* PI
 }
 #endif
 
+#if ESP8266_USE_TRANSPARENT
+/* Called when raw data are received in transparent mode */
+__weak void ESP8266_Callback_TransparentDataReceived(ESP8266_t* ESP8266, uint8_t* Buffer, uint16_t length) {
+	/* NOTE: This function Should not be modified, when the callback is needed,
+           the ESP8266_Callback_TransparentDataReceived could be implemented in the user file
+	*/
+}
+
+/* Called when transparent mode was left because of inactivity */
+__weak void ESP8266_Callback_TransparentTimeout(ESP8266_t* ESP8266) {
+	/* NOTE: This function Should not be modified, when the callback is needed,
+           the ESP8266_Callback_TransparentTimeout could be implemented in the user file
+	*/
+}
+
+/* Called when transparent mode is active */
+__weak void ESP8266_Callback_TransparentConnected(ESP8266_t* ESP8266) {
+	/* NOTE: This function Should not be modified, when the callback is needed,
+           the ESP8266_Callback_TransparentConnected could be implemented in the user file
+	*/
+}
+
+/* Called when transparent mode was left or could not be started */
+__weak void ESP8266_Callback_TransparentClosed(ESP8266_t* ESP8266) {
+	/* NOTE: This function Should not be modified, when the callback is needed,
+           the ESP8266_Callback_TransparentClosed could be implemented in the user file
+	*/
+}
+#endif
+
 #if ESP8266_USE_FIRMWAREUPDATE
 /* Called on status messages for network firmware update */
 __weak void ESP8266_Callback_FirmwareUpdateStatus(ESP8266_t* ESP8266, ESP8266_FirmwareUpdate_t status) {
@@ -1746,7 +2626,7 @@ static void ParseMAC(char* ptr, uint8_t* arr, uint8_t* cnt) {
 	
 	/* Get token */
 	hexptr = strtok(ptr, ":");
-
+	
 	/* Do it till NULL */
 	while (hexptr != NULL) {
 		/* Parse hex */
@@ -1793,10 +2673,16 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 		if (
 			strcmp(Received, "OK\r\n") != 0 &&
 			strcmp(Received, "SEND OK\r\n") != 0 &&
+			strcmp(Received, "SEND FAIL\r\n") != 0 &&
 			strcmp(Received, "ERROR\r\n") != 0 &&
 			strcmp(Received, "ready\r\n") != 0 &&
 			strcmp(Received, "busy p...\r\n") != 0 &&
 			strncmp(Received, "+IPD:", 4) != 0 &&
+#if ESP8266_USE_SENDBUF
+			strstr(Received, ",SEND OK\r\n") == NULL &&                                     /*!< Buffered segment acknowledge */
+			strstr(Received, ",SEND FAIL\r\n") == NULL &&
+			!(ESP8266->ActiveCommand == ESP8266_COMMAND_SEND && CHARISNUM(Received[0])) && /*!< Segment ID on AT+CIPSENDBUF */
+#endif
 			strncmp(Received, ESP8266->ActiveCommandResponse[0], strlen(ESP8266->ActiveCommandResponse[0])) != 0
 		) {
 			/* Save string to temporary buffer, because we received a string which does not belong to this command */
@@ -1848,90 +2734,71 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 		ESP8266_Callback_WifiGotIP(ESP8266);
 	}
 			
+#if ESP8266_USE_SENDBUF
+	/* Buffered segment was acknowledged, format is "<link ID>,<segment ID>,SEND OK" */
+	if (CHARISNUM(Received[0]) && strstr(Received, ",SEND OK\r\n") != NULL) {
+		SendBufAcknowledged(ESP8266, Received, 1);
+	} else if (CHARISNUM(Received[0]) && strstr(Received, ",SEND FAIL\r\n") != NULL) {
+		SendBufAcknowledged(ESP8266, Received, 0);
+	}
+#endif
+	
 	/* In case data were send */
-	if (strstr(Received, "SEND OK\r\n") != NULL) {
-		uint8_t cnt;
-		
+	if (!CHARISNUM(Received[0]) && strstr(Received, "SEND OK\r\n") != NULL) {
 		/* Reset active command so user will be able to call new command in callback function */
 		ESP8266->ActiveCommand = ESP8266_COMMAND_IDLE;
 		
-		for (cnt = 0; cnt < ESP8266_MAX_CONNECTIONS; cnt++) {
-			/* Check for data sent */
-			if (ESP8266->Connection[cnt].WaitingSentRespond) {
-				/* Reset flag */
-				ESP8266->Connection[cnt].WaitingSentRespond = 0;
-				
-				/* Call user function according to connection type */
-				if (ESP8266->Connection[cnt].Client) {
-					/* Client mode */
-					ESP8266_Callback_ClientConnectionDataSent(ESP8266, &ESP8266->Connection[cnt]);
-				} else {
-					/* Server mode */
-					ESP8266_Callback_ServerConnectionDataSent(ESP8266, &ESP8266->Connection[cnt]);
-				}
-			}
-		}
+		/* Force IDLE when we are in SEND mode and SEND OK is returned. Do not wait for "> " wrapper */
+		ESP8266->Flags.F.WaitForWrapper = 0;
+		
+		/* Process connection which sent data, next chunk of stream may be started here */
+		SendDataCompleted(ESP8266, 1);
+	} else if (strcmp(Received, "SEND FAIL\r\n") == 0) {
+		/* Reset active command */
+		ESP8266->ActiveCommand = ESP8266_COMMAND_IDLE;
+		ESP8266->Flags.F.WaitForWrapper = 0;
+		
+		/* Data were not sent */
+		SendDataCompleted(ESP8266, 0);
 	}
 	
+#if ESP8266_USE_PASSIVE_RECEIVE
+	/* In passive mode, module only notifies "+IPD,<link ID>,<len>" without data */
+	if (strncmp(Received, "+IPD,", 5) == 0 && strchr(Received, ':') == NULL) {
+		if (CHAR2NUM(Received[5]) < ESP8266_MAX_CONNECTIONS) {
+			/* Save number of bytes available in module */
+			ESP8266->Connection[CHAR2NUM(Received[5])].DataAvailable += ParseNumber(&Received[7], NULL);
+		}
+	} else
+#endif
 	/* Check if +IPD was received with incoming data */
-	if (strncmp(Received, "+IPD", 4) == 0) {		
-		/* If we are not in IPD mode already */
-		/* Go to IPD mode */
-		ESP8266->IPD.InIPD = 1;
-		ESP8266->IPD.USART_Buffer = from_usart_buffer;
+	if (strncmp(Received, "+IPD", 4) == 0) {
+		uint8_t number;
+		uint32_t length;
 		
 		/* Reset pointer */
 		ipd_ptr = 5;
 		
 		/* Get connection number from IPD statement */
-		ESP8266->IPD.ConnNumber = CHAR2NUM(Received[ipd_ptr]);
-		
-		/* Set working buffer for this connection */
-#if ESP8266_USE_SINGLE_CONNECTION_BUFFER == 1
-		ESP8266->Connection[ESP8266->IPD.ConnNumber].Data = ConnectionData;
-#endif
-		
-		/* Save connection number */
-		ESP8266->Connection[ESP8266->IPD.ConnNumber].Number = ESP8266->IPD.ConnNumber;
+		number = CHAR2NUM(Received[ipd_ptr]);
 		
 		/* Increase pointer by 2 */
 		ipd_ptr += 2;
 		
 		/* Save number of received bytes */
-		ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived = ParseNumber(&Received[ipd_ptr], &bytes_cnt);
-		
-		/* First time */
-		if (ESP8266->Connection[ESP8266->IPD.ConnNumber].TotalBytesReceived == 0) {
-			/* Reset flag */
-			ESP8266->Connection[ESP8266->IPD.ConnNumber].HeadersDone = 0;
-			
-			/* This is first packet of data */
-			ESP8266->Connection[ESP8266->IPD.ConnNumber].FirstPacket = 1;
-		} else {
-			/* This is not first packet */
-			ESP8266->Connection[ESP8266->IPD.ConnNumber].FirstPacket = 0;
-		}
-		
-		/* Save total number of bytes */
-		ESP8266->Connection[ESP8266->IPD.ConnNumber].TotalBytesReceived += ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived;
-		
-		/* Increase global number of bytes received from ESP8266 module to stack */
-		ESP8266->TotalBytesReceived += ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived;
+		length = ParseNumber(&Received[ipd_ptr], &bytes_cnt);
 		
 		/* Increase pointer for number of characters for number and for comma */
 		ipd_ptr += bytes_cnt + 1;
 		
 		/* Save IP */
-		ParseIP(&Received[ipd_ptr], ESP8266->Connection[ESP8266->IPD.ConnNumber].RemoteIP, &bytes_cnt);
+		ParseIP(&Received[ipd_ptr], ESP8266->Connection[number].RemoteIP, &bytes_cnt);
 		
 		/* Increase pointer for number of characters for IP string and for comma */
 		ipd_ptr += bytes_cnt + 1;
 		
 		/* Save PORT */
-		ESP8266->Connection[ESP8266->IPD.ConnNumber].RemotePort = ParseNumber(&Received[ipd_ptr], &bytes_cnt);
-		
-		/* Increase pointer */
-		ipd_ptr += bytes_cnt + 1;
+		ESP8266->Connection[number].RemotePort = ParseNumber(&Received[ipd_ptr], &bytes_cnt);
 		
 		/* Find : element where real data starts */
 		ipd_ptr = 0;
@@ -1940,31 +2807,34 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 		}
 		ipd_ptr++;
 		
-		/* Copy content to beginning of buffer */
-		memcpy((uint8_t *)ESP8266->Connection[ESP8266->IPD.ConnNumber].Data, (uint8_t *)&Received[ipd_ptr], bufflen - ipd_ptr);
+		/* Start receiving data */
+		StartIPD(ESP8266, number, length, Received, ipd_ptr, bufflen, from_usart_buffer);
+	}
+	
+#if ESP8266_USE_PASSIVE_RECEIVE
+	/* Data read with AT+CIPRECVDATA, format is "+CIPRECVDATA,<len>:<data>" */
+	if (
+		strncmp(Received, "+CIPRECVDATA,", 13) == 0 &&
+		ESP8266->ActiveCommand == ESP8266_COMMAND_CIPRECVDATA &&
+		ESP8266->ReceiveDataConnection != NULL &&
+		(ch_ptr = strchr(Received, ':')) != NULL
+	) {
+		uint32_t length = ParseNumber(&Received[13], NULL);
+		Conn = ESP8266->ReceiveDataConnection;
 		
-		/* Check for length */
-		if ((bufflen - ipd_ptr) > ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived) {
-			/* Add zero at the end of string */
-			ESP8266->Connection[ESP8266->IPD.ConnNumber].Data[ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived] = 0;
+		/* Module returned less than requested, nothing more is available */
+		if (length < ESP8266->ReceiveDataLength || length > Conn->DataAvailable) {
+			Conn->DataAvailable = 0;
+		} else {
+			Conn->DataAvailable -= length;
 		}
 		
-		/* Calculate remaining bytes */
-		ESP8266->IPD.InPtr = ESP8266->IPD.PtrTotal = bufflen - ipd_ptr;
-		
-		/* Check remaining data */
-		if (ipd_ptr >= ESP8266->Connection[ESP8266->IPD.ConnNumber].BytesReceived) {
-			/* Not in IPD anymore */
-			ESP8266->IPD.InIPD = 0;
-			
-			/* Set package data size */
-			ESP8266->Connection[ESP8266->IPD.ConnNumber].DataSize = ipd_ptr;
-			ESP8266->Connection[ESP8266->IPD.ConnNumber].LastPart = 1;
-			
-			/* Enable flag to call received data callback */
-			ESP8266->Connection[ESP8266->IPD.ConnNumber].CallDataReceived = 1;
+		/* Start receiving data */
+		if (length) {
+			StartIPD(ESP8266, Conn->Number, length, Received, (ch_ptr - Received) + 1, bufflen, from_usart_buffer);
 		}
 	}
+#endif
 	
 	/* Check if we have a new connection */
 	if ((ch_ptr = (char *)mem_mem(Received, bufflen, ",CONNECT\r\n", 10)) != NULL) {
@@ -1972,6 +2842,24 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 		Conn = &ESP8266->Connection[CHAR2NUM(*(ch_ptr - 1))];
 		Conn->Active = 1;
 		Conn->Number = CHAR2NUM(*(ch_ptr - 1));
+		Conn->TotalBytesReceived = 0;
+		
+#if ESP8266_USE_DATA_SINK
+		/* New connection receives to buffer until sink is set */
+		Conn->DataSink = NULL;
+#endif
+		
+#if ESP8266_USE_PINGPONG_RECEIVE
+		/* Both buffer halves are free */
+		Conn->DataHeld = 0;
+		Conn->DataHold = 0;
+#endif
+		
+#if ESP8266_USE_RECEIVE_STREAM
+		/* Start with empty receive stream */
+		BUFFER_Init(&Conn->ReceiveStream, sizeof(Conn->ReceiveStreamData), Conn->ReceiveStreamData);
+		Conn->ReceiveStreamDropped = 0;
+#endif
 		
 		/* Call user function according to connection type (client, server) */
 		if (Conn->Client) {			
@@ -1981,10 +2869,21 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 			}
 			
 			/* Connection started as client */
-			ESP8266_Callback_ClientConnectionConnected(ESP8266, Conn);
+			if (Conn->Handler != NULL) {
+				ESP8266_CALLHANDLER(ESP8266, Conn, Connected, (ESP8266, Conn));
+			} else {
+				ESP8266_Callback_ClientConnectionConnected(ESP8266, Conn);
+			}
 		} else {
+			/* Server connections use server handler when set */
+			Conn->Handler = ESP8266->ServerHandler;
+			
 			/* Connection started as server */
-			ESP8266_Callback_ServerConnectionActive(ESP8266, Conn);
+			if (Conn->Handler != NULL) {
+				ESP8266_CALLHANDLER(ESP8266, Conn, Connected, (ESP8266, Conn));
+			} else {
+				ESP8266_Callback_ServerConnectionActive(ESP8266, Conn);
+			}
 		}
 	}
 	
@@ -2005,12 +2904,47 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 			client = ESP8266->Connection[CHAR2NUM(*(ch_ptr - 1))].Client;
 			active = ESP8266->Connection[CHAR2NUM(*(ch_ptr - 1))].Active;
 			
+			/* Queued requests will not be sent anymore */
+			Conn = &ESP8266->Connection[CHAR2NUM(*(ch_ptr - 1))];
+#if ESP8266_USE_SENDBUF
+			/* Buffered segments will not be acknowledged anymore */
+			Conn->SendBufCount = 0;
+#endif
+			if ((Conn->SendRequest || Conn->SendLength) && Conn != ESP8266->SendDataConnection) {
+				SendDataFinished(ESP8266, Conn, 0);
+			}
+			
 			/* Connection closed, reset flags now */
 			ESP8266_RESETCONNECTION(ESP8266, &ESP8266->Connection[CHAR2NUM(*(ch_ptr - 1))]);
 			
+#if ESP8266_USE_PASSIVE_RECEIVE
+			/* Data in module are lost */
+			Conn->DataAvailable = 0;
+			Conn->ReceiveHold = 0;
+#endif
+			
+#if ESP8266_USE_BUFFER_POOL
+			/* Return blocks to pool, rest of unfinished packet is dropped because connection has no buffer */
+			BufferPoolFree(ESP8266, Conn);
+			Conn->DataLost = 0;
+#endif
+			
+#if ESP8266_USE_WRITEBUFFER
+			/* Drop written data if buffer is not flushing now */
+			Conn = &ESP8266->Connection[CHAR2NUM(*(ch_ptr - 1))];
+			if (!Conn->WriteFlushing) {
+				Conn->WriteLength = 0;
+				Conn->WriteRecords = 0;
+			}
+			Conn->WriteFlushRequest = 0;
+#endif
+			
 			/* Call user function */
 			if (active) {
-				if (client) {
+				if (ESP8266->Connection[CHAR2NUM(*(ch_ptr - 1))].Handler != NULL) {
+					/* Protocol handler */
+					ESP8266_CALLHANDLER(ESP8266, Conn, Closed, (ESP8266, Conn));
+				} else if (client) {
 					/* Client connection closed */
 					ESP8266_Callback_ClientConnectionClosed(ESP8266, &ESP8266->Connection[CHAR2NUM(*(ch_ptr - 1))]);
 				} else {
@@ -2026,20 +2960,27 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 	
 	/* Check if we have a new connection */
 	if ((ch_ptr = strstr(Received, ",CONNECT FAIL\r\n")) != NULL) {
+		uint8_t client;
+		
 		/* New connection has been made */
 		Conn = &ESP8266->Connection[CHAR2NUM(*(ch_ptr - 1))];
+		client = Conn->Client;
 		ESP8266_RESETCONNECTION(ESP8266, Conn);
 		Conn->Number = CHAR2NUM(*(ch_ptr - 1));
 		
 		/* Call user function according to connection type (client, server) */
-		if (Conn->Client) {
+		if (client) {
 			/* Reset current connection */
 			if (ESP8266->ActiveCommand == ESP8266_COMMAND_CIPSTART) {
 				ESP8266->ActiveCommand = ESP8266_COMMAND_IDLE;
 			}
 			
 			/* Connection failed */
-			ESP8266_Callback_ClientConnectionError(ESP8266, Conn);
+			if (Conn->Handler != NULL) {
+				ESP8266_CALLHANDLER(ESP8266, Conn, Error, (ESP8266, Conn));
+			} else {
+				ESP8266_Callback_ClientConnectionError(ESP8266, Conn);
+			}
 		}
 	}
 	
@@ -2156,6 +3097,23 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 			}
 			break;
 		case ESP8266_COMMAND_SEND:
+			if (strcmp(Received, "ERROR\r\n") == 0) {
+				/* Reset active command */
+				ESP8266->ActiveCommand = ESP8266_COMMAND_IDLE;
+				ESP8266->Flags.F.WaitForWrapper = 0;
+				
+				/* Module did not accept send command */
+				SendDataCompleted(ESP8266, 0);
+			}
+#if ESP8266_USE_SENDBUF
+			/* AT+CIPSENDBUF returns "<current segment ID>,<last acknowledged segment ID>" */
+			if (
+				CHARISNUM(Received[0]) && ESP8266->SendDataConnection != NULL &&
+				(ch_ptr = strchr(Received, ',')) != NULL && CHARISNUM(*(ch_ptr + 1))
+			) {
+				ESP8266->SendDataConnection->SendBufID = ParseNumber(Received, NULL);
+			}
+#endif
 			if (strcmp(Received, "OK\r\n") == 0) {
 				/* Reset active command */
 				ESP8266->ActiveCommand = ESP8266_COMMAND_SENDDATA;
@@ -2165,9 +3123,29 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 				
 				/* We are now waiting for SEND OK */
 				strcpy(ESP8266->ActiveCommandResponse[0], "SEND OK");
+#if ESP8266_USE_SENDBUF
+				/* Buffered send is done when module receives data */
+				if (ESP8266->SendDataConnection != NULL && ESP8266->SendDataConnection->SendLength && !ESP8266->SendDataConnection->Udp) {
+					strcpy(ESP8266->ActiveCommandResponse[0], "Recv ");
+				}
+#endif
 			}
 			break;
 		case ESP8266_COMMAND_SENDDATA:
+#if ESP8266_USE_SENDBUF
+			if (strncmp(Received, "Recv ", 5) == 0 && ESP8266->SendDataConnection != NULL && ESP8266->SendDataConnection->SendLength && !ESP8266->SendDataConnection->Udp) {
+				/* Module has data in buffer, we do not need to wait for "SEND OK" */
+				SendBufAccepted(ESP8266);
+			}
+#endif
+			if (strcmp(Received, "ERROR\r\n") == 0) {
+				/* Reset active command */
+				ESP8266->ActiveCommand = ESP8266_COMMAND_IDLE;
+				ESP8266->Flags.F.WaitForWrapper = 0;
+				
+				/* Module did not accept data */
+				SendDataCompleted(ESP8266, 0);
+			}
 			break;
 		case ESP8266_COMMAND_CIPSTART:
 			if (strcmp(Received, "OK\r\n") == 0) {
@@ -2182,7 +3160,11 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 				ESP8266_RESETCONNECTION(ESP8266, &ESP8266->Connection[ESP8266->StartConnectionSent]);
 				
 				/* Call user function */
-				ESP8266_Callback_ClientConnectionError(ESP8266, &ESP8266->Connection[ESP8266->StartConnectionSent]);
+				if (ESP8266->Connection[ESP8266->StartConnectionSent].Handler != NULL) {
+					ESP8266_CALLHANDLER(ESP8266, &ESP8266->Connection[ESP8266->StartConnectionSent], Error, (ESP8266, &ESP8266->Connection[ESP8266->StartConnectionSent]));
+				} else {
+					ESP8266_Callback_ClientConnectionError(ESP8266, &ESP8266->Connection[ESP8266->StartConnectionSent]);
+				}
 			}
 			break;
 		case ESP8266_COMMAND_CIPMUX:
@@ -2194,11 +3176,30 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 		case ESP8266_COMMAND_GSLP:
 		case ESP8266_COMMAND_CIPSTO:
 		case ESP8266_COMMAND_RESTORE:
+#if ESP8266_USE_TRANSPARENT
+		case ESP8266_COMMAND_CIPMODE:
+		case ESP8266_COMMAND_TCIPSTART:
+#endif
+#if ESP8266_USE_PASSIVE_RECEIVE
+		case ESP8266_COMMAND_CIPRECVMODE:
+#endif
 			if (strcmp(Received, "OK\r\n") == 0) {
 				/* Reset active command */
 				ESP8266->ActiveCommand = ESP8266_COMMAND_IDLE;
 			}
 			break;
+#if ESP8266_USE_TRANSPARENT
+		case ESP8266_COMMAND_TCIPSEND:
+			if (strcmp(Received, "OK\r\n") == 0) {
+				/* Do not reset command, wait for ">" wrapper */
+				ESP8266->Flags.F.WaitForWrapper = 1;
+			}
+			if (strcmp(Received, "ERROR\r\n") == 0) {
+				/* Module did not accept send command */
+				ESP8266->Flags.F.WaitForWrapper = 0;
+			}
+			break;
+#endif
 		case ESP8266_COMMAND_RST:
 			if (strcmp(Received, "ready\r\n") == 0) {
 				/* Reset active command */
@@ -2315,6 +3316,25 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 				ESP8266_Callback_ConnectedStationsDetected(ESP8266, &ESP8266->ConnectedStations);
 			}
 			break;
+#if ESP8266_USE_PASSIVE_RECEIVE
+		case ESP8266_COMMAND_CIPRECVDATA:
+			if (strcmp(Received, "OK\r\n") == 0) {
+				/* Reset active command */
+				ESP8266->ActiveCommand = ESP8266_COMMAND_IDLE;
+				ESP8266->ReceiveDataConnection = NULL;
+			}
+			if (strcmp(Received, "ERROR\r\n") == 0) {
+				/* Reset active command */
+				ESP8266->ActiveCommand = ESP8266_COMMAND_IDLE;
+				
+				/* Nothing to read on this connection */
+				if (ESP8266->ReceiveDataConnection != NULL) {
+					ESP8266->ReceiveDataConnection->DataAvailable = 0;
+					ESP8266->ReceiveDataConnection = NULL;
+				}
+			}
+			break;
+#endif
 		default:
 			/* No command was used to send, data received without command */
 			break;
@@ -2326,7 +3346,13 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 		
 		/* Reset active command */
 		/* TODO: Check if OK here */
-		if (ESP8266->ActiveCommand != ESP8266_COMMAND_SEND) {
+		if (
+			ESP8266->ActiveCommand != ESP8266_COMMAND_SEND &&
+#if ESP8266_USE_TRANSPARENT
+			ESP8266->ActiveCommand != ESP8266_COMMAND_TCIPSEND &&
+#endif
+			ESP8266->ActiveCommand != ESP8266_COMMAND_SENDDATA
+		) {
 			/* We are waiting for "> " string */
 			ESP8266->ActiveCommand = ESP8266_COMMAND_IDLE;
 		}
@@ -2338,13 +3364,6 @@ static void ParseReceived(ESP8266_t* ESP8266, char* Received, uint8_t from_usart
 		/* TODO: Check if ERROR here */
 		ESP8266->ActiveCommand = ESP8266_COMMAND_IDLE;
 	}
-	if (strcmp(Received, "SEND OK\r\n") == 0) {
-		/* Force IDLE when we are in SEND mode and SEND OK is returned. Do not wait for "> " wrapper */
-		ESP8266->ActiveCommand = ESP8266_COMMAND_IDLE;
-		
-		/* Clear flag */
-		ESP8266->Flags.F.WaitForWrapper = 0;
-	}
 }
 
 static ESP8266_Result_t SendCommand(ESP8266_t* ESP8266, uint8_t Command, char* CommandStr, char* StartRespond) {
@@ -2363,7 +3382,9 @@ static ESP8266_Result_t SendCommand(ESP8266_t* ESP8266, uint8_t Command, char* C
 	/* Save current active command */
 	ESP8266->ActiveCommand = Command;
 	ESP8266->ActiveCommandResponse[0][0] = 0;
-	strcpy(ESP8266->ActiveCommandResponse[0], StartRespond);
+	if (StartRespond != NULL) {
+		strcpy(ESP8266->ActiveCommandResponse[0], StartRespond);
+	}
 	
 	/* Set command start time */
 	ESP8266->StartTime = ESP8266->Time;
@@ -2498,79 +3519,1068 @@ static ESP8266_Result_t SendMACCommand(ESP8266_t* ESP8266, uint8_t* addr, char*
 	return ESP8266->Result;
 }
 
-static void CallConnectionCallbacks(ESP8266_t* ESP8266) {
-	uint8_t conn_number;
-	
-	/* Check if there are any pending data to be sent to connection */
-	for (conn_number = 0; conn_number < ESP8266_MAX_CONNECTIONS; conn_number++) {
-		if (
-			ESP8266->ActiveCommand == ESP8266_COMMAND_IDLE &&                                            /*!< Must be IDLE, if we are not because callbacks start command, stop execution */
-			ESP8266->Connection[conn_number].Active && ESP8266->Connection[conn_number].CallDataReceived /*!< We must call function for received data */
-		) {
-			/* Clear flag */
-			ESP8266->Connection[conn_number].CallDataReceived = 0;
+static void StartIPD(ESP8266_t* ESP8266, uint8_t number, uint32_t length, char* Received, uint16_t offset, uint16_t bufflen, uint8_t from_usart_buffer) {
+	ESP8266_Connection_t* Connection = &ESP8266->Connection[number];
+	uint16_t received = bufflen - offset;
+	
+	/* Go to IPD mode */
+	ESP8266->IPD.InIPD = 1;
+	ESP8266->IPD.USART_Buffer = from_usart_buffer;
+	ESP8266->IPD.ConnNumber = number;
+	
+	/* Set working buffer for this connection */
+#if ESP8266_USE_BUFFER_POOL
+	if (Connection->Data == NULL && !ESP8266_HAS_SINK(Connection) && !Connection->DataLost) {
+		BufferPoolAllocate(ESP8266, Connection, length);
+		
+		/* Dropped data would corrupt stream, close connection and drop everything until it is closed */
+		if (Connection->Data == NULL) {
+			Connection->DataLost = 1;
+			Connection->ClosePending = 1;
 			
-			/* Call user function according to connection type */
-			if (ESP8266->Connection[conn_number].Client) {
-				/* Client mode */
-				ESP8266_Callback_ClientConnectionDataReceived(ESP8266, &ESP8266->Connection[conn_number], ESP8266->Connection[conn_number].Data);
+			/* Call user function */
+			if (Connection->Handler != NULL) {
+				ESP8266_CALLHANDLER(ESP8266, Connection, Error, (ESP8266, Connection));
 			} else {
-				/* Server mode */
-				ESP8266_Callback_ServerConnectionDataReceived(ESP8266, &ESP8266->Connection[conn_number], ESP8266->Connection[conn_number].Data);
+				ESP8266_Callback_ConnectionDataLost(ESP8266, Connection);
 			}
 		}
 	}
-}
-
-static void ProcessSendData(ESP8266_t* ESP8266) {
-	uint16_t found;
-	ESP8266_Connection_t* Connection = ESP8266->SendDataConnection;
-	
-	/* Wrapper was found */
-	ESP8266->Flags.F.WaitForWrapper = 0;
+#elif ESP8266_USE_PINGPONG_RECEIVE
+	Connection->Data = ESP8266_PINGPONG_DATA(Connection);
+#elif ESP8266_USE_SINGLE_CONNECTION_BUFFER == 1
+	Connection->Data = ConnectionData;
+#endif
 	
-	/* Go to SENDDATA command as active */
-	ESP8266->ActiveCommand = ESP8266_COMMAND_SENDDATA;
+	/* Save connection number and number of bytes */
+	Connection->Number = number;
+	Connection->BytesReceived = length;
 	
-	/* Get data from user */
-	if (Connection->Client) {
-		/* Get data as client */
-		found = ESP8266_Callback_ClientConnectionSendData(ESP8266, Connection, Connection->Data, 2046);
+	/* First time */
+	if (Connection->TotalBytesReceived == 0) {
+		/* Start parsing HTTP head, user command result must stay */
+		ResetHeaders(Connection);
+		
+		/* This is first packet of data */
+		Connection->FirstPacket = 1;
+	} else {
+		/* This is not first packet */
+		Connection->FirstPacket = 0;
+	}
+	
+	/* Save total number of bytes */
+	Connection->TotalBytesReceived += length;
+	
+	/* Increase global number of bytes received from ESP8266 module to stack */
+	ESP8266->TotalBytesReceived += length;
+	
+	/* Line may have more characters than data */
+	if (received > length) {
+		received = length;
+	}
+	
+#if ESP8266_USE_DATA_SINK
+	/* Data go directly to sink, connection buffer is not used */
+	if (ESP8266_HAS_SINK(Connection)) {
+		/* Pass data from line */
+		if (received) {
+			CallDataSink(ESP8266, Connection, (uint8_t *)&Received[offset], received);
+		}
+		
+		/* Calculate remaining bytes */
+		ESP8266->IPD.InPtr = ESP8266->IPD.PtrTotal = received;
+		
+		/* Check remaining data */
+		if (received >= length) {
+			/* Not in IPD anymore */
+			ESP8266->IPD.InIPD = 0;
+			
+			/* Report number of bytes */
+			Connection->DataSize = received;
+			Connection->LastPart = 1;
+			Connection->CallDataReceived = 1;
+			CallConnectionCallbacks(ESP8266);
+		}
+		return;
+	}
+#endif
+	
+#if ESP8266_USE_BUFFER_POOL
+	/* There is no free memory for data, drop them */
+	if (Connection->Data == NULL) {
+		/* Save pointers */
+		ESP8266->IPD.InPtr = 0;
+		ESP8266->IPD.PtrTotal = received;
+		
+		/* Check remaining data */
+		if (received >= length) {
+			ESP8266->IPD.InIPD = 0;
+		}
+		return;
+	}
+#endif
+	
+	/* Copy content to beginning of buffer */
+	memcpy((uint8_t *)Connection->Data, (uint8_t *)&Received[offset], received);
+	
+	/* Add zero at the end of string if there is space */
+	if (received < ESP8266_DATA_BUFFER_SIZE(Connection)) {
+		Connection->Data[received] = 0;
+	}
+	
+	/* Calculate remaining bytes */
+	ESP8266->IPD.InPtr = ESP8266->IPD.PtrTotal = received;
+	
+	/* Check remaining data */
+	if (received >= length) {
+		/* Not in IPD anymore */
+		ESP8266->IPD.InIPD = 0;
+		
+		/* Set package data size */
+		Connection->DataSize = received;
+		Connection->LastPart = 1;
+		
+		/* Enable flag to call received data callback */
+		Connection->CallDataReceived = 1;
+		
+		/* Deliver data immediately, even if command is active */
+		CallConnectionCallbacks(ESP8266);
+	}
+}
+
+#if ESP8266_USE_PASSIVE_RECEIVE
+static void ReceiveSchedule(ESP8266_t* ESP8266) {
+	ESP8266_Connection_t* Connection;
+	char command[30];
+	uint32_t length;
+	uint8_t i;
+	
+	/* Module must be free and data buffer must be empty */
+	if (ESP8266->ActiveCommand != ESP8266_COMMAND_IDLE || ESP8266->IPD.InIPD) {
+		return;
+	}
+	for (i = 0; i < ESP8266_MAX_CONNECTIONS; i++) {
+		if (ESP8266->Connection[i].CallDataReceived) {
+			return;
+		}
+	}
+	
+	/* Find connection with available data */
+	for (i = 0; i < ESP8266_MAX_CONNECTIONS; i++) {
+		Connection = &ESP8266->Connection[i];
+		if (!Connection->Active || Connection->ReceiveHold || !Connection->DataAvailable) {
+			continue;
+		}
+		
+		/* Read as much as fits to connection and USART buffers */
+		length = Connection->DataAvailable;
+		if (length > ESP8266_RECEIVE_DATA_MAX) {
+			length = ESP8266_RECEIVE_DATA_MAX;
+		}
+		
+#if ESP8266_USE_RECEIVE_STREAM
+		/* Read only as much as fits to receive stream */
+		if (length > BUFFER_GetFree(&Connection->ReceiveStream)) {
+			length = BUFFER_GetFree(&Connection->ReceiveStream);
+		}
+		if (length == 0) {
+			continue;
+		}
+#endif
+		
+		/* Format command */
+		sprintf(command, "AT+CIPRECVDATA=%d,%d\r\n", Connection->Number, (int)length);
+		
+		/* Send command */
+		if (SendCommand(ESP8266, ESP8266_COMMAND_CIPRECVDATA, command, "+CIPRECVDATA") == ESP_OK) {
+			ESP8266->ReceiveDataConnection = Connection;
+			ESP8266->ReceiveDataLength = length;
+		}
+		return;
+	}
+}
+#endif
+
+static void CallConnectionCallbacks(ESP8266_t* ESP8266) {
+	uint8_t conn_number;
+	
+	/* Check if there are any pending data to be sent to connection */
+	for (conn_number = 0; conn_number < ESP8266_MAX_CONNECTIONS; conn_number++) {
+		if (
+			!ESP8266->Flags.F.InCallback &&                                                              /*!< Callbacks are not reentrant */
+			ESP8266->Connection[conn_number].Active && ESP8266->Connection[conn_number].CallDataReceived /*!< We must call function for received data */
+		) {
+			/* Clear flag */
+			ESP8266->Connection[conn_number].CallDataReceived = 0;
+			
+			/* Call user function */
+			CallDataReceivedCallback(ESP8266, &ESP8266->Connection[conn_number]);
+		}
+	}
+}
+
+static void CallDataReceivedCallback(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	uint8_t in_callback;
+	
+	/* Parse HTTP head */
+	if (!ESP8266_HAS_SINK(Connection)) {
+		ParseHeaders(ESP8266, Connection, Connection->Data, Connection->DataSize);
+	}
+	
+#if ESP8266_USE_RECEIVE_STREAM
+	/* Add data to receive stream */
+	if (!ESP8266_HAS_SINK(Connection)) {
+		Connection->ReceiveStreamDropped += Connection->DataSize - BUFFER_Write(&Connection->ReceiveStream, (uint8_t *)Connection->Data, Connection->DataSize);
+	}
+#endif
+	
+	/* Set flag, commands called from callback are only queued */
+	in_callback = ESP8266->Flags.F.InCallback;
+	ESP8266->Flags.F.InCallback = 1;
+	
+	/* Call user function according to connection type */
+	if (Connection->Handler != NULL) {
+		/* Protocol handler */
+		if (Connection->Handler->DataReceived != NULL) {
+			Connection->Handler->DataReceived(ESP8266, Connection, Connection->Data);
+		}
+	} else if (Connection->Client) {
+		/* Client mode */
+		ESP8266_Callback_ClientConnectionDataReceived(ESP8266, Connection, Connection->Data);
+	} else {
+		/* Server mode */
+		ESP8266_Callback_ServerConnectionDataReceived(ESP8266, Connection, Connection->Data);
+	}
+	
+	/* Restore flag, callback may be called from handler */
+	ESP8266->Flags.F.InCallback = in_callback;
+	
+#if ESP8266_USE_BUFFER_POOL
+	/* Return blocks to pool when packet is done */
+	if (Connection->LastPart) {
+		BufferPoolFree(ESP8266, Connection);
+	}
+#endif
+	
+#if ESP8266_USE_PINGPONG_RECEIVE
+	/* Keep buffer half if application wants it */
+	if (Connection->DataHold) {
+		Connection->DataHeld |= 1 << Connection->DataHalf;
+		Connection->DataHold = 0;
+	}
+	
+	/* Continue with other half */
+	Connection->DataHalf ^= 1;
+	Connection->Data = ESP8266_PINGPONG_DATA(Connection);
+#endif
+}
+
+#if ESP8266_USE_DATA_SINK
+static void CallDataSink(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const uint8_t* data, uint16_t length) {
+	uint8_t in_callback = ESP8266->Flags.F.InCallback;
+	
+	/* Parse HTTP head, body offset is relative to this part */
+	ParseHeaders(ESP8266, Connection, (const char *)data, length);
+	
+	/* Sink is called like data received callback */
+	ESP8266->Flags.F.InCallback = 1;
+	
+	/* Pass data */
+	Connection->DataSink(ESP8266, Connection, data, length);
+	
+	/* Restore flag, sink may be called from handler */
+	ESP8266->Flags.F.InCallback = in_callback;
+}
+#endif
+
+static void ResetHeaders(ESP8266_Connection_t* Connection) {
+	/* Reset parser */
+	Connection->HeadersDone = 0;
+	Connection->HeaderState = ESP8266_HEADER_STATE_FIRSTLINE;
+	Connection->HeaderLineLength = 0;
+	Connection->HeadersLength = 0;
+	
+	/* Reset values */
+	Connection->ContentLength = 0;
+	Connection->StatusCode = 0;
+	Connection->Chunked = 0;
+	Connection->KeepAlive = 0;
+}
+
+static void ParseHeaders(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const char* data, uint16_t length) {
+	uint16_t i;
+	char ch;
+	
+	/* Head was already parsed or data are not HTTP, datagrams are never HTTP */
+	if (Connection->HeaderState >= ESP8266_HEADER_STATE_DONE || Connection->Udp) {
+		Connection->BodyOffset = 0;
+		return;
+	}
+	
+	/* Go through new characters only */
+	for (i = 0; i < length; i++) {
+		ch = data[i];
+		Connection->HeadersLength++;
+		
+		/* First character must be start of HTTP version or request method */
+		if (
+			Connection->HeaderState == ESP8266_HEADER_STATE_FIRSTLINE &&
+			Connection->HeaderLineLength == 0 &&
+			!(ch >= 'A' && ch <= 'Z')
+		) {
+			Connection->HeaderState = ESP8266_HEADER_STATE_NOTHTTP;
+		}
+		
+		/* Data are not HTTP, everything is body */
+		if (Connection->HeaderState == ESP8266_HEADER_STATE_NOTHTTP) {
+			Connection->BodyOffset = 0;
+			return;
+		}
+		
+		/* Line is not finished yet */
+		if (ch != '\n') {
+			/* Save character if there is space, first line has its own limit */
+			if (Connection->HeaderLineLength < (Connection->HeaderState == ESP8266_HEADER_STATE_FIRSTLINE ? ESP8266_REQUEST_LINE_SIZE - 1 : ESP8266_HEADER_LINE_SIZE - 1)) {
+				Connection->HeaderLine[Connection->HeaderLineLength++] = ch;
+			}
+			continue;
+		}
+		
+		/* Remove carriage return and finish string */
+		if (Connection->HeaderLineLength && Connection->HeaderLine[Connection->HeaderLineLength - 1] == '\r') {
+			Connection->HeaderLineLength--;
+		}
+		Connection->HeaderLine[Connection->HeaderLineLength] = 0;
+		
+		/* Empty line is end of head */
+		if (Connection->HeaderLineLength == 0 && Connection->HeaderState == ESP8266_HEADER_STATE_HEADERS) {
+			Connection->HeaderState = ESP8266_HEADER_STATE_DONE;
+			Connection->HeadersDone = 1;
+			
+			/* Body starts with next character */
+			Connection->BodyOffset = i + 1;
+			return;
+		}
+		
+		/* Process line */
+		ParseHeaderLine(ESP8266, Connection);
+		Connection->HeaderLineLength = 0;
+	}
+	
+	/* No body in this part */
+	Connection->BodyOffset = length;
+}
+
+static void ParseHeaderLine(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	char* line = Connection->HeaderLine;
+	const char* value;
+	
+	/* Status or request line */
+	if (Connection->HeaderState == ESP8266_HEADER_STATE_FIRSTLINE) {
+		if (strncmp(line, "HTTP/1.", 7) == 0) {
+			/* Response, HTTP/1.1 connections are persistent by default */
+			Connection->KeepAlive = line[7] == '1';
+			Connection->StatusCode = ParseNumber(&line[9], NULL);
+		} else if (strchr(line, ' ') != NULL) {
+			/* Request, HTTP/1.0 connections are closed by default */
+			Connection->KeepAlive = strstr(line, " HTTP/1.0") == NULL;
+		} else {
+			/* Not HTTP */
+			Connection->HeaderState = ESP8266_HEADER_STATE_NOTHTTP;
+			return;
+		}
+		
+		/* Headers follow */
+		Connection->HeaderState = ESP8266_HEADER_STATE_HEADERS;
+		
+		/* Pass line to protocol handler */
+		if (Connection->Handler != NULL) {
+			ESP8266_CALLHANDLER(ESP8266, Connection, FirstLine, (ESP8266, Connection, Connection->HeaderLine));
+		}
+		return;
+	}
+	
+	/* Check headers we are interested in */
+	if (ESP8266_HeaderMatch(line, "content-length:")) {
+		/* Skip spaces and parse number */
+		value = ESP8266_SkipSpaces(line + 15);
+		Connection->ContentLength = ESP8266_ParseDecimal(&value);
+	} else if (ESP8266_HeaderMatch(line, "transfer-encoding:")) {
+		/* Check for chunked encoding */
+		for (line += 18; *line; line++) {
+			if (ESP8266_HeaderMatch(line, "chunked")) {
+				Connection->Chunked = 1;
+			}
+		}
+	} else if (ESP8266_HeaderMatch(line, "connection:")) {
+		/* Check for connection options */
+		for (line += 11; *line; line++) {
+			if (ESP8266_HeaderMatch(line, "close")) {
+				Connection->KeepAlive = 0;
+			} else if (ESP8266_HeaderMatch(line, "keep-alive")) {
+				Connection->KeepAlive = 1;
+			}
+		}
+	}
+	
+	/* Pass header line to protocol handler */
+	if (Connection->Handler != NULL) {
+		ESP8266_CALLHANDLER(ESP8266, Connection, Header, (ESP8266, Connection, Connection->HeaderLine));
+	}
+}
+
+#if ESP8266_USE_PINGPONG_RECEIVE
+static uint8_t PingPongReady(ESP8266_t* ESP8266, BUFFER_t* Buffer) {
+	ESP8266_Connection_t* Connection;
+	char data[13];
+	uint16_t count;
+	
+	/* Get beginning of next string */
+	count = BUFFER_Peek(Buffer, (uint8_t *)data, sizeof(data));
+	
+	/* Find connection which receives data after this string */
+	if (count >= 6 && strncmp(data, "+IPD,", 5) == 0 && CHAR2NUM(data[5]) < ESP8266_MAX_CONNECTIONS) {
+		Connection = &ESP8266->Connection[CHAR2NUM(data[5])];
+#if ESP8266_USE_PASSIVE_RECEIVE
+	} else if (count >= 13 && strncmp(data, "+CIPRECVDATA,", 13) == 0 && ESP8266->ReceiveDataConnection != NULL) {
+		Connection = ESP8266->ReceiveDataConnection;
+#endif
+	} else {
+		/* Response strings are always parsed */
+		return 1;
+	}
+	
+	/* Data stay in buffer until application releases buffer half */
+	return !(Connection->DataHeld & (1 << Connection->DataHalf));
+}
+#endif
+
+static void CloseSchedule(ESP8266_t* ESP8266) {
+	uint8_t conn_number;
+	
+	/* Go through all connections */
+	for (conn_number = 0; conn_number < ESP8266_MAX_CONNECTIONS; conn_number++) {
+		/* Module must be free */
+		if (ESP8266->ActiveCommand != ESP8266_COMMAND_IDLE) {
+			return;
+		}
+		
+		/* Check if close is pending */
+		if (ESP8266->Connection[conn_number].ClosePending) {
+			/* Close connection if still active */
+			if (ESP8266->Connection[conn_number].Active) {
+				ESP8266_CloseConnection(ESP8266, &ESP8266->Connection[conn_number]);
+			} else {
+				ESP8266->Connection[conn_number].ClosePending = 0;
+			}
+		}
+	}
+}
+
+static void ProcessSendData(ESP8266_t* ESP8266) {
+	uint16_t found, max;
+	ESP8266_Connection_t* Connection = ESP8266->SendDataConnection;
+	
+	/* Wrapper was found */
+	ESP8266->Flags.F.WaitForWrapper = 0;
+	Connection->WaitForWrapper = 0;
+	
+	/* Go to SENDDATA command as active */
+	ESP8266->ActiveCommand = ESP8266_COMMAND_SENDDATA;
+	
+	/* Send directly from user segments */
+	if (Connection->SendSegments != NULL) {
+		SendSegmentsData(ESP8266, Connection);
+		
+		/* Charge connection in send scheduler */
+		Connection->SendDeficit -= Connection->SendChunk;
+		
+		/* We are waiting for "SEND OK" now */
+		Connection->WaitingSentRespond = 1;
+		return;
+	}
+	
+	/* Get number of bytes module accepts */
+	if (Connection->SendLength) {
+		/* Module waits for exact number of bytes in stream mode */
+		max = Connection->SendChunk;
+	} else {
+		max = ESP8266_SEND_DATA_MAX;
+	}
+	
+	/* Get data from user */
+	if (Connection->Handler != NULL) {
+		/* Get data from protocol handler */
+		found = 0;
+		if (Connection->Handler->SendData != NULL) {
+			found = Connection->Handler->SendData(ESP8266, Connection, SendBuffer, max);
+		}
+	} else if (Connection->Client) {
+		/* Get data as client */
+		found = ESP8266_Callback_ClientConnectionSendData(ESP8266, Connection, SendBuffer, max);
 	} else {
 		/* Get data as server */
-		found = ESP8266_Callback_ServerConnectionSendData(ESP8266, Connection, Connection->Data, 2046);
+		found = ESP8266_Callback_ServerConnectionSendData(ESP8266, Connection, SendBuffer, max);
 	}
 	
 	/* Check for input data */
-	if (found > 2046) {
-		found = 2046;
+	if (found > max) {
+		found = max;
 	}
 	
 	/* If data valid */
 	if (found > 0) {
 		/* Send data */
-		ESP8266_LL_USARTSend((uint8_t *)Connection->Data, found);
+		ESP8266_LL_USARTSend((uint8_t *)SendBuffer, found);
 		
 		/* Increase number of bytes sent */
 		ESP8266->TotalBytesSent += found;
 	}
+	
+	if (Connection->SendLength) {
+		/* User did not fill entire chunk */
+		if (found < max) {
+			/* Module still waits for remaining bytes, fill them with zeros and stop stream after this chunk */
+			memset(&SendBuffer[found], 0, max - found);
+			ESP8266_LL_USARTSend((uint8_t *)&SendBuffer[found], max - found);
+			
+			/* Set error flag */
+			Connection->SendError = 1;
+		}
+	} else {
+		/* Send zero at the end even if data are not valid = stop sending data to module */
+		ESP8266_LL_USARTSend((uint8_t *)"\\0", 2);
+	}
+	
+	/* Charge connection in send scheduler */
+	Connection->SendDeficit -= Connection->SendLength ? max : found;
+	
+	/* We are waiting for "SEND OK" now */
+	Connection->WaitingSentRespond = 1;
+}
+
+static void SendSegmentsData(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	const ESP8266_Segment_t* Segment;
+	uint32_t length;
+	uint16_t remaining = Connection->SendChunk;
+	
+	/* Send data from segments until chunk is full */
+	while (remaining > 0 && Connection->SendSegmentIndex < Connection->SendSegmentsCount) {
+		Segment = &Connection->SendSegments[Connection->SendSegmentIndex];
+		
+		/* Get number of bytes we can send from current segment */
+		length = Segment->Length - Connection->SendSegmentOffset;
+		if (length > remaining) {
+			length = remaining;
+		}
+		
+		/* Send data directly from segment memory */
+		if (length > 0) {
+			ESP8266_LL_USARTSend((uint8_t *)Segment->Data + Connection->SendSegmentOffset, length);
+		}
+		
+		/* Update counters */
+		remaining -= length;
+		Connection->SendSegmentOffset += length;
+		ESP8266->TotalBytesSent += length;
+		
+		/* Go to next segment if this one is done */
+		if (Connection->SendSegmentOffset >= Segment->Length) {
+			Connection->SendSegmentIndex++;
+			Connection->SendSegmentOffset = 0;
+		}
+	}
+}
+
+static ESP8266_Result_t SendDataCommand(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	char command[30];
+	
+	/* Format command */
+	sprintf(command, "AT+CIPSENDEX=%d,2048\r\n", Connection->Number);
+	
+	/* Send command */
+	if (SendCommand(ESP8266, ESP8266_COMMAND_SEND, command, "AT+CIPSENDEX") != ESP_OK) {
+		return ESP8266->Result;
+	}
+	
+	/* We are waiting for "> " response */
+	Connection->WaitForWrapper = 1;
+	ESP8266->Flags.F.WaitForWrapper = 1;
+	
+	/* Save connection pointer */
+	ESP8266->SendDataConnection = Connection;
+	
+	/* Return from function */
+	return ESP8266->Result;
+}
+
+static ESP8266_Result_t SendChunkCommand(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	char command[50];
+	uint32_t remaining;
+	
+	/* Get number of bytes for next chunk */
+	remaining = Connection->SendLength - Connection->SendOffset;
+	if (Connection->SendSegments != NULL) {
+		/* No buffer is used for segments, only module limits chunk size */
+		if (remaining > ESP8266_SEND_CHUNK_SIZE) {
+			remaining = ESP8266_SEND_CHUNK_SIZE;
+		}
+	} else if (remaining > ESP8266_SEND_CHUNK_MAX) {
+		remaining = ESP8266_SEND_CHUNK_MAX;
+	}
+	Connection->SendChunk = remaining;
+	
+	if (Connection->Udp && Connection->SendPort) {
+		/* Datagram to remote address other than remote of link */
+		sprintf(command, "AT+CIPSEND=%d,%d,\"%d.%d.%d.%d\",%d\r\n", Connection->Number, Connection->SendChunk,
+			Connection->SendIP[0], Connection->SendIP[1], Connection->SendIP[2], Connection->SendIP[3], Connection->SendPort);
+#if ESP8266_USE_SENDBUF
+	} else if (!Connection->Udp) {
+		/* Format buffered send command, module returns segment ID for this chunk */
+		sprintf(command, "AT+CIPSENDBUF=%d,%d\r\n", Connection->Number, Connection->SendChunk);
+#endif
+	} else {
+		/* Format command, use exact length so module does not need "\0" at the end of data */
+		sprintf(command, "AT+CIPSEND=%d,%d\r\n", Connection->Number, Connection->SendChunk);
+	}
+	
+	/* Send command */
+	if (SendCommand(ESP8266, ESP8266_COMMAND_SEND, command, "AT+CIPSEND") != ESP_OK) {
+		return ESP8266->Result;
+	}
+	
+	/* We are waiting for "> " response */
+	Connection->WaitForWrapper = 1;
+	ESP8266->Flags.F.WaitForWrapper = 1;
+	
+	/* Save connection pointer */
+	ESP8266->SendDataConnection = Connection;
+	
+	/* Return from function */
+	return ESP8266->Result;
+}
+
+static void SendDataCompleted(ESP8266_t* ESP8266, uint8_t success) {
+	ESP8266_Connection_t* Connection = ESP8266->SendDataConnection;
+	
+	/* Check if any connection is sending data */
+	if (Connection == NULL) {
+		return;
+	}
+	
+	/* Reset flags */
+	ESP8266->SendDataConnection = NULL;
+	Connection->WaitForWrapper = 0;
+	Connection->WaitingSentRespond = 0;
+	
+	/* Check for stream */
+	if (Connection->SendLength) {
+		if (success && !Connection->SendError) {
+			/* Chunk was sent */
+			Connection->SendOffset += Connection->SendChunk;
+			
+			/* Check if anything else to send */
+			if (Connection->SendOffset < Connection->SendLength) {
+				/* Let scheduler decide which connection sends next chunk, do not return to user */
+				SendSchedule(ESP8266);
+				return;
+			}
+		}
+		
+		/* Stream stopped with error */
+		if (Connection->SendError || Connection->SendOffset < Connection->SendLength) {
+			success = 0;
+		}
+		
+#if ESP8266_USE_SENDBUF
+		/* Wait for buffered segments to be acknowledged before stream is finished */
+		if (Connection->SendBufCount) {
+			Connection->SendError = !success;
+			return;
+		}
+#endif
+	}
+	
+	/* Finish sending */
+	SendDataFinished(ESP8266, Connection, success);
+	
+	/* Give turn to next connection */
+	SendSchedule(ESP8266);
+}
+
+static void SendDataFinished(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t success) {
+	/* Reset request and stream */
+	Connection->SendRequest = 0;
+	Connection->SendLength = 0;
+	Connection->SendError = 0;
+	Connection->SendSegments = NULL;
+	Connection->SendPort = 0;
+	
+#if ESP8266_USE_WRITEBUFFER
+	/* Check if write buffer was sent */
+	if (Connection->WriteFlushing) {
+		WriteBufferFlushed(ESP8266, Connection, success);
 		
-	/* Send zero at the end even if data are not valid = stop sending data to module */
-	ESP8266_LL_USARTSend((uint8_t *)"\\0", 2);
+		/* User is notified only on error */
+		if (success) {
+			return;
+		}
+	}
+#endif
+	
+	/* Call user function according to connection type */
+	if (Connection->Handler != NULL) {
+		/* Protocol handler */
+		ESP8266_CALLHANDLER(ESP8266, Connection, DataSent, (ESP8266, Connection, success));
+	} else if (success) {
+		if (Connection->Client) {
+			/* Client mode */
+			ESP8266_Callback_ClientConnectionDataSent(ESP8266, Connection);
+		} else {
+			/* Server mode */
+			ESP8266_Callback_ServerConnectionDataSent(ESP8266, Connection);
+		}
+	} else {
+		if (Connection->Client) {
+			/* Client mode */
+			ESP8266_Callback_ClientConnectionDataSentError(ESP8266, Connection);
+		} else {
+			/* Server mode */
+			ESP8266_Callback_ServerConnectionDataSentError(ESP8266, Connection);
+		}
+	}
 }
 
+static uint8_t SendPending(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	/* Connection must be active and not sending right now */
+	if (!Connection->Active || Connection == ESP8266->SendDataConnection) {
+		return 0;
+	}
+	
+	/* Single data package request */
+	if (Connection->SendRequest) {
+		return 1;
+	}
+	
+	/* Stream with remaining chunks */
+	if (Connection->SendLength) {
+		if (Connection->SendError || Connection->SendOffset >= Connection->SendLength) {
+			return 0;
+		}
+#if ESP8266_USE_SENDBUF
+		/* Window must have space for new segment */
+		if (Connection->SendBufCount >= ESP8266_SENDBUF_WINDOW) {
+			return 0;
+		}
+#endif
+		return 1;
+	}
+	
+#if ESP8266_USE_WRITEBUFFER
+	/* Write buffer which should be flushed */
+	return WriteBufferReady(ESP8266, Connection);
+#else
+	return 0;
+#endif
+}
+
+static void SendSchedule(ESP8266_t* ESP8266) {
+	ESP8266_Connection_t* Connection;
+	uint8_t i, pending = 0;
+	uint16_t visits;
+	
+	/* Module must be free, requests from callbacks are started from update */
+	if (ESP8266->ActiveCommand != ESP8266_COMMAND_IDLE || ESP8266->Flags.F.InCallback) {
+		return;
+	}
+	
+	/* Check for connections with data, idle connections do not collect send credit */
+	for (i = 0; i < ESP8266_MAX_CONNECTIONS; i++) {
+		if (SendPending(ESP8266, &ESP8266->Connection[i])) {
+			pending = 1;
+		} else {
+			ESP8266->Connection[i].SendDeficit = 0;
+		}
+	}
+	
+	/* Nothing to send */
+	if (!pending) {
+		return;
+	}
+	
+	/* Deficit round robin, connection keeps turn until it uses its quantum */
+	for (visits = 0; visits < ESP8266_SEND_SCHEDULE_VISITS; visits++) {
+		Connection = &ESP8266->Connection[ESP8266->SendScheduleIndex];
+		
+		/* Connection has credit, start sending */
+		if (SendPending(ESP8266, Connection) && Connection->SendDeficit > 0) {
+			if (Connection->SendRequest) {
+				/* Single data package */
+				if (SendDataCommand(ESP8266, Connection) == ESP_OK) {
+					Connection->SendRequest = 0;
+				}
+#if ESP8266_USE_WRITEBUFFER
+			} else if (!Connection->SendLength) {
+				/* Flush write buffer */
+				WriteBufferStart(ESP8266, Connection);
+#endif
+			} else {
+				/* Next chunk of stream */
+				SendChunkCommand(ESP8266, Connection);
+			}
+			return;
+		}
+		
+		/* Turn is over, go to next connection */
+		if (++ESP8266->SendScheduleIndex >= ESP8266_MAX_CONNECTIONS) {
+			ESP8266->SendScheduleIndex = 0;
+		}
+		
+		/* Start new turn with quantum according to priority */
+		Connection = &ESP8266->Connection[ESP8266->SendScheduleIndex];
+		if (SendPending(ESP8266, Connection)) {
+			Connection->SendDeficit += (int32_t)ESP8266_SEND_QUANTUM * (Connection->Priority ? Connection->Priority : 1);
+		}
+	}
+}
+
+#if ESP8266_USE_SENDBUF
+static void SendBufAccepted(ESP8266_t* ESP8266) {
+	ESP8266_Connection_t* Connection = ESP8266->SendDataConnection;
+	
+	/* Reset active command, we do not wait for "SEND OK" */
+	ESP8266->ActiveCommand = ESP8266_COMMAND_IDLE;
+	ESP8266->SendDataConnection = NULL;
+	Connection->WaitingSentRespond = 0;
+	
+	/* Add segment to window */
+	if (Connection->SendBufCount < ESP8266_SENDBUF_WINDOW) {
+		Connection->SendBufIDs[Connection->SendBufCount++] = Connection->SendBufID;
+	}
+	
+	/* Chunk is in module buffer */
+	Connection->SendOffset += Connection->SendChunk;
+	
+	/* Send next chunk if window allows it */
+	SendBufContinue(ESP8266, Connection);
+}
+
+static void SendBufAcknowledged(ESP8266_t* ESP8266, char* Received, uint8_t success) {
+	ESP8266_Connection_t* Connection;
+	uint8_t i, cnt;
+	uint16_t id;
+	
+	/* Get connection from "<link ID>,<segment ID>" part */
+	if (CHAR2NUM(Received[0]) >= ESP8266_MAX_CONNECTIONS || Received[1] != ',') {
+		return;
+	}
+	Connection = &ESP8266->Connection[CHAR2NUM(Received[0])];
+	id = ParseNumber(&Received[2], &cnt);
+	
+	/* Find segment in window */
+	for (i = 0; i < Connection->SendBufCount; i++) {
+		if (Connection->SendBufIDs[i] == id) {
+			break;
+		}
+	}
+	if (i == Connection->SendBufCount) {
+		return;
+	}
+	
+	/* Remove it from window */
+	for (; i < (Connection->SendBufCount - 1); i++) {
+		Connection->SendBufIDs[i] = Connection->SendBufIDs[i + 1];
+	}
+	Connection->SendBufCount--;
+	
+	/* Stop stream on error */
+	if (!success) {
+		Connection->SendError = 1;
+	}
+	
+	/* Continue or finish stream */
+	if (Connection->SendLength && Connection != ESP8266->SendDataConnection) {
+		SendBufContinue(ESP8266, Connection);
+	}
+}
+
+static void SendBufContinue(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	/* Check if connection is currently sending chunk */
+	if (Connection == ESP8266->SendDataConnection) {
+		return;
+	}
+	
+	/* Check if stream is done or stopped */
+	if (Connection->SendError || Connection->SendOffset >= Connection->SendLength) {
+		/* Finish when all segments are acknowledged */
+		if (Connection->SendBufCount == 0) {
+			SendDataFinished(ESP8266, Connection, !Connection->SendError);
+		}
+		return;
+	}
+	
+	/* Send next chunk if there is space in window and module is free */
+	SendSchedule(ESP8266);
+}
+#endif
+
+#if ESP8266_USE_WRITEBUFFER
+static uint8_t WriteBufferReady(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	/* Check if there is anything to flush and connection is not sending already */
+	if (
+		Connection->WriteFlushing || Connection->SendLength || Connection->WriteLength == 0
+	) {
+		return 0;
+	}
+	
+	/* Check flush conditions */
+	return
+		Connection->WriteFlushRequest ||
+		Connection->WriteLength >= ESP8266_WRITEBUFFER_THRESHOLD ||
+		(ESP8266->Time - Connection->WriteTime) >= ESP8266_WRITEBUFFER_TIMEOUT;
+}
+
+static ESP8266_Result_t WriteBufferStart(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	/* Send entire buffer as single segment */
+	Connection->WriteSegment.Data = Connection->WriteBuffer;
+	Connection->WriteSegment.Length = Connection->WriteLength;
+	Connection->SendLength = Connection->WriteLength;
+	Connection->SendOffset = 0;
+	Connection->SendError = 0;
+	Connection->SendSegments = &Connection->WriteSegment;
+	Connection->SendSegmentsCount = 1;
+	Connection->SendSegmentIndex = 0;
+	Connection->SendSegmentOffset = 0;
+	
+	/* Request first chunk */
+	if (SendChunkCommand(ESP8266, Connection) != ESP_OK) {
+		/* Reset stream, try again later */
+		Connection->SendLength = 0;
+		Connection->SendSegments = NULL;
+		return ESP8266->Result;
+	}
+	
+	/* Save statistics, all writes in buffer are now sent with one handshake */
+	if (Connection->WriteRecords > 1) {
+		ESP8266->TotalHandshakesSaved += Connection->WriteRecords - 1;
+	}
+	Connection->WriteFlushCount++;
+	Connection->WriteRecords = 0;
+	
+	/* Buffer is flushing */
+	Connection->WriteFlushing = Connection->WriteLength;
+	Connection->WriteFlushRequest = 0;
+	
+	/* Return from function */
+	return ESP8266->Result;
+}
+
+static void WriteBufferFlushed(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t success) {
+	/* Remove sent data from buffer, data are dropped on error too */
+	Connection->WriteLength -= Connection->WriteFlushing;
+	memmove(Connection->WriteBuffer, &Connection->WriteBuffer[Connection->WriteFlushing], Connection->WriteLength);
+	Connection->WriteFlushing = 0;
+	
+	/* Drop everything if connection is closed */
+	if (!Connection->Active) {
+		Connection->WriteLength = 0;
+		Connection->WriteRecords = 0;
+	}
+	
+	/* Start deadline for data written during flush */
+	Connection->WriteTime = ESP8266->Time;
+}
+#endif
+
 /* Check if needle exists in haystack memory */
 void* mem_mem(void* haystack, size_t haystacksize, void* needle, size_t needlesize) {
 	unsigned char* hptr = (unsigned char *)haystack;
 	unsigned char* nptr = (unsigned char *)needle;
 	unsigned int i;
-
-	/* Go through entire memory */
-	for (i = 0; i < haystacksize; i++) {
+	
+	/* Go through entire memory, do not compare after the end of haystack */
+	for (i = 0; (i + needlesize) <= haystacksize; i++) {
 		if (memcmp(&hptr[i], nptr, needlesize) == 0) {
 			return &hptr[i];
 		}
 	}
-
+	
 	return 0;
 }
+
+#if ESP8266_USE_BUFFER_POOL
+static void BufferPoolAllocate(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint32_t length) {
+	uint8_t i, start = 0, count = 0, best_start = 0, best_count = 0, needed, owner;
+	
+	/* Calculate number of blocks for entire packet */
+	needed = (length + ESP8266_BUFFER_POOL_BLOCK_SIZE - 1) / ESP8266_BUFFER_POOL_BLOCK_SIZE;
+	if (needed == 0) {
+		needed = 1;
+	}
+	
+	/* Check connection limit */
+	if (Connection->DataBufferBlocks == 0) {
+		Connection->DataBufferBlocks = ESP8266_BUFFER_POOL_CONNECTION_BLOCKS;
+	}
+	if (needed > Connection->DataBufferBlocks) {
+		needed = Connection->DataBufferBlocks;
+	}
+	
+	/* Find longest free run of blocks, up to needed number */
+	for (i = 0; i < ESP8266_BUFFER_POOL_BLOCKS && best_count < needed; i++) {
+		if (BufferPoolOwner[i]) {
+			/* Block is taken, start new run */
+			count = 0;
+			continue;
+		}
+		
+		/* Save start of run */
+		if (count == 0) {
+			start = i;
+		}
+		count++;
+		
+		/* Check for longest run */
+		if (count > best_count) {
+			best_count = count;
+			best_start = start;
+		}
+	}
+	
+	/* No free memory */
+	if (best_count == 0) {
+		Connection->Data = NULL;
+		Connection->DataBufferSize = 0;
+		ESP8266->BufferPoolMisses++;
+		return;
+	}
+	
+	/* Take blocks */
+	owner = (uint8_t)(Connection - ESP8266->Connection) + 1;
+	for (i = best_start; i < best_start + best_count; i++) {
+		BufferPoolOwner[i] = owner;
+	}
+	
+	/* Set connection buffer */
+	Connection->Data = &BufferPool[best_start * ESP8266_BUFFER_POOL_BLOCK_SIZE];
+	Connection->DataBufferSize = best_count * ESP8266_BUFFER_POOL_BLOCK_SIZE;
+}
+
+static void BufferPoolFree(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	uint8_t i, owner;
+	
+	/* Get owner value */
+	owner = (uint8_t)(Connection - ESP8266->Connection) + 1;
+	
+	/* Return blocks */
+	for (i = 0; i < ESP8266_BUFFER_POOL_BLOCKS; i++) {
+		if (BufferPoolOwner[i] == owner) {
+			BufferPoolOwner[i] = 0;
+		}
+	}
+	
+	/* Connection has no buffer now */
+	Connection->Data = NULL;
+	Connection->DataBufferSize = 0;
+}
+#endif
@@ -71,6 +71,41 @@ extern "C" {
  * \section sect_changelog Changelog
  *
 \verbatim
+v0.3
+	- Added ESP8266_RequestSendStream function to send large amount of data in multiple AT+CIPSEND cycles with single request
+	- Added ESP8266_SEND_CHUNK_SIZE macro to set maximal number of bytes sent in one AT+CIPSEND cycle
+	- Data sent callbacks are now called only for connection which actually sent data
+	- Added ESP8266_SEND_BUFFER_SIZE macro. Send data callbacks now fill separate buffer instead of connection receive buffer
+	- Added ESP8266_RequestSendSegments function to send data directly from user memory segments without copy
+	- Added ESP8266_USE_SENDBUF macro to send streams with AT+CIPSENDBUF command and multiple chunks in flight per connection
+	- Added ESP8266_Write and ESP8266_Flush functions to collect small writes and send them in single AT+CIPSEND cycle
+	- Send requests are now queued per connection and served by deficit round robin scheduler, no need to wait for idle module
+	- Added ESP8266_SetConnectionPriority function to set connection share of send bandwidth
+	- Added ESP8266_USE_TRANSPARENT macro and functions for transparent transmission mode on single connection
+	- Added ESP8266_USE_PASSIVE_RECEIVE macro to read data from module with AT+CIPRECVDATA only when application is ready
+	- Received data callbacks are called as soon as data are received, even when command is active
+	- ESP8266_CloseConnection can be called when module is busy, connection is closed when module is free
+	- Added ESP8266_USE_BUFFER_POOL macro to take connection receive buffers from common pool of blocks
+	- Connection is closed when buffer pool has no free block for its data, ESP8266_Callback_ConnectionDataLost is called
+	- Added ESP8266_USE_RECEIVE_STREAM macro and ESP8266_Read, ESP8266_Available, ESP8266_Peek and ESP8266_Skip functions
+	- Added ESP8266_USE_PINGPONG_RECEIVE macro with ESP8266_HoldData and ESP8266_ReleaseData functions
+	- Added ESP8266_USE_DATA_SINK macro and ESP8266_SetDataSink function to receive data without connection buffer
+	- HTTP head of received data is parsed incrementally, also when split across multiple +IPD packets
+	- Added connection handlers for protocol modules and HTTP client module in esp8266_http.h
+	- HTTP client keeps connections open and reuses them for next requests to the same server
+	- HTTP client can pipeline requests on one connection
+	- Connection handlers receive each parsed HTTP header line
+	- Added resumable download module in esp8266_download.h
+	- HTTP client can cache validators and bodies of GET responses
+	- HTTP client decompresses gzip and deflate responses with decoder in esp8266_inflate.h, host benchmark in tools/esp8266_inflate_bench.c
+	- Added ESP8266_SetServerHandler function to handle server connections with protocol handler
+	- Connection handlers receive HTTP request or status line
+	- Added HTTP server module in esp8266_httpd.h
+	- Added ESP8266_StartUDPConnection and ESP8266_RequestSendDatagram functions for UDP links
+	- Transparent transmission mode is left after ESP8266_TRANSPARENT_TIMEOUT milliseconds without data
+	- Transparent mode is started and left from ESP8266_Update without blocking, with connected and closed callbacks
+	- Added ESP8266_HeaderMatch, ESP8266_SkipSpaces, ESP8266_ParseDecimal and ESP8266_NumberToString helpers for protocol modules
+
 v0.2 (January , 2016)
 	- Function ESP8266_RequestSendData has been improved to remove waiting for ESP8266 to answer with "> " before continue 
 	- Added ESP8266_USE_PING macro to enable or disable ping feature on ESP8266 module
@@ -167,6 +202,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #if !defined(ESP8266_CONF_H) || ESP8266_CONF_H != ESP8266_H
 #error Wrong configuration file!
 #endif
+#if ESP8266_REQUEST_LINE_SIZE < ESP8266_HEADER_LINE_SIZE
+#error ESP8266_REQUEST_LINE_SIZE must not be smaller than ESP8266_HEADER_LINE_SIZE!
+#endif
 
 /**
  * @defgroup ESP8266_Macros
@@ -258,6 +296,15 @@ typedef enum {
 	ESP8266_SleepMode_Modem = 0x02    /*!< Model sleep mode */
 } ESP8266_SleepMode_t;
 
+/**
+ * @brief  UDP remote peer mode enumeration
+ */
+typedef enum {
+	ESP8266_UDPMode_Fixed = 0x00,      /*!< Remote IP and port of link do not change */
+	ESP8266_UDPMode_ChangeOnce = 0x01, /*!< Remote IP and port change to sender of first received datagram */
+	ESP8266_UDPMode_Change = 0x02      /*!< Remote IP and port change to sender of each received datagram */
+} ESP8266_UDPMode_t;
+
 /**
  * @brief  IPD network data structure
  */
@@ -270,23 +317,102 @@ typedef struct {
 } ESP8266_IPD_t;
 
 /**
- * @brief  Connection structure
+ * @brief  Data segment for sending data directly from user memory
+ */
+typedef struct {
+	const void* Data; /*!< Pointer to segment data. Memory must stay valid until data sent callback is called */
+	uint32_t Length;  /*!< Number of bytes in segment */
+} ESP8266_Segment_t;
+
+/* Forward declarations */
+struct _ESP8266_t;
+struct _ESP8266_Connection_t;
+
+/**
+ * @brief  Data sink function for connection, set with @ref ESP8266_SetDataSink
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to connection which received data
+ * @param  *data: Pointer to received data
+ * @param  length: Number of bytes in data
+ */
+typedef void (*ESP8266_DataSink_t)(struct _ESP8266_t* ESP8266, struct _ESP8266_Connection_t* Connection, const uint8_t* data, uint16_t length);
+
+/**
+ * @brief  Connection handler for protocol modules
+ * @note   When connection has handler, handler functions are called instead of callback functions for this connection.
+ *         Any function pointer can be NULL. Commands called from handler functions are only queued, like in data received callbacks
  */
 typedef struct {
+	void (*Connected)(struct _ESP8266_t* ESP8266, struct _ESP8266_Connection_t* Connection);    /*!< Connection is active */
+	void (*Error)(struct _ESP8266_t* ESP8266, struct _ESP8266_Connection_t* Connection);        /*!< Client connection failed or timeout occurred, or received data were lost */
+	uint16_t (*SendData)(struct _ESP8266_t* ESP8266, struct _ESP8266_Connection_t* Connection, char* Buffer, uint16_t max_buffer_size); /*!< Fill data to send, same as send data callback */
+	void (*DataSent)(struct _ESP8266_t* ESP8266, struct _ESP8266_Connection_t* Connection, uint8_t success); /*!< Send request finished */
+	void (*DataReceived)(struct _ESP8266_t* ESP8266, struct _ESP8266_Connection_t* Connection, char* Buffer); /*!< Data received, same as data received callback */
+	void (*Closed)(struct _ESP8266_t* ESP8266, struct _ESP8266_Connection_t* Connection);       /*!< Connection was closed */
+	void (*Header)(struct _ESP8266_t* ESP8266, struct _ESP8266_Connection_t* Connection, const char* line); /*!< HTTP header line was parsed, line is cut to @ref ESP8266_HEADER_LINE_SIZE - 1 characters */
+	void (*FirstLine)(struct _ESP8266_t* ESP8266, struct _ESP8266_Connection_t* Connection, const char* line); /*!< HTTP request or status line was parsed, line is cut to @ref ESP8266_REQUEST_LINE_SIZE - 1 characters */
+} ESP8266_Handler_t;
+
+/**
+ * @brief  Connection structure
+ */
+typedef struct _ESP8266_Connection_t {
 	uint8_t Active;              /*!< Status if connection is active */
 	uint8_t Number;              /*!< Connection number */
 	uint8_t Client;              /*!< Set to 1 if connection was made as client */
-	uint16_t RemotePort;         /*!< Remote PORT number */
-	uint8_t RemoteIP[4];         /*!< IP address of device */
+	uint8_t Udp;                 /*!< Set to 1 if connection is UDP link */
+	uint16_t RemotePort;         /*!< Remote PORT number. On UDP link, source port of current datagram */
+	uint8_t RemoteIP[4];         /*!< IP address of device. On UDP link, source IP of current datagram */
 	uint32_t BytesReceived;      /*!< Number of bytes received in current +IPD data package. U
                                         Use @arg DataSize to detect how many data bytes are in current package when callback function is called for received data */
 	uint32_t TotalBytesReceived; /*!< Number of bytes received in entire connection lifecycle */
 	uint8_t WaitForWrapper;      /*!< Status flag, to wait for ">" wrapper on data sent */
 	uint8_t WaitingSentRespond;  /*!< Set to 1 when we have sent data and we are waiting respond */
-#if ESP8266_USE_SINGLE_CONNECTION_BUFFER == 1
+	uint32_t SendLength;         /*!< Total number of bytes in stream when data are sent using @ref ESP8266_RequestSendStream, 0 otherwise */
+	uint32_t SendOffset;         /*!< Number of stream bytes already sent to module. Use it in send data callback to know which part of stream to fill */
+	uint16_t SendChunk;          /*!< Number of bytes module expects in current AT+CIPSEND cycle of stream */
+	uint8_t SendError;           /*!< Set to 1 when user did not fill entire chunk of stream */
+	const ESP8266_Segment_t* SendSegments; /*!< Pointer to segments array when data are sent using @ref ESP8266_RequestSendSegments */
+	uint8_t SendSegmentsCount;   /*!< Number of segments in array */
+	uint8_t SendSegmentIndex;    /*!< Index of segment where next data byte will be sent from */
+	uint32_t SendSegmentOffset;  /*!< Offset in segment where next data byte will be sent from */
+	ESP8266_Segment_t SendDatagram; /*!< Segment of datagram sent with @ref ESP8266_RequestSendDatagram */
+	uint8_t SendIP[4];           /*!< Remote IP of datagram sent with @ref ESP8266_RequestSendDatagram */
+	uint16_t SendPort;           /*!< Remote port of datagram sent with @ref ESP8266_RequestSendDatagram, 0 for remote of link */
+	uint8_t SendRequest;         /*!< Set to 1 when @ref ESP8266_RequestSendData request waits for send scheduler */
+	uint8_t Priority;            /*!< Send priority of connection, set with @ref ESP8266_SetConnectionPriority */
+	int32_t SendDeficit;         /*!< Number of bytes connection can still send in current scheduler round */
+#if ESP8266_USE_SENDBUF
+	uint16_t SendBufID;          /*!< Segment ID returned by module on current AT+CIPSENDBUF command */
+	uint16_t SendBufIDs[ESP8266_SENDBUF_WINDOW]; /*!< Segment IDs sent to module which are waiting for "SEND OK" */
+	uint8_t SendBufCount;        /*!< Number of segments waiting for "SEND OK" */
+#endif
+#if ESP8266_USE_WRITEBUFFER
+	uint8_t WriteBuffer[ESP8266_WRITEBUFFER_SIZE]; /*!< Write buffer for @ref ESP8266_Write function */
+	uint16_t WriteLength;        /*!< Number of bytes in write buffer */
+	uint16_t WriteFlushing;      /*!< Number of bytes from beginning of write buffer which are currently sent to module */
+	uint8_t WriteFlushRequest;   /*!< Set to 1 when user requested flush with @ref ESP8266_Flush function */
+	uint32_t WriteTime;          /*!< Time when first byte was written to empty write buffer */
+	uint16_t WriteRecords;       /*!< Number of writes in write buffer which are not yet flushing */
+	ESP8266_Segment_t WriteSegment; /*!< Segment used to send write buffer */
+	uint32_t WriteCount;         /*!< Number of successful @ref ESP8266_Write calls in entire connection lifecycle */
+	uint32_t WriteFlushCount;    /*!< Number of AT+CIPSEND cycles used to flush write buffer. Difference to @arg WriteCount is number of handshakes saved */
+#endif
+#if ESP8266_USE_SINGLE_CONNECTION_BUFFER == 1 || ESP8266_USE_BUFFER_POOL || ESP8266_USE_PINGPONG_RECEIVE
 	char* Data;                  /*<! Use pointer to data array */
 #else
 	char Data[ESP8266_CONNECTION_BUFFER_SIZE]; /*!< Data array */
+#endif
+#if ESP8266_USE_PINGPONG_RECEIVE
+	char DataMemory[ESP8266_CONNECTION_BUFFER_SIZE]; /*!< Memory for both buffer halves */
+	uint8_t DataHalf;            /*!< Buffer half which is currently filled with received data */
+	uint8_t DataHeld;            /*!< Bit mask of buffer halves held by application */
+	uint8_t DataHold;            /*!< Set to 1 when @ref ESP8266_HoldData was called in data received callback */
+#endif
+#if ESP8266_USE_BUFFER_POOL
+	uint16_t DataBufferSize;     /*!< Size of data buffer taken from pool in units of bytes, 0 if connection has no buffer */
+	uint8_t DataBufferBlocks;    /*!< Maximal number of pool blocks connection can take. When set to 0, @ref ESP8266_BUFFER_POOL_CONNECTION_BLOCKS is used */
+	uint8_t DataLost;            /*!< Set to 1 when received data were dropped because pool had no free block. Connection is closed and further data are dropped */
 #endif
 	uint16_t DataSize;           /*!< Number of bytes in current data package.
                                         Becomes useful, when we have buffer size for data less than ESP8266 IPD statement has data for us.
@@ -295,12 +421,34 @@ typedef struct {
                                         this parameter can be used if received part of data is last on one +IPD packet.
                                         When data buffer is bigger, this parameter is always set to 1 */
 	uint8_t CallDataReceived;    /*!< Set to 1 when we are waiting for commands to be inactive before we call callback function */
-	uint32_t ContentLength;      /*!< Value of "Content-Length" header if it exists in +IPD data packet */
+	uint32_t ContentLength;      /*!< Value of "Content-Length" header if it exists in HTTP head */
+	uint16_t StatusCode;         /*!< HTTP status code when response was received, 0 otherwise */
+	uint8_t Chunked;             /*!< Set to 1 when "Transfer-Encoding: chunked" header exists in HTTP head */
+	uint8_t KeepAlive;           /*!< Set to 1 when connection stays open after HTTP message, according to HTTP version and "Connection" header */
+	uint32_t HeadersLength;      /*!< Number of bytes of HTTP head, including empty line at the end */
+	uint16_t BodyOffset;         /*!< Offset of HTTP body in current data package. When equal to @arg DataSize, package has no body data */
+	uint8_t HeaderState;         /*!< HTTP head parser state */
+	uint16_t HeaderLineLength;   /*!< Number of characters in @arg HeaderLine */
+	char HeaderLine[ESP8266_REQUEST_LINE_SIZE]; /*!< Current HTTP request, status or header line */
 	char Name[ESP8266_MAX_CONNECTION_NAME]; /*!< Connection name, useful when using as client */
 	void* UserParameters;        /*!< User parameters pointer. Useful when user wants to pass custom data which can later be used in callbacks */
-	uint8_t HeadersDone;         /*!< User option flag to set when headers has been found in response */
+	const ESP8266_Handler_t* Handler; /*!< Protocol handler for connection or NULL when callback functions are used */
+	uint8_t HeadersDone;         /*!< Set to 1 when entire HTTP head was received */
 	uint8_t FirstPacket;         /*!< Set to 1 when if first packet in connection received */
 	uint8_t LastActivity;        /*!< Connection last activity time */
+	uint8_t ClosePending;        /*!< Set to 1 when close was requested while module was busy or from callback */
+#if ESP8266_USE_PASSIVE_RECEIVE
+	uint32_t DataAvailable;      /*!< Number of bytes module has for this connection and were not read yet */
+	uint8_t ReceiveHold;         /*!< Set to 1 when data should not be read from module, set with @ref ESP8266_SetReceiveHold */
+#endif
+#if ESP8266_USE_RECEIVE_STREAM
+	BUFFER_t ReceiveStream;      /*!< Cyclic buffer with received data, read with @ref ESP8266_Read function */
+	uint8_t ReceiveStreamData[ESP8266_RECEIVE_STREAM_SIZE]; /*!< Receive stream memory */
+	uint32_t ReceiveStreamDropped; /*!< Number of received bytes which did not fit to receive stream */
+#endif
+#if ESP8266_USE_DATA_SINK
+	ESP8266_DataSink_t DataSink; /*!< Data sink function, set with @ref ESP8266_SetDataSink */
+#endif
 } ESP8266_Connection_t;
 
 /**
@@ -374,7 +522,7 @@ typedef struct {
 /**
  * @brief  Main ESP8266 working structure
  */
-typedef struct {
+typedef struct _ESP8266_t {
 	uint32_t Baudrate;                                        /*!< Currently used baudrate for ESP module */
 	uint32_t ActiveCommand;                                   /*!< Currently active AT command for module */
 	char ActiveCommandResponse[5][64];                        /*!< List of responses we expect with AT command */
@@ -405,6 +553,24 @@ typedef struct {
 	uint32_t TotalBytesReceived;                              /*!< Total number of bytes ESP8266 module has received from network and sent to our stack */
 	uint32_t TotalBytesSent;                                  /*!< Total number of network data bytes we have sent to ESP8266 module for transmission */
 	ESP8266_Connection_t* SendDataConnection;                 /*!< Pointer to currently active connection to sent data */
+	uint8_t SendScheduleIndex;                                /*!< Connection index which has turn in send scheduler */
+#if ESP8266_USE_PASSIVE_RECEIVE
+	ESP8266_Connection_t* ReceiveDataConnection;              /*!< Pointer to connection with active AT+CIPRECVDATA command */
+	uint16_t ReceiveDataLength;                               /*!< Number of bytes requested with active AT+CIPRECVDATA command */
+#endif
+	uint16_t ServerPort;                                      /*!< Server port set with @ref ESP8266_ServerEnable, 0 if server was not enabled. Used to enable server again after transparent mode */
+#if ESP8266_USE_TRANSPARENT
+	uint8_t TransparentState;                                 /*!< Current step of transparent mode start or stop */
+	char* TransparentLocation;                                /*!< Server for transparent mode, used until connection is started */
+	uint16_t TransparentPort;                                 /*!< Server port for transparent mode */
+#endif
+	const ESP8266_Handler_t* ServerHandler;                   /*!< Protocol handler for new server connections or NULL when callback functions are used */
+#if ESP8266_USE_BUFFER_POOL
+	uint32_t BufferPoolMisses;                                /*!< Number of +IPD packets without free block in buffer pool. Connection of first dropped packet is closed */
+#endif
+#if ESP8266_USE_WRITEBUFFER
+	uint32_t TotalHandshakesSaved;                            /*!< Total number of AT+CIPSEND cycles saved by collecting writes in write buffers */
+#endif
 	union {
 		struct {
 			uint8_t STAIPIsSet:1;                             /*!< IP is set */
@@ -419,6 +585,7 @@ typedef struct {
 			uint8_t LastOperationStatus:1;                    /*!< Last operations status was OK */
 			uint8_t WifiConnected:1;                          /*!< Wifi is connected to network */
 			uint8_t WifiGotIP:1;                              /*!< Wifi got IP address from network */
+			uint8_t InCallback:1;                             /*!< Received data callback is in progress */
 		} F;
 		uint32_t Value;
 	} Flags;
@@ -604,6 +771,15 @@ ESP8266_Result_t ESP8266_ServerEnable(ESP8266_t* ESP8266, uint16_t port);
  */
 ESP8266_Result_t ESP8266_ServerDisable(ESP8266_t* ESP8266);
 
+/**
+ * @brief  Sets protocol handler for server connections
+ * @note   Handler is attached to each new server connection. Connections which are already active keep their handler
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Handler: Pointer to @ref ESP8266_Handler_t handler or NULL to use server callback functions
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_SetServerHandler(ESP8266_t* ESP8266, const ESP8266_Handler_t* Handler);
+
 /**
  * @brief  Sets server timeout value for connections waiting ESP to respond. This applies for all clients which connects to ESP module
  * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
@@ -723,6 +899,23 @@ ESP8266_Result_t ESP8266_Ping(ESP8266_t* ESP8266, char* addr);
  */
 ESP8266_Result_t ESP8266_StartClientConnection(ESP8266_t* ESP8266, char* name, char* location, uint16_t port, void* user_parameters);
 
+/**
+ * @brief  Starts new UDP link with given remote address and local port
+ * @note   Link is reported as client connection, with connected callback when module opens it.
+ *         Each +IPD packet is one datagram. Source IP and port of datagram are saved to RemoteIP and RemotePort members of connection
+ *         and data received callback is called for datagram alone, with @arg LastPart set on its last part.
+ *         Received data are not parsed as HTTP.
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *name: Identification connection name for callback functions to detect proper connection
+ * @param  *location: Domain name or IP address of remote peer as string
+ * @param  port: Remote port
+ * @param  local_port: Local port to receive datagrams on or 0 to let module choose it
+ * @param  mode: Remote peer mode, member of @ref ESP8266_UDPMode_t enumeration. Used only when local_port is set
+ * @param  *user_parameters: Pointer to custom user parameters (if needed) which will later be passed to callback functions for client connection
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_StartUDPConnection(ESP8266_t* ESP8266, char* name, char* location, uint16_t port, uint16_t local_port, ESP8266_UDPMode_t mode, void* user_parameters);
+
 /**
  * @brief  Closes all opened connections
  * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
@@ -732,6 +925,7 @@ ESP8266_Result_t ESP8266_CloseAllConnections(ESP8266_t* ESP8266);
 
 /**
  * @brief  Closes specific previously opened connection
+ * @note   When module is busy, close is done later from @ref ESP8266_Update function
  * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
  * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure to close it
  * @return Member of @ref ESP8266_Result_t enumeration
@@ -745,14 +939,312 @@ ESP8266_Result_t ESP8266_CloseConnection(ESP8266_t* ESP8266, ESP8266_Connection_
  */
 ESP8266_Result_t ESP8266_AllConectionsClosed(ESP8266_t* ESP8266);
 
+/**
+ * @brief  Sets send priority for connection
+ * @note   When multiple connections have data to send, connection with priority N
+ *         sends N times more bytes in one scheduler round than connection with priority 1.
+ *         Use higher priority for control connections and lower for background uploads.
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure to set priority for
+ * @param  priority: Connection priority, between 1 and 255. Value 0 is the same as 1
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_SetConnectionPriority(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t priority);
+
 /**
  * @brief  Makes a request to send data to specific open connection
+ * @note   Request is queued and data are sent when send scheduler gives turn to connection.
+ *         Send data callback is called when module is ready to accept data
+ * @note   Each connection has single send slot, shared with @ref ESP8266_RequestSendStream, @ref ESP8266_RequestSendSegments
+ *         and @ref ESP8266_RequestSendDatagram. Requests are not queued behind each other: while previous request is waiting or being sent,
+ *         new request on the same connection returns ESP_BUSY and must be repeated after data sent (or data sent error) callback
  * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
  * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure to close it
- * @return Member of @ref ESP8266_Result_t enumeration
+ * @return Member of @ref ESP8266_Result_t enumeration. ESP_BUSY is returned while connection is still sending previous request
  */
 ESP8266_Result_t ESP8266_RequestSendData(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
 
+/**
+ * @brief  Makes a request to send stream of data to specific open connection
+ * @note   Data are split into chunks of @ref ESP8266_SEND_CHUNK_SIZE bytes. Each chunk is sent in separate AT+CIPSEND cycle
+ *         and next chunk is requested by send scheduler when module returns "SEND OK" for previous one.
+ *
+ *         For every chunk, send data callback is called with max_buffer_size set to exact number of bytes module expects.
+ *         Callback must fill exactly that number of bytes, starting at stream offset set in @ref ESP8266_Connection_t.SendOffset.
+ *
+ *         When entire stream is sent, data sent callback is called only once.
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure to send data to
+ * @param  length: Total number of bytes in stream
+ * @return Member of @ref ESP8266_Result_t enumeration. ESP_BUSY is returned while connection is still sending previous request
+ */
+ESP8266_Result_t ESP8266_RequestSendStream(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint32_t length);
+
+/**
+ * @brief  Makes a request to send data from array of memory segments to specific open connection
+ * @note   Data are sent directly from segments to ESP8266 module without copying them to any buffer.
+ *         Segments can be located anywhere, for example constant HTTP header in flash and dynamic body in RAM.
+ *
+ *         Data are sent in multiple AT+CIPSEND cycles of up to @ref ESP8266_SEND_CHUNK_SIZE bytes.
+ *         Send data callbacks are not called, data sent callback is called when all segments are sent.
+ * @note   Segments array and memory it points to must stay valid until data sent (or data sent error) callback is called
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure to send data to
+ * @param  *Segments: Pointer to array of @ref ESP8266_Segment_t segments
+ * @param  count: Number of segments in array
+ * @return Member of @ref ESP8266_Result_t enumeration. ESP_BUSY is returned while connection is still sending previous request
+ */
+ESP8266_Result_t ESP8266_RequestSendSegments(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const ESP8266_Segment_t* Segments, uint8_t count);
+
+/**
+ * @brief  Makes a request to send one datagram on UDP link
+ * @note   Datagram is sent directly from user memory in single AT+CIPSEND cycle, so it is never split or merged with other data.
+ *         Data must stay valid until data sent (or data sent error) callback is called.
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t UDP link
+ * @param  *data: Pointer to datagram data
+ * @param  length: Number of bytes in datagram, up to @ref ESP8266_SEND_CHUNK_SIZE
+ * @param  *ip: Pointer to 4 bytes of remote IP address or NULL to send to remote of link
+ * @param  port: Remote port. Used only when ip is set
+ * @return Member of @ref ESP8266_Result_t enumeration. ESP_BUSY is returned while connection is still sending previous request
+ */
+ESP8266_Result_t ESP8266_RequestSendDatagram(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const void* data, uint16_t length, const uint8_t* ip, uint16_t port);
+
+#if ESP8266_USE_WRITEBUFFER || defined(DOXYGEN)
+/**
+ * @brief  Writes data to connection write buffer
+ * @note   Data are not sent immediately. Write buffer is flushed in single AT+CIPSEND cycle when
+ *         it has at least @ref ESP8266_WRITEBUFFER_THRESHOLD bytes, when first byte waits for @ref ESP8266_WRITEBUFFER_TIMEOUT milliseconds
+ *         or when @ref ESP8266_Flush is called.
+ *
+ *         Data sent callback is not called for write buffer. Data sent error callback is called if flush fails.
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure to write data to
+ * @param  *data: Pointer to data to write
+ * @param  length: Number of bytes to write
+ * @return Member of @ref ESP8266_Result_t enumeration:
+ *            - ESP_OK: Data written to buffer
+ *            - ESP_BUSY: Not enough free memory in buffer, try again after flush
+ * @note   @ref ESP8266_USE_WRITEBUFFER must be enabled for this feature
+ */
+ESP8266_Result_t ESP8266_Write(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const void* data, uint16_t length);
+
+/**
+ * @brief  Requests to send all data from connection write buffer
+ * @note   Flush starts immediately if module is idle, or later from @ref ESP8266_Update function
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure to flush write buffer for
+ * @return Member of @ref ESP8266_Result_t enumeration
+ * @note   @ref ESP8266_USE_WRITEBUFFER must be enabled for this feature
+ */
+ESP8266_Result_t ESP8266_Flush(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+#endif
+
+#if ESP8266_USE_PASSIVE_RECEIVE || defined(DOXYGEN)
+/**
+ * @brief  Puts connection receive on hold or releases it
+ * @note   When on hold, stack does not read data for connection from module.
+ *         Module keeps data and remote side is slowed down by TCP flow control.
+ *         Reading continues when hold is released
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure
+ * @param  hold: Set to 1 to stop reading data or 0 to continue
+ * @return Member of @ref ESP8266_Result_t enumeration
+ * @note   @ref ESP8266_USE_PASSIVE_RECEIVE must be enabled for this feature
+ */
+ESP8266_Result_t ESP8266_SetReceiveHold(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t hold);
+#endif
+
+#if ESP8266_USE_BUFFER_POOL || defined(DOXYGEN)
+/**
+ * @brief  Sets maximal number of receive buffer pool blocks connection can take
+ * @note   Bigger limit means less parts for big +IPD packets, smaller limit leaves more blocks for other connections
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure
+ * @param  blocks: Number of blocks, between 1 and @ref ESP8266_BUFFER_POOL_BLOCKS
+ * @return Member of @ref ESP8266_Result_t enumeration
+ * @note   @ref ESP8266_USE_BUFFER_POOL must be enabled for this feature
+ */
+ESP8266_Result_t ESP8266_SetConnectionBufferBlocks(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t blocks);
+#endif
+
+#if ESP8266_USE_RECEIVE_STREAM || defined(DOXYGEN)
+/**
+ * @brief  Reads received data from connection receive stream
+ * @note   Function can be called at any time, also after connection was closed until new connection is made on the same number
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure
+ * @param  *data: Pointer to memory to save data to
+ * @param  count: Maximal number of bytes to read
+ * @return Number of bytes read
+ * @note   @ref ESP8266_USE_RECEIVE_STREAM must be enabled for this feature
+ */
+uint16_t ESP8266_Read(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, void* data, uint16_t count);
+
+/**
+ * @brief  Gets number of bytes available in connection receive stream
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure
+ * @return Number of bytes ready to read
+ * @note   @ref ESP8266_USE_RECEIVE_STREAM must be enabled for this feature
+ */
+uint16_t ESP8266_Available(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+
+/**
+ * @brief  Reads received data from connection receive stream without removing them
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure
+ * @param  *data: Pointer to memory to save data to
+ * @param  count: Maximal number of bytes to copy
+ * @return Number of bytes copied
+ * @note   @ref ESP8266_USE_RECEIVE_STREAM must be enabled for this feature
+ */
+uint16_t ESP8266_Peek(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, void* data, uint16_t count);
+
+/**
+ * @brief  Removes received data from connection receive stream without reading them
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure
+ * @param  count: Maximal number of bytes to remove
+ * @return Number of bytes removed
+ * @note   @ref ESP8266_USE_RECEIVE_STREAM must be enabled for this feature
+ */
+uint16_t ESP8266_Skip(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint16_t count);
+#endif
+
+#if ESP8266_USE_PINGPONG_RECEIVE || defined(DOXYGEN)
+/**
+ * @brief  Keeps current data buffer after data received callback returns
+ * @note   Function must be called from data received callback. Stack continues to receive data to other buffer half.
+ *         When both halves are held, stack does not read from module until one of them is released
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure
+ * @return Member of @ref ESP8266_Result_t enumeration
+ * @note   @ref ESP8266_USE_PINGPONG_RECEIVE must be enabled for this feature
+ */
+ESP8266_Result_t ESP8266_HoldData(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+
+/**
+ * @brief  Releases data buffer previously kept with @ref ESP8266_HoldData function
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure
+ * @param  *Buffer: Pointer to buffer as received in data received callback
+ * @return Member of @ref ESP8266_Result_t enumeration
+ * @note   @ref ESP8266_USE_PINGPONG_RECEIVE must be enabled for this feature
+ */
+ESP8266_Result_t ESP8266_ReleaseData(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer);
+#endif
+
+/**
+ * @brief  Starts parsing new HTTP head on connection
+ * @note   Head is parsed automatically on first data of connection.
+ *         Use this function when connection is reused for another HTTP message
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_ResetHeaders(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+
+/**
+ * @brief  Parses HTTP head from part of received data
+ * @note   Stack parses head from beginning of received data only. When data contain end of one HTTP message
+ *         and start of next one, for example with pipelined responses, call @ref ESP8266_ResetHeaders
+ *         and then this function with data of next message. @ref ESP8266_Connection_t.BodyOffset is set relative to data
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure
+ * @param  *data: Pointer to data with HTTP head
+ * @param  length: Number of bytes in data
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_ParseHeaders(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const char* data, uint16_t length);
+
+/**
+ * @brief  Checks if string starts with header name or token, case insensitive
+ * @note   Used by protocol modules to check header lines passed to connection handler
+ * @param  *str: Pointer to string to check, for example header line
+ * @param  *name: Pointer to name in lower case, for example "content-length:"
+ * @retval 1 when string starts with name, 0 otherwise
+ */
+uint8_t ESP8266_HeaderMatch(const char* str, const char* name);
+
+/**
+ * @brief  Skips spaces and tabs at start of string, for example before header value
+ * @param  *str: Pointer to string
+ * @retval Pointer to first character which is not space or tab
+ */
+const char* ESP8266_SkipSpaces(const char* str);
+
+/**
+ * @brief  Parses unsigned decimal number
+ * @param  **str: Pointer to string pointer. String pointer is moved to first character after number
+ * @retval Parsed number or 0 when string does not start with digit
+ */
+uint32_t ESP8266_ParseDecimal(const char** str);
+
+/**
+ * @brief  Writes unsigned decimal number as string with termination
+ * @param  *buffer: Pointer to buffer with at least 11 bytes of space
+ * @param  num: Number to write
+ * @retval Pointer to termination of string in buffer
+ */
+char* ESP8266_NumberToString(char* buffer, uint32_t num);
+
+#if ESP8266_USE_DATA_SINK || defined(DOXYGEN)
+/**
+ * @brief  Sets data sink for connection
+ * @note   When sink is set, received data are passed to sink directly from USART buffer in one or more parts.
+ *         Data received callback is called at the end of each +IPD packet with number of bytes in @arg DataSize only,
+ *         data buffer is not valid in this case
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Connection: Pointer to @ref ESP8266_Connection_t structure
+ * @param  sink: Sink function or NULL to receive data to connection buffer again
+ * @return Member of @ref ESP8266_Result_t enumeration
+ * @note   @ref ESP8266_USE_DATA_SINK must be enabled for this feature
+ */
+ESP8266_Result_t ESP8266_SetDataSink(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, ESP8266_DataSink_t sink);
+#endif
+
+#if ESP8266_USE_TRANSPARENT || defined(DOXYGEN)
+/**
+ * @brief  Connects to server and starts transparent transmission mode
+ * @note   This function is not blocking. All connections must be closed before it is called.
+ *         Server is disabled, single connection mode is set and connection to server is made, step by step from @ref ESP8266_Update.
+ *         When mode is active, @ref ESP8266_Callback_TransparentConnected is called. After that, all received data are passed
+ *         to @ref ESP8266_Callback_TransparentDataReceived callback function and @ref ESP8266_TransparentSend function must be used to send data.
+ *         Other commands are not available until mode is left and @ref ESP8266_Callback_TransparentClosed is called.
+ *         When any step fails, mode is left the same way as with @ref ESP8266_TransparentStop, without connected callback.
+ *         When no data are sent or received for @ref ESP8266_TRANSPARENT_TIMEOUT milliseconds, mode is left from @ref ESP8266_Update
+ *         the same way as with @ref ESP8266_TransparentStop and @ref ESP8266_Callback_TransparentTimeout is called.
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *location: Domain name or IP address of server. It must be valid until connected or closed callback is called
+ * @param  port: Server port
+ * @return Member of @ref ESP8266_Result_t enumeration
+ * @note   @ref ESP8266_USE_TRANSPARENT must be enabled for this feature
+ */
+ESP8266_Result_t ESP8266_TransparentStart(ESP8266_t* ESP8266, char* location, uint16_t port);
+
+/**
+ * @brief  Sends raw data to server in transparent transmission mode
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *data: Pointer to data to send
+ * @param  length: Number of bytes to send
+ * @return Member of @ref ESP8266_Result_t enumeration
+ * @note   @ref ESP8266_USE_TRANSPARENT must be enabled for this feature
+ */
+ESP8266_Result_t ESP8266_TransparentSend(ESP8266_t* ESP8266, const void* data, uint16_t length);
+
+/**
+ * @brief  Leaves transparent transmission mode and closes connection
+ * @note   This function is not blocking. @ref ESP8266_Update waits @ref ESP8266_TRANSPARENT_GUARD_TIME milliseconds before and after "+++" sequence,
+ *         then restores multiple connections mode and server if it was enabled before @ref ESP8266_TransparentStart call.
+ *         All steps are done even if one of them fails. @ref ESP8266_Callback_TransparentClosed is called at the end
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @return Member of @ref ESP8266_Result_t enumeration. ESP_BUSY is returned while mode is being started or left
+ * @note   @ref ESP8266_USE_TRANSPARENT must be enabled for this feature
+ */
+ESP8266_Result_t ESP8266_TransparentStop(ESP8266_t* ESP8266);
+#endif
+
 /**
  * @brief  Gets a list of connected station devices to softAP on ESP module
  * @note   If function succedded, @ref ESP8266_Callback_ConnectedStationsDetected will be called when data are available
@@ -779,6 +1271,10 @@ uint16_t ESP8266_DataReceived(uint8_t* ch, uint16_t count);
  * @brief    Library callback functions
  *           
  *           Callback functions are called from ESP stack to user which should implement it when needs it.
+ *
+ *           Data received callbacks and connection handlers are called while stack is processing received data,
+ *           so commands can not be started from them. Only send requests and connection close are queued,
+ *           other functions return ESP_BUSY.
  * @{
  */
  
@@ -886,6 +1382,11 @@ void ESP8266_Callback_ServerConnectionClosed(ESP8266_t* ESP8266, ESP8266_Connect
  * @param  *Connection: Pointer to \ref ESP8266_Connection_t connection 
  * @retval None
  * @note   With weak parameter to prevent link errors if not defined by user
+ * @note   Callback is called as soon as data are received, even if another command is active.
+ *         Blocking functions must not be used inside this callback.
+ *         Send requests (ESP8266_RequestSend functions and @ref ESP8266_Write) and @ref ESP8266_CloseConnection
+ *         are queued and executed later from @ref ESP8266_Update. Functions which only change connection settings,
+ *         such as @ref ESP8266_SetDataSink, can also be used. All other functions return ESP_BUSY and must be called again from main loop
  */
 void ESP8266_Callback_ServerConnectionDataReceived(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer);
 
@@ -994,9 +1495,28 @@ void ESP8266_Callback_ClientConnectionDataSentError(ESP8266_t* ESP8266, ESP8266_
  * @param  *Connection: Pointer to \ref ESP8266_Connection_t connection 
  * @retval None
  * @note   With weak parameter to prevent link errors if not defined by user
+ * @note   Callback is called as soon as data are received, even if another command is active.
+ *         Blocking functions must not be used inside this callback.
+ *         Send requests (ESP8266_RequestSend functions and @ref ESP8266_Write) and @ref ESP8266_CloseConnection
+ *         are queued and executed later from @ref ESP8266_Update. Functions which only change connection settings,
+ *         such as @ref ESP8266_SetDataSink, can also be used. All other functions return ESP_BUSY and must be called again from main loop
  */
 void ESP8266_Callback_ClientConnectionDataReceived(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer);
 
+#if ESP8266_USE_BUFFER_POOL || defined(DOXYGEN)
+/**
+ * @brief  Received data were dropped because buffer pool had no free block
+ * @note   Connection can not continue with missing data, so it is closed and closed callback is called after that.
+ *         When connection has protocol handler, its Error function is called instead
+ * @param  *ESP8266: Pointer to working \ref ESP8266_t structure
+ * @param  *Connection: Pointer to \ref ESP8266_Connection_t connection
+ * @retval None
+ * @note   With weak parameter to prevent link errors if not defined by user
+ * @note   @ref ESP8266_USE_BUFFER_POOL must be enabled for this feature
+ */
+void ESP8266_Callback_ConnectionDataLost(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+#endif
+
 /**
  * @brief  Pinging to external server has started
  * @param  *ESP8266: Pointer to working \ref ESP8266_t structure
@@ -1015,6 +1535,45 @@ void ESP8266_Callback_PingStarted(ESP8266_t* ESP8266, char* address);
  */
 void ESP8266_Callback_PingFinished(ESP8266_t* ESP8266, ESP8266_Ping_t* PING);
 
+/**
+ * @brief  Raw data received in transparent transmission mode
+ * @param  *ESP8266: Pointer to working \ref ESP8266_t structure
+ * @param  *Buffer: Pointer to received data
+ * @param  length: Number of received bytes
+ * @retval None
+ * @note   With weak parameter to prevent link errors if not defined by user
+ */
+void ESP8266_Callback_TransparentDataReceived(ESP8266_t* ESP8266, uint8_t* Buffer, uint16_t length);
+
+/**
+ * @brief  Transparent transmission mode was left because no data were sent or received
+ *         for @ref ESP8266_TRANSPARENT_TIMEOUT milliseconds
+ * @note   Mode is left the same way as with @ref ESP8266_TransparentStop call and @ref ESP8266_Callback_TransparentClosed is called at the end
+ * @param  *ESP8266: Pointer to working \ref ESP8266_t structure
+ * @retval None
+ * @note   With weak parameter to prevent link errors if not defined by user
+ */
+void ESP8266_Callback_TransparentTimeout(ESP8266_t* ESP8266);
+
+/**
+ * @brief  Connection to server is made and transparent transmission mode is active
+ * @note   Data can be sent with @ref ESP8266_TransparentSend function from now on
+ * @param  *ESP8266: Pointer to working \ref ESP8266_t structure
+ * @retval None
+ * @note   With weak parameter to prevent link errors if not defined by user
+ */
+void ESP8266_Callback_TransparentConnected(ESP8266_t* ESP8266);
+
+/**
+ * @brief  Transparent transmission mode was left or could not be started
+ * @note   Stack is back in AT command mode with multiple connections. When server could not be enabled again,
+ *         @ref ESP8266_t.ServerPort is set to 0
+ * @param  *ESP8266: Pointer to working \ref ESP8266_t structure
+ * @retval None
+ * @note   With weak parameter to prevent link errors if not defined by user
+ */
+void ESP8266_Callback_TransparentClosed(ESP8266_t* ESP8266);
+
 /**
  * @brief  Firmware update status checking
  * @note   You must use \ref ESP8266_FirmwareUpdate function to start updating
@@ -80,6 +80,206 @@
  */
 #define ESP8266_CONNECTION_BUFFER_SIZE             5842
 
+/**
+ * @brief   Enables receive buffer pool for connections.
+ *
+ *          Instead of one shared buffer or separate buffer of @ref ESP8266_CONNECTION_BUFFER_SIZE bytes for each connection,
+ *          connections take blocks from common pool when +IPD data starts and return them after data received callback or on close.
+ *          All connections can receive at the same time, while RAM usage is only @ref ESP8266_BUFFER_POOL_BLOCKS * @ref ESP8266_BUFFER_POOL_BLOCK_SIZE bytes.
+ *          When pool has no free block for +IPD data, data are dropped and connection is closed, see @ref ESP8266_Callback_ConnectionDataLost.
+ *
+ *          When enabled, @ref ESP8266_USE_SINGLE_CONNECTION_BUFFER and @ref ESP8266_CONNECTION_BUFFER_SIZE are not used
+ */
+#define ESP8266_USE_BUFFER_POOL                   0
+
+/**
+ * @brief   Size of one block in receive buffer pool in units of bytes
+ *
+ * @note    Block must be at least 256 bytes or there might be unexpected results
+ */
+#define ESP8266_BUFFER_POOL_BLOCK_SIZE             512
+
+/**
+ * @brief   Number of blocks in receive buffer pool
+ */
+#define ESP8266_BUFFER_POOL_BLOCKS                 8
+
+/**
+ * @brief   Default maximal number of blocks one connection can take from pool.
+ *
+ *          When +IPD data packet is bigger than connection buffer, data are received to user in multiple parts.
+ *          Limit can be changed for each connection with @ref ESP8266_SetConnectionBufferBlocks function
+ */
+#define ESP8266_BUFFER_POOL_CONNECTION_BLOCKS      4
+
+/**
+ * @brief   Enables (1) or disables (0) ping-pong receive buffers.
+ *
+ *          Connection data buffer is split into 2 halves. When application calls @ref ESP8266_HoldData in data received callback,
+ *          buffer is kept until @ref ESP8266_ReleaseData is called and stack continues to receive data to other half.
+ *          This allows application to process one half while stack fills another one.
+ *
+ * @note    @ref ESP8266_USE_SINGLE_CONNECTION_BUFFER and @ref ESP8266_USE_BUFFER_POOL must be disabled for this feature
+ *          and @ref ESP8266_CONNECTION_BUFFER_SIZE must be at least 512 bytes
+ */
+#define ESP8266_USE_PINGPONG_RECEIVE               0
+
+/**
+ * @brief   Enables (1) or disables (0) data sinks for connections.
+ *
+ *          When sink is set with @ref ESP8266_SetDataSink function, +IPD data are passed to sink directly from USART buffer,
+ *          without copying them to connection data buffer. Data received callback only reports number of bytes received.
+ *          Useful for downloads directly to external memory.
+ */
+#define ESP8266_USE_DATA_SINK                      0
+
+/**
+ * @brief   Maximal length of HTTP header line stack keeps when parsing HTTP head of received data.
+ *
+ *          Longer lines are cut. Content-Length, Transfer-Encoding and Connection headers are also parsed from the kept part only,
+ *          so value which continues after the cut (for example "chunked" at the end of long Transfer-Encoding list) is not detected.
+ *          Size must be large enough for these header lines.
+ *          Resumable downloads also need entire "Content-Range" header with 32-bit offsets, which is up to 53 characters long
+ */
+#define ESP8266_HEADER_LINE_SIZE                   64
+
+/**
+ * @brief   Maximal length of HTTP request or status line stack keeps when parsing HTTP head of received data.
+ *
+ *          Request line contains method, path with query and HTTP version, so it is usually much longer than header lines.
+ *          Header lines are kept in the same buffer of each connection, so value must not be smaller than @ref ESP8266_HEADER_LINE_SIZE.
+ *          Server with @ref ESP8266_HTTPD answers requests with longer lines with "414 URI Too Long"
+ */
+#define ESP8266_REQUEST_LINE_SIZE                  128
+
+/**
+ * @brief   Buffer size for data user fills in send data callback functions.
+ *
+ *          This buffer is used only for outgoing data and is shared between all connections,
+ *          because only one connection can send data to ESP8266 module at a time.
+ *          Incoming +IPD data can not overwrite data which are prepared for sending.
+ *
+ * @note    Buffer should be at least 2046 bytes to fill entire AT+CIPSEND cycle. Smaller buffer results in more cycles
+ */
+#define ESP8266_SEND_BUFFER_SIZE                   2048
+
+/**
+ * @brief   Maximal number of bytes stack sends to ESP8266 module in one AT+CIPSEND cycle
+ *          when data are sent as stream using @ref ESP8266_RequestSendStream function.
+ *
+ *          Stream is split into chunks of this size and chunks are sent one after another,
+ *          without returning to user between them.
+ *
+ * @note    ESP8266 accepts up to 2048 bytes in one AT+CIPSEND command.
+ *          When data are filled in callback, value is also limited with @ref ESP8266_SEND_BUFFER_SIZE
+ */
+#define ESP8266_SEND_CHUNK_SIZE                    2048
+
+/**
+ * @brief   Number of bytes connection with priority 1 can send in one round of send scheduler.
+ *
+ *          When multiple connections have data to send, they are served in round robin order.
+ *          Connection with priority N can send N times this number of bytes in one round
+ */
+#define ESP8266_SEND_QUANTUM                       512
+
+/**
+ * @brief   Enables (1) or disables (0) buffered sending using AT+CIPSENDBUF command.
+ *
+ *          When enabled, streams and segments are sent using AT+CIPSENDBUF command.
+ *          Stack does not wait for "SEND OK" after each chunk, instead it keeps up to @ref ESP8266_SENDBUF_WINDOW
+ *          chunks in ESP8266 buffer per connection and tracks acknowledge for each of them using segment ID.
+ *
+ * @note    ESP8266 AT software must support AT+CIPSENDBUF command
+ */
+#define ESP8266_USE_SENDBUF                        0
+
+/**
+ * @brief   Maximal number of chunks which are sent to ESP8266 and are waiting for acknowledge on one connection
+ *
+ * @note    @ref ESP8266_USE_SENDBUF must be enabled for this feature
+ */
+#define ESP8266_SENDBUF_WINDOW                     4
+
+/**
+ * @brief   Enables (1) or disables (0) per connection write buffer for small writes.
+ *
+ *          When enabled, @ref ESP8266_Write function collects small writes to connection buffer
+ *          and sends them together in single AT+CIPSEND cycle
+ */
+#define ESP8266_USE_WRITEBUFFER                    0
+
+/**
+ * @brief   Size of write buffer in units of bytes for each connection
+ *
+ * @note    @ref ESP8266_USE_WRITEBUFFER must be enabled for this feature
+ */
+#define ESP8266_WRITEBUFFER_SIZE                   512
+
+/**
+ * @brief   Number of bytes in write buffer when flush starts automatically
+ *
+ * @note    @ref ESP8266_USE_WRITEBUFFER must be enabled for this feature
+ */
+#define ESP8266_WRITEBUFFER_THRESHOLD              256
+
+/**
+ * @brief   Maximal time in milliseconds first written byte can wait in write buffer before flush starts automatically
+ *
+ * @note    @ref ESP8266_USE_WRITEBUFFER must be enabled for this feature
+ */
+#define ESP8266_WRITEBUFFER_TIMEOUT                20
+
+/**
+ * @brief   Enables (1) or disables (0) passive receive mode with AT+CIPRECVMODE=1 command.
+ *
+ *          In passive mode, module keeps received data and only notifies stack about it.
+ *          Stack reads data with AT+CIPRECVDATA command when connection buffer is free and receive is not on hold.
+ *          When data are not read, TCP window on module gets full and remote side slows down.
+ *
+ * @note    ESP8266 AT software must support AT+CIPRECVMODE command
+ */
+#define ESP8266_USE_PASSIVE_RECEIVE                0
+
+/**
+ * @brief   Enables (1) or disables (0) receive stream for each connection.
+ *
+ *          Received data are saved to cyclic buffer of connection and application reads them
+ *          at any time with @ref ESP8266_Read function, also outside data received callbacks.
+ *          Together with @ref ESP8266_USE_PASSIVE_RECEIVE, stack reads from module only as much data as there is free space in stream.
+ */
+#define ESP8266_USE_RECEIVE_STREAM                 0
+
+/**
+ * @brief   Size of receive stream for each connection in units of bytes. Stream can hold 1 byte less than its size
+ *
+ * @note    @ref ESP8266_USE_RECEIVE_STREAM must be enabled for this feature
+ */
+#define ESP8266_RECEIVE_STREAM_SIZE                1024
+
+/**
+ * @brief   Enables (1) or disables (0) transparent transmission mode.
+ *
+ *          In transparent mode, only one connection to server is active and data are sent and received
+ *          without AT+CIPSEND and +IPD framing
+ */
+#define ESP8266_USE_TRANSPARENT                    0
+
+/**
+ * @brief   Time in milliseconds without data before and after "+++" sequence to leave transparent mode
+ *
+ * @note    @ref ESP8266_USE_TRANSPARENT must be enabled for this feature
+ */
+#define ESP8266_TRANSPARENT_GUARD_TIME             1000
+
+/**
+ * @brief   Time in milliseconds without sent or received data after which transparent mode is left, 0 to disable
+ *
+ * @note    Mode is left from @ref ESP8266_Update the same way as with @ref ESP8266_TransparentStop call
+ * @note    @ref ESP8266_USE_TRANSPARENT must be enabled for this feature
+ */
+#define ESP8266_TRANSPARENT_TIMEOUT                60000
+
 /**
  * @brief   Enables (1) or disables (0) pinging functionality to other servers
  *
@@ -0,0 +1,561 @@
+/**
+ * |----------------------------------------------------------------------
+ * | Copyright (C) Tilen Majerle, 2016
+ * |
+ * | This program is free software: you can redistribute it and/or modify
+ * | it under the terms of the GNU General Public License as published by
+ * | the Free Software Foundation, either version 3 of the License, or
+ * | any later version.
+ * |
+ * | This program is distributed in the hope that it will be useful,
+ * | but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * | MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * | GNU General Public License for more details.
+ * |
+ * | You should have received a copy of the GNU General Public License
+ * | along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * |----------------------------------------------------------------------
+ */
+#include "esp8266_download.h"
+
+/* Download and part states */
+#define DOWNLOAD_STATE_IDLE            0
+#define DOWNLOAD_STATE_WAIT            1
+#define DOWNLOAD_STATE_REQUEST         2
+#define DOWNLOAD_STATE_RUNNING         3
+
+/* Response check results */
+#define DOWNLOAD_RESPONSE_UNKNOWN      0
+#define DOWNLOAD_RESPONSE_ACCEPTED     1
+#define DOWNLOAD_RESPONSE_REJECTED     2
+
+/* Value of range start when response has no "Content-Range" header */
+#define DOWNLOAD_RANGE_NONE            0xFFFFFFFFUL
+
+/* Private functions */
+static void InitPart(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download, ESP8266_DOWNLOAD_Part_t* Part, uint32_t offset, uint32_t end);
+static void StartRequest(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_Part_t* Part);
+static void Failed(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_Part_t* Part);
+static void Cancel(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download, ESP8266_DOWNLOAD_Result_t result);
+static void Restart(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download);
+static void AbortParts(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download);
+static void CheckFinished(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download);
+static void Finish(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download, ESP8266_DOWNLOAD_Result_t result);
+static void CheckResponse(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_Part_t* Part);
+static void Split(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download);
+static void UpdateOffset(ESP8266_DOWNLOAD_t* Download);
+static uint8_t PartReceived(ESP8266_DOWNLOAD_Part_t* Part);
+static void RequestHeader(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const char* line);
+static void RequestSink(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const uint8_t* data, uint16_t length);
+static void RequestDone(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, ESP8266_HTTP_Result_t result);
+static void SaveValidator(ESP8266_DOWNLOAD_Part_t* Part, const char* value);
+static char* AddString(char* buffer, const char* str);
+
+/******************************************/
+/*             Public functions           */
+/******************************************/
+ESP8266_Result_t ESP8266_DOWNLOAD_Start(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download) {
+	/* Check if download is already in progress */
+	if (Download->State != DOWNLOAD_STATE_IDLE) {
+		return ESP_BUSY;
+	}
+	
+	/* Check parameters */
+	if (Download->Host == NULL || Download->Path == NULL || Download->Sink == NULL) {
+		return ESP_ERROR;
+	}
+	
+	/* Reset download */
+	Download->Stop = 0;
+	Download->Restart = 0;
+	Download->Result = ESP8266_DOWNLOAD_OK;
+	Download->State = DOWNLOAD_STATE_RUNNING;
+	
+	/* First part asks for entire rest of resource */
+	Download->PartsCount = 1;
+	InitPart(ESP8266, Download, &Download->Parts[0], Download->Offset, 0);
+	
+	/* Start first attempt now or with update function */
+	return ESP8266_DOWNLOAD_Update(ESP8266, Download);
+}
+
+ESP8266_Result_t ESP8266_DOWNLOAD_Update(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download) {
+	ESP8266_DOWNLOAD_Part_t* Part;
+	uint8_t i;
+	
+	/* Repeat requests of HTTP client on new connection */
+	ESP8266_HTTP_Update(ESP8266);
+	
+	/* Start next attempt of each part when delay expires */
+	for (i = 0; i < Download->PartsCount && Download->State != DOWNLOAD_STATE_IDLE; i++) {
+		Part = &Download->Parts[i];
+		if (
+			Part->State == DOWNLOAD_STATE_WAIT &&
+			(ESP8266->Time - Part->RetryTime) >= Part->Wait
+		) {
+			StartRequest(ESP8266, Part);
+		}
+	}
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+ESP8266_Result_t ESP8266_DOWNLOAD_Stop(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download) {
+	/* Stop all parts */
+	if (Download->State != DOWNLOAD_STATE_IDLE) {
+		Cancel(ESP8266, Download, ESP8266_DOWNLOAD_STOPPED);
+	}
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+uint8_t ESP8266_DOWNLOAD_IsBusy(ESP8266_DOWNLOAD_t* Download) {
+	/* Download is busy until done function is called */
+	return Download->State != DOWNLOAD_STATE_IDLE;
+}
+
+/******************************************/
+/*            Private functions           */
+/******************************************/
+static void InitPart(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download, ESP8266_DOWNLOAD_Part_t* Part, uint32_t offset, uint32_t end) {
+	/* Set range of part */
+	Part->Download = Download;
+	Part->Offset = offset;
+	Part->End = end;
+	
+	/* First attempt is started without delay */
+	Part->Retries = 0;
+	Part->Wait = 0;
+	Part->RetryTime = ESP8266->Time;
+	Part->State = DOWNLOAD_STATE_WAIT;
+}
+
+static void StartRequest(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_Part_t* Part) {
+	ESP8266_DOWNLOAD_t* Download = Part->Download;
+	ESP8266_HTTP_Request_t* Request = &Part->Request;
+	ESP8266_Result_t result;
+	char* ptr = Part->Headers;
+	
+	/* Ask only for part which was not received yet, range response also tells if resource can be split */
+	*ptr = 0;
+	if (Part->Offset || Part->End || Download->Links > 1) {
+		ptr = AddString(ptr, "Range: bytes=");
+		ptr = ESP8266_NumberToString(ptr, Part->Offset);
+		ptr = AddString(ptr, "-");
+		if (Part->End) {
+			ptr = ESP8266_NumberToString(ptr, Part->End - 1);
+		}
+		ptr = AddString(ptr, "\r\n");
+		
+		/* Part is sent only when resource was not changed */
+		if (Download->Validator[0]) {
+			ptr = AddString(ptr, "If-Range: ");
+			ptr = AddString(ptr, Download->Validator);
+			ptr = AddString(ptr, "\r\n");
+		}
+	}
+	
+	/* Prepare request, connection is kept open for next parts */
+	memset(Request, 0, sizeof(ESP8266_HTTP_Request_t));
+	Request->Host = Download->Host;
+	Request->Port = Download->Port;
+	Request->Path = Download->Path;
+	Request->Headers = Part->Headers;
+	Request->Sink = RequestSink;
+	Request->Done = RequestDone;
+	Request->Header = RequestHeader;
+	Request->UserParameters = Part;
+	Request->KeepAlive = 1;
+	
+	/* Reset response informations */
+	Part->Accepted = DOWNLOAD_RESPONSE_UNKNOWN;
+	Part->Progress = 0;
+	Part->RangeStart = DOWNLOAD_RANGE_NONE;
+	Part->RangeSize = 0;
+	Part->NewValidator[0] = 0;
+	
+	/* Start request */
+	result = ESP8266_HTTP_Request(ESP8266, Request);
+	if (result == ESP_OK) {
+		Part->State = DOWNLOAD_STATE_REQUEST;
+	} else if (result != ESP_BUSY) {
+		/* Request can not be started, busy stack is tried again on next update */
+		Failed(ESP8266, Part);
+	}
+}
+
+static void Failed(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_Part_t* Part) {
+	ESP8266_DOWNLOAD_t* Download = Part->Download;
+	
+	/* Download is stopped or starts again */
+	if (Download->Stop || Download->Restart) {
+		Part->State = DOWNLOAD_STATE_IDLE;
+		CheckFinished(ESP8266, Download);
+		return;
+	}
+	
+	/* Attempt which received data starts retries from beginning */
+	if (Part->Progress) {
+		Part->Retries = 0;
+	}
+	
+	/* Check number of failed attempts in a row */
+	if (Part->Retries < 0xFF) {
+		Part->Retries++;
+	}
+	if (Download->MaxRetries && Part->Retries >= Download->MaxRetries) {
+		Part->State = DOWNLOAD_STATE_IDLE;
+		Cancel(ESP8266, Download, ESP8266_DOWNLOAD_ERROR_RETRIES);
+		return;
+	}
+	
+	/* Delay is doubled after each failed attempt */
+	if (Part->Retries == 1) {
+		Part->Wait = Download->RetryDelay ? Download->RetryDelay : ESP8266_DOWNLOAD_RETRY_DELAY;
+	} else {
+		Part->Wait *= 2;
+	}
+	if (Part->Wait > ESP8266_DOWNLOAD_MAX_RETRY_DELAY) {
+		Part->Wait = ESP8266_DOWNLOAD_MAX_RETRY_DELAY;
+	}
+	
+	/* Wait for next attempt */
+	Part->RetryTime = ESP8266->Time;
+	Part->State = DOWNLOAD_STATE_WAIT;
+}
+
+static void Cancel(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download, ESP8266_DOWNLOAD_Result_t result) {
+	/* First reason is result of download */
+	if (!Download->Stop) {
+		Download->Stop = 1;
+		Download->Result = result;
+	}
+	
+	/* Stop other parts */
+	AbortParts(ESP8266, Download);
+	CheckFinished(ESP8266, Download);
+}
+
+static void Restart(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download) {
+	/* Start again when all parts are stopped */
+	Download->Restart = 1;
+	AbortParts(ESP8266, Download);
+	CheckFinished(ESP8266, Download);
+}
+
+static void AbortParts(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download) {
+	uint8_t i;
+	
+	/* Parts waiting for next attempt are stopped now */
+	for (i = 0; i < Download->PartsCount; i++) {
+		if (Download->Parts[i].State == DOWNLOAD_STATE_WAIT) {
+			Download->Parts[i].State = DOWNLOAD_STATE_IDLE;
+		}
+	}
+	
+	/* Requests in progress are stopped when their connections are closed */
+	for (i = 0; i < Download->PartsCount; i++) {
+		if (Download->Parts[i].State == DOWNLOAD_STATE_REQUEST) {
+			ESP8266_HTTP_Abort(ESP8266, &Download->Parts[i].Request);
+		}
+	}
+}
+
+static void CheckFinished(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download) {
+	uint8_t i;
+	
+	/* Download was already finished */
+	if (Download->State == DOWNLOAD_STATE_IDLE) {
+		return;
+	}
+	
+	/* Wait for all parts */
+	for (i = 0; i < Download->PartsCount; i++) {
+		if (Download->Parts[i].State != DOWNLOAD_STATE_IDLE) {
+			return;
+		}
+	}
+	
+	/* Resource was changed, start from beginning on one connection */
+	if (Download->Restart && !Download->Stop) {
+		Download->Restart = 0;
+		Download->Offset = 0;
+		Download->Size = 0;
+		Download->Validator[0] = 0;
+		Download->PartsCount = 1;
+		InitPart(ESP8266, Download, &Download->Parts[0], 0, 0);
+		return;
+	}
+	
+	/* All parts are finished */
+	Finish(ESP8266, Download, Download->Stop ? (ESP8266_DOWNLOAD_Result_t)Download->Result : ESP8266_DOWNLOAD_OK);
+}
+
+static void Finish(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download, ESP8266_DOWNLOAD_Result_t result) {
+	/* Download is not in progress anymore */
+	Download->State = DOWNLOAD_STATE_IDLE;
+	Download->Stop = 0;
+	Download->Restart = 0;
+	
+	/* Notify user */
+	if (Download->Done != NULL) {
+		Download->Done(ESP8266, Download, result);
+	}
+}
+
+static void CheckResponse(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_Part_t* Part) {
+	ESP8266_DOWNLOAD_t* Download = Part->Download;
+	ESP8266_HTTP_Request_t* Request = &Part->Request;
+	
+	/* Response was already checked */
+	if (Part->Accepted != DOWNLOAD_RESPONSE_UNKNOWN) {
+		return;
+	}
+	
+	/* Check response status */
+	if (Request->StatusCode == 206 && Part->RangeStart == Part->Offset) {
+		/* Part continues where previous attempt stopped */
+		if (Part->RangeSize) {
+			Download->Size = Part->RangeSize;
+		} else if (!Part->End && !Request->Chunked && Request->ContentLength) {
+			Download->Size = Part->Offset + Request->ContentLength;
+		}
+	} else if (Request->StatusCode == 200 && Download->PartsCount == 1) {
+		/* Entire resource, it was changed or server does not support ranges */
+		Part->Offset = 0;
+		Part->End = 0;
+		Download->Offset = 0;
+		Download->Size = Request->Chunked ? 0 : Request->ContentLength;
+		Download->Validator[0] = 0;
+	} else {
+		/* Response is not part of resource */
+		Part->Accepted = DOWNLOAD_RESPONSE_REJECTED;
+		return;
+	}
+	Part->Accepted = DOWNLOAD_RESPONSE_ACCEPTED;
+	
+	/* Save validator for next attempts */
+	if (Part->NewValidator[0]) {
+		strcpy(Download->Validator, Part->NewValidator);
+	}
+	
+	/* Size is known, split rest of resource to parts */
+	if (Request->StatusCode == 206 && Download->PartsCount == 1) {
+		Split(ESP8266, Download);
+	}
+}
+
+static void Split(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download) {
+	ESP8266_DOWNLOAD_Part_t* Part = &Download->Parts[0];
+	uint32_t remaining, length;
+	uint8_t count, i;
+	
+	/* Check if resource can be split */
+	if (Download->Links < 2 || !Download->Size || Part->Offset >= Download->Size) {
+		return;
+	}
+	
+	/* Get number of parts, each part must be big enough */
+	remaining = Download->Size - Part->Offset;
+	count = Download->Links > ESP8266_DOWNLOAD_MAX_LINKS ? ESP8266_DOWNLOAD_MAX_LINKS : Download->Links;
+	while (count > 1 && (remaining / count) < ESP8266_DOWNLOAD_MIN_PART_SIZE) {
+		count--;
+	}
+	if (count < 2) {
+		return;
+	}
+	
+	/* First part continues on current connection */
+	length = remaining / count;
+	Part->End = Part->Offset + length;
+	
+	/* Other parts are started with update function, last part gets the rest */
+	for (i = 1; i < count; i++) {
+		InitPart(ESP8266, Download, &Download->Parts[i], Download->Parts[i - 1].End, i == (count - 1) ? Download->Size : Download->Parts[i - 1].End + length);
+	}
+	Download->PartsCount = count;
+}
+
+static void UpdateOffset(ESP8266_DOWNLOAD_t* Download) {
+	uint8_t i;
+	
+	/* Data without gaps end in first part which is not received yet */
+	for (i = 0; i < Download->PartsCount; i++) {
+		if (!PartReceived(&Download->Parts[i])) {
+			Download->Offset = Download->Parts[i].Offset;
+			return;
+		}
+	}
+	
+	/* All parts are received */
+	Download->Offset = Download->Parts[Download->PartsCount - 1].End;
+}
+
+static uint8_t PartReceived(ESP8266_DOWNLOAD_Part_t* Part) {
+	/* Only part with end is received before its response is finished */
+	return Part->End && Part->Offset >= Part->End;
+}
+
+static void RequestHeader(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const char* line) {
+	ESP8266_DOWNLOAD_Part_t* Part = (ESP8266_DOWNLOAD_Part_t *)Request->UserParameters;
+	
+	/* Cut line can not be used for validator or range */
+	if (strlen(line) >= (ESP8266_HEADER_LINE_SIZE - 1)) {
+		if (ESP8266_HeaderMatch(line, "content-range:")) {
+			Part->RangeStart = DOWNLOAD_RANGE_NONE;
+		}
+		return;
+	}
+	
+	/* Check headers we are interested in */
+	if (ESP8266_HeaderMatch(line, "etag:")) {
+		/* Weak tags can not be used in "If-Range" header */
+		line = ESP8266_SkipSpaces(line + 5);
+		if (!ESP8266_HeaderMatch(line, "w/")) {
+			SaveValidator(Part, line);
+		}
+	} else if (ESP8266_HeaderMatch(line, "last-modified:")) {
+		/* Tag is used when both are present */
+		if (!Part->NewValidator[0]) {
+			SaveValidator(Part, ESP8266_SkipSpaces(line + 14));
+		}
+	} else if (ESP8266_HeaderMatch(line, "content-range:")) {
+		/* Format is "bytes first-last/size", first and last are asterisk when range is not satisfiable */
+		line = ESP8266_SkipSpaces(line + 14);
+		if (ESP8266_HeaderMatch(line, "bytes ")) {
+			line = ESP8266_SkipSpaces(line + 6);
+			if (*line >= '0' && *line <= '9') {
+				Part->RangeStart = ESP8266_ParseDecimal(&line);
+			}
+			line = strchr(line, '/');
+			if (line != NULL && line[1] >= '0' && line[1] <= '9') {
+				line++;
+				Part->RangeSize = ESP8266_ParseDecimal(&line);
+			}
+		}
+	}
+}
+
+static void RequestSink(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const uint8_t* data, uint16_t length) {
+	ESP8266_DOWNLOAD_Part_t* Part = (ESP8266_DOWNLOAD_Part_t *)Request->UserParameters;
+	ESP8266_DOWNLOAD_t* Download = Part->Download;
+	
+	/* Check response with first data, body of other responses is not needed */
+	CheckResponse(ESP8266, Part);
+	if (Part->Accepted != DOWNLOAD_RESPONSE_ACCEPTED) {
+		ESP8266_HTTP_Abort(ESP8266, Request);
+		return;
+	}
+	if (Download->Stop || Download->Restart) {
+		return;
+	}
+	
+	/* Response may continue after end of part */
+	if (Part->End && length > (Part->End - Part->Offset)) {
+		length = Part->End - Part->Offset;
+	}
+	
+	/* Pass data to user and save checkpoint */
+	if (length) {
+		Download->Sink(ESP8266, Download, Part->Offset, data, length);
+		Part->Offset += length;
+		Part->Progress = 1;
+		UpdateOffset(Download);
+	}
+	
+	/* Close connection when part is received before end of response */
+	if (
+		PartReceived(Part) &&
+		(Request->Chunked || !Request->ContentLength || (Part->RangeStart + Request->ContentLength) > Part->End)
+	) {
+		ESP8266_HTTP_Abort(ESP8266, Request);
+	}
+}
+
+static void RequestDone(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, ESP8266_HTTP_Result_t result) {
+	ESP8266_DOWNLOAD_Part_t* Part = (ESP8266_DOWNLOAD_Part_t *)Request->UserParameters;
+	ESP8266_DOWNLOAD_t* Download = Part->Download;
+	
+	/* Response without body is checked here */
+	CheckResponse(ESP8266, Part);
+	Part->State = DOWNLOAD_STATE_IDLE;
+	
+	/* Download is stopped or starts again */
+	if (Download->Stop || Download->Restart) {
+		CheckFinished(ESP8266, Download);
+		return;
+	}
+	
+	/* Response was part of resource */
+	if (Part->Accepted == DOWNLOAD_RESPONSE_ACCEPTED) {
+		if (
+			PartReceived(Part) ||
+			(result == ESP8266_HTTP_OK && !Part->End && (!Download->Size || Part->Offset >= Download->Size))
+		) {
+			/* Part is received */
+			CheckFinished(ESP8266, Download);
+		} else if (result == ESP8266_HTTP_OK) {
+			/* Server sent only part of the rest, continue with next attempt now */
+			InitPart(ESP8266, Download, Part, Part->Offset, Part->End);
+		} else {
+			/* Connection failed, try again later */
+			Failed(ESP8266, Part);
+		}
+		return;
+	}
+	
+	/* Range is not satisfiable */
+	if (Request->StatusCode == 416) {
+		if (Download->PartsCount == 1 && Part->Offset && Part->RangeSize == Part->Offset) {
+			/* Entire resource was already received */
+			Download->Size = Part->Offset;
+			CheckFinished(ESP8266, Download);
+		} else {
+			/* Resource was changed */
+			Restart(ESP8266, Download);
+		}
+		return;
+	}
+	
+	/* Resource was changed while parts are received */
+	if (Request->StatusCode == 200) {
+		Restart(ESP8266, Download);
+		return;
+	}
+	
+	/* Server does not send range which was requested, next attempt would get the same */
+	if (Request->StatusCode == 206) {
+		Cancel(ESP8266, Download, ESP8266_DOWNLOAD_ERROR_RANGE);
+		return;
+	}
+	
+	/* No response, server errors and rate limits are temporary */
+	if (
+		Request->StatusCode == 0 || Request->StatusCode >= 500 ||
+		Request->StatusCode == 408 || Request->StatusCode == 429
+	) {
+		Failed(ESP8266, Part);
+		return;
+	}
+	
+	/* Any other response is error */
+	Cancel(ESP8266, Download, ESP8266_DOWNLOAD_ERROR_STATUS);
+}
+
+static void SaveValidator(ESP8266_DOWNLOAD_Part_t* Part, const char* value) {
+	/* Line fits to validator, because it is not longer than header line */
+	strcpy(Part->NewValidator, value);
+}
+
+static char* AddString(char* buffer, const char* str) {
+	/* Copy string with termination */
+	while (*str) {
+		*buffer++ = *str++;
+	}
+	*buffer = 0;
+	
+	/* Return pointer to termination */
+	return buffer;
+}
@@ -0,0 +1,282 @@
+/**
+ * @author  Tilen Majerle
+ * @email   tilen@majerle.eu
+ * @website http://stm32f4-discovery.com
+ * @link
+ * @version v0.2
+ * @ide     Keil uVision
+ * @license GNU GPL v3
+ * @brief   Resumable HTTP downloads on top of ESP8266 HTTP client
+ *
+\verbatim
+   ----------------------------------------------------------------------
+    Copyright (C) Tilen Majerle, 2016
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------
+\endverbatim
+ */
+#ifndef ESP8266_DOWNLOAD_H
+#define ESP8266_DOWNLOAD_H 002
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup ESP8266_DOWNLOAD
+ * @brief    Resumable HTTP downloads on top of ESP8266 HTTP client
+ * @{
+ *
+ * Module downloads large resource with GET requests and passes it to sink function together with offset of data in resource.
+ * Nothing is buffered in module, data go from connection buffer directly to sink.
+ *
+ * \par Resume
+ *
+ * Number of bytes passed to sink is saved in @ref ESP8266_DOWNLOAD_t.Offset. When connection fails,
+ * request is started again with "Range: bytes=Offset-" header and download continues where it stopped.
+ * Application can save offset and validator to non-volatile memory and fill them before @ref ESP8266_DOWNLOAD_Start
+ * to continue download after reset.
+ *
+ * \par Validation
+ *
+ * "ETag" or "Last-Modified" header of first response is saved as validator and sent back in "If-Range" header.
+ * When resource was changed on server, server sends entire new resource and download starts from offset 0.
+ * Sink is called with offset 0 again, so application knows it has to drop data it has.
+ *
+ * \par Retries
+ *
+ * Failed attempt is repeated after delay, which is doubled after each failure up to @ref ESP8266_DOWNLOAD_MAX_RETRY_DELAY.
+ * When attempt received any data, delay and retries counter start from beginning.
+ * Delays are timed with @ref ESP8266_DOWNLOAD_Update function, which must be called periodically.
+ * It also calls @ref ESP8266_HTTP_Update function.
+ *
+ * Response with range which does not continue download is not retried, download finishes with @ref ESP8266_DOWNLOAD_ERROR_RANGE.
+ *
+ * \par Parallel download
+ *
+ * When @ref ESP8266_DOWNLOAD_t.Links is more than 1, resource is split into parts which are received at the same time on separate connections.
+ * First request asks for entire rest of resource. When server responds with range and resource size, rest is split into equal parts
+ * and requests for other parts are started. First connection is closed when it receives its part.
+ * Each part is resumed and retried separately and done function is called when all parts are received.
+ *
+ * Sink receives data of parts as they arrive, so offsets are not in order. @ref ESP8266_DOWNLOAD_t.Offset is end of data
+ * received without gaps from start of resource and download is resumed from there.
+ *
+ * \par Changelog
+ *
+\verbatim
+ Version 0.2
+  - Parallel download of parts on multiple connections
+  - Response with wrong range finishes download with error instead of retrying
+
+ Version 0.1
+  - First release
+\endverbatim
+ *
+ * \par Dependencies
+ *
+\verbatim
+ - ESP8266 stack
+ - ESP8266 HTTP client
+\endverbatim
+ */
+
+/* Include HTTP client */
+#include "esp8266_http.h"
+
+/* Check values, "Content-Range: bytes 4294967295-4294967295/4294967295" must not be cut */
+#if ESP8266_HEADER_LINE_SIZE < 54
+#error ESP8266_HEADER_LINE_SIZE must be at least 54 for resumable downloads!
+#endif
+
+/**
+ * @defgroup ESP8266_DOWNLOAD_Macros
+ * @brief    Library defines
+ * @{
+ */
+
+/**
+ * @brief  Default delay in milliseconds before first retry, used when @ref ESP8266_DOWNLOAD_t.RetryDelay is 0
+ */
+#define ESP8266_DOWNLOAD_RETRY_DELAY        500
+
+/**
+ * @brief  Maximal delay in milliseconds between retries
+ */
+#define ESP8266_DOWNLOAD_MAX_RETRY_DELAY    30000
+
+/**
+ * @brief  Size of validator buffer including string termination. Longer validators are not used
+ */
+#define ESP8266_DOWNLOAD_VALIDATOR_SIZE     ESP8266_HEADER_LINE_SIZE
+
+/**
+ * @brief  Maximal number of parts downloaded at the same time. Each part uses one connection
+ */
+#define ESP8266_DOWNLOAD_MAX_LINKS          4
+
+/**
+ * @brief  Minimal size of part in units of bytes. Smaller resources are split to less parts
+ */
+#define ESP8266_DOWNLOAD_MIN_PART_SIZE      8192
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup ESP8266_DOWNLOAD_Typedefs
+ * @brief    Library Typedefs
+ * @{
+ */
+
+/**
+ * @brief  Download result enumeration
+ */
+typedef enum {
+	ESP8266_DOWNLOAD_OK = 0x00,     /*!< Entire resource was received */
+	ESP8266_DOWNLOAD_ERROR_STATUS,  /*!< Server responded with error status code which is not temporary */
+	ESP8266_DOWNLOAD_ERROR_RETRIES, /*!< Maximal number of retries without progress was reached */
+	ESP8266_DOWNLOAD_STOPPED,       /*!< Download was stopped with @ref ESP8266_DOWNLOAD_Stop function */
+	ESP8266_DOWNLOAD_ERROR_RANGE    /*!< Server responded with range which does not continue download */
+} ESP8266_DOWNLOAD_Result_t;
+
+/* Forward declaration */
+struct _ESP8266_DOWNLOAD_t;
+
+/**
+ * @brief  Function which receives downloaded data
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Download: Pointer to @ref ESP8266_DOWNLOAD_t download
+ * @param  offset: Offset of data in resource. When it is 0 after resume, resource was changed and download started again
+ * @param  *data: Pointer to data
+ * @param  length: Number of bytes in data
+ */
+typedef void (*ESP8266_DOWNLOAD_Sink_t)(ESP8266_t* ESP8266, struct _ESP8266_DOWNLOAD_t* Download, uint32_t offset, const uint8_t* data, uint16_t length);
+
+/**
+ * @brief  Function which is called when download is finished
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Download: Pointer to @ref ESP8266_DOWNLOAD_t download
+ * @param  result: Member of @ref ESP8266_DOWNLOAD_Result_t enumeration
+ */
+typedef void (*ESP8266_DOWNLOAD_Done_t)(ESP8266_t* ESP8266, struct _ESP8266_DOWNLOAD_t* Download, ESP8266_DOWNLOAD_Result_t result);
+
+/**
+ * @brief  Part of resource downloaded on one connection
+ */
+typedef struct {
+	uint32_t Offset;              /*!< Offset of next byte of part */
+	uint32_t End;                 /*!< Offset after last byte of part, 0 when part ends with resource */
+	uint8_t Retries;              /*!< Number of failed attempts in a row */
+	uint8_t State;                /*!< Part state. Private member */
+	uint8_t Accepted;             /*!< Response of current attempt was checked. Private member */
+	uint8_t Progress;             /*!< Set to 1 when current attempt received data. Private member */
+	uint32_t RetryTime;           /*!< Time when waiting for next attempt started. Private member */
+	uint32_t Wait;                /*!< Time in milliseconds to wait for next attempt. Private member */
+	uint32_t RangeStart;          /*!< First byte of "Content-Range" header of response. Private member */
+	uint32_t RangeSize;           /*!< Resource size from "Content-Range" header of response. Private member */
+	char NewValidator[ESP8266_DOWNLOAD_VALIDATOR_SIZE]; /*!< Validator of current response. Private member */
+	char Headers[ESP8266_DOWNLOAD_VALIDATOR_SIZE + 50]; /*!< "Range" and "If-Range" header lines. Private member */
+	ESP8266_HTTP_Request_t Request; /*!< HTTP request for current attempt. Private member */
+	struct _ESP8266_DOWNLOAD_t* Download; /*!< Download part belongs to. Private member */
+} ESP8266_DOWNLOAD_Part_t;
+
+/**
+ * @brief  Download structure
+ * @note   Structure must stay valid until done function is called
+ */
+typedef struct _ESP8266_DOWNLOAD_t {
+	const char* Host;             /*!< Server host name or IP address */
+	uint16_t Port;                /*!< Server port. When 0, port 80 is used */
+	const char* Path;             /*!< Path to resource */
+	ESP8266_DOWNLOAD_Sink_t Sink; /*!< Function which receives data */
+	ESP8266_DOWNLOAD_Done_t Done; /*!< Function called when download is finished or NULL */
+	void* UserParameters;         /*!< User parameters pointer */
+	uint8_t MaxRetries;           /*!< Maximal number of failed attempts in a row. When 0, download is repeated until stopped */
+	uint32_t RetryDelay;          /*!< Delay in milliseconds before first retry. When 0, @ref ESP8266_DOWNLOAD_RETRY_DELAY is used */
+	uint8_t Links;                /*!< Maximal number of connections used at the same time. When 0 or 1, resource is received on one connection */
+	uint32_t Offset;              /*!< Number of bytes received without gaps from start of resource. Can be set before start to resume download */
+	uint32_t Size;                /*!< Size of resource when known, 0 otherwise */
+	char Validator[ESP8266_DOWNLOAD_VALIDATOR_SIZE]; /*!< "ETag" or "Last-Modified" value of resource. Can be set before start to resume download */
+	uint8_t State;                /*!< Download state. Private member */
+	uint8_t Stop;                 /*!< Set to 1 when download should be finished without waiting for parts. Private member */
+	uint8_t Restart;              /*!< Set to 1 when download should start again from beginning. Private member */
+	uint8_t Result;               /*!< Result of download when it is stopped. Private member */
+	uint8_t PartsCount;           /*!< Number of parts in use. Private member */
+	ESP8266_DOWNLOAD_Part_t Parts[ESP8266_DOWNLOAD_MAX_LINKS]; /*!< Parts of resource. Private member */
+} ESP8266_DOWNLOAD_t;
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup ESP8266_DOWNLOAD_Functions
+ * @brief    Library Functions
+ * @{
+ */
+
+/**
+ * @brief  Starts or resumes download
+ * @note   When @ref ESP8266_DOWNLOAD_t.Offset is not 0, download continues from this offset.
+ *         First request is started immediately when possible, otherwise with @ref ESP8266_DOWNLOAD_Update function
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Download: Pointer to @ref ESP8266_DOWNLOAD_t structure with download parameters
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_DOWNLOAD_Start(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download);
+
+/**
+ * @brief  Starts next attempt of download when retry delay expires
+ * @note   Function must be called periodically while download is in progress
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Download: Pointer to @ref ESP8266_DOWNLOAD_t structure
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_DOWNLOAD_Update(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download);
+
+/**
+ * @brief  Stops download
+ * @note   Requests in progress are aborted and done function is called when their connections are closed.
+ *         Offset and validator stay valid and can be used to resume download later
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Download: Pointer to @ref ESP8266_DOWNLOAD_t structure
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_DOWNLOAD_Stop(ESP8266_t* ESP8266, ESP8266_DOWNLOAD_t* Download);
+
+/**
+ * @brief  Checks if download is in progress
+ * @param  *Download: Pointer to @ref ESP8266_DOWNLOAD_t structure
+ * @return 1 if download is in progress, 0 otherwise
+ */
+uint8_t ESP8266_DOWNLOAD_IsBusy(ESP8266_DOWNLOAD_t* Download);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
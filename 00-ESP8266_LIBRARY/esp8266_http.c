@@ -0,0 +1,1239 @@
+/**
+ * |----------------------------------------------------------------------
+ * | Copyright (C) Tilen Majerle, 2016
+ * |
+ * | This program is free software: you can redistribute it and/or modify
+ * | it under the terms of the GNU General Public License as published by
+ * | the Free Software Foundation, either version 3 of the License, or
+ * | any later version.
+ * |
+ * | This program is distributed in the hope that it will be useful,
+ * | but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * | MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * | GNU General Public License for more details.
+ * |
+ * | You should have received a copy of the GNU General Public License
+ * | along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * |----------------------------------------------------------------------
+ */
+#include "esp8266_http.h"
+
+/* Request states */
+#define HTTP_STATE_IDLE                0
+#define HTTP_STATE_QUEUED              1
+#define HTTP_STATE_SENDING             2
+#define HTTP_STATE_HEAD                3
+#define HTTP_STATE_BODY                4
+#define HTTP_STATE_RETRY               5
+
+/* Chunked decoder states */
+#define HTTP_CHUNK_SIZE_FIRST          0
+#define HTTP_CHUNK_SIZE                1
+#define HTTP_CHUNK_EXTENSION           2
+#define HTTP_CHUNK_DATA                3
+#define HTTP_CHUNK_DATA_END            4
+#define HTTP_CHUNK_TRAILER             5
+#define HTTP_CHUNK_TRAILER_LINE        6
+#define HTTP_CHUNK_ERROR               7
+
+/* Cache states of response */
+#define HTTP_CACHE_NONE                0
+#define HTTP_CACHE_VALIDATOR           1
+#define HTTP_CACHE_BODY                2
+
+/* Pool link informations for each connection */
+typedef struct {
+	uint16_t Port;      /* Server port */
+	uint8_t Connected;  /* Set to 1 when connection is active */
+	uint8_t Closing;    /* Set to 1 when connection will not be used anymore */
+	uint32_t LastUsed;  /* Time when link was last used */
+} HTTP_Link_t;
+
+/* Private functions */
+static void HandlerConnected(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void HandlerError(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void HandlerDataSent(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t success);
+static void HandlerDataReceived(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer);
+static void HandlerClosed(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void HandlerHeader(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const char* line);
+static void Finish(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, ESP8266_HTTP_Result_t result);
+static void Complete(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, ESP8266_HTTP_Result_t result);
+static uint8_t Retry(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request);
+static uint8_t IsSafeMethod(ESP8266_HTTP_Request_t* Request);
+static void Attach(ESP8266_Connection_t* Connection, ESP8266_HTTP_Request_t* Request);
+static void Detach(ESP8266_HTTP_Request_t* Request);
+static void SendNext(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static ESP8266_Result_t StartLink(ESP8266_t* ESP8266, const char* host, uint16_t port, ESP8266_HTTP_Request_t* Request);
+static ESP8266_Connection_t* FindLink(ESP8266_t* ESP8266, const char* host, uint16_t port, uint8_t pipeline);
+static uint8_t IsIdleLink(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static uint8_t CanPipeline(ESP8266_Connection_t* Connection);
+static ESP8266_Result_t EvictLink(ESP8266_t* ESP8266);
+static void BuildRequest(ESP8266_HTTP_Request_t* Request);
+static void AddSegment(ESP8266_HTTP_Request_t* Request, const void* data, uint32_t length);
+static void AddString(ESP8266_HTTP_Request_t* Request, const char* str);
+static uint8_t ResponseHasBody(ESP8266_HTTP_Request_t* Request);
+static uint16_t BodyReceived(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const char* data, uint16_t length, uint8_t* done);
+static uint16_t ChunkedDecode(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const char* data, uint16_t length, uint8_t* done);
+static int8_t HexValue(char ch);
+static void PassBody(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const char* data, uint16_t length);
+static void SinkBody(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const uint8_t* data, uint16_t length);
+static ESP8266_HTTP_Result_t BodyResult(ESP8266_HTTP_Request_t* Request);
+static void EncodingHeader(ESP8266_HTTP_Request_t* Request, const char* line);
+static uint32_t CacheKey(ESP8266_HTTP_Request_t* Request);
+static ESP8266_HTTP_CacheEntry_t* CacheFind(ESP8266_HTTP_Request_t* Request);
+static ESP8266_HTTP_CacheEntry_t* CacheAllocate(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request);
+static void CacheHeader(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const char* line);
+static uint8_t CacheResponse(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request);
+static void CacheWrite(ESP8266_HTTP_Request_t* Request, const uint8_t* data, uint16_t length);
+static void CacheComplete(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, ESP8266_HTTP_Result_t result);
+
+/* Connection handler for HTTP client connections */
+static const ESP8266_Handler_t HTTP_Handler = {
+	HandlerConnected,
+	HandlerError,
+	NULL,
+	HandlerDataSent,
+	HandlerDataReceived,
+	HandlerClosed,
+	HandlerHeader,
+	NULL
+};
+
+/* Pool links */
+static HTTP_Link_t Links[ESP8266_MAX_CONNECTIONS];
+
+/* Buffer for body read from cache storage */
+static uint8_t CacheBuffer[ESP8266_HTTP_CACHE_READ_SIZE];
+
+/* Requests waiting to be started again on new connection */
+static ESP8266_HTTP_Request_t* RetryList;
+
+/******************************************/
+/*             Public functions           */
+/******************************************/
+ESP8266_Result_t ESP8266_HTTP_Request(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request) {
+	ESP8266_Connection_t* Connection;
+	
+	/* Check if request is already in progress */
+	if (Request->State != HTTP_STATE_IDLE) {
+		return ESP_BUSY;
+	}
+	
+	/* Check host */
+	if (Request->Host == NULL) {
+		return ESP_ERROR;
+	}
+	
+	/* Reset response informations */
+	Request->Aborted = 0;
+	Request->StatusCode = 0;
+	Request->ContentLength = 0;
+	Request->Chunked = 0;
+	Request->BodyReceived = 0;
+	Request->SinkLength = 0;
+	Request->FromCache = 0;
+	Request->Compressed = 0;
+	
+	/* Only GET requests are cached */
+	Request->CacheState = HTTP_CACHE_NONE;
+	Request->CacheKey = 0;
+	if (Request->Cache != NULL && (Request->Method == NULL || strcmp(Request->Method, "GET") == 0)) {
+		Request->CacheKey = CacheKey(Request);
+	}
+	
+	/* Prepare request segments */
+	BuildRequest(Request);
+	
+	/* Use open connection to the same server, only safe requests are pipelined */
+	if (Request->KeepAlive && (Connection = FindLink(ESP8266, Request->Host, Request->Port, Request->Pipeline && IsSafeMethod(Request))) != NULL) {
+		/* Idle connection used before needs new response parser */
+		if (Connection->UserParameters == NULL && Links[Connection->Number].Connected) {
+			ESP8266_ResetHeaders(ESP8266, Connection);
+		}
+		
+		/* Request can be repeated if connection is closed before response */
+		Request->Reused = Links[Connection->Number].Connected || Connection->UserParameters != NULL;
+		
+		/* Add request to connection queue and send it when connection is ready */
+		Attach(Connection, Request);
+		SendNext(ESP8266, Connection);
+		
+		/* Return OK */
+		return ESP_OK;
+	}
+	
+	/* Start new connection to server */
+	Request->Reused = 0;
+	return StartLink(ESP8266, Request->Host, Request->Port, Request);
+}
+
+ESP8266_Result_t ESP8266_HTTP_Preopen(ESP8266_t* ESP8266, const char* host, uint16_t port) {
+	/* Connection to server already exists */
+	if (FindLink(ESP8266, host, port, 0) != NULL) {
+		return ESP_OK;
+	}
+	
+	/* Start new connection without request */
+	return StartLink(ESP8266, host, port, NULL);
+}
+
+ESP8266_Result_t ESP8266_HTTP_CloseIdle(ESP8266_t* ESP8266) {
+	uint8_t i;
+	
+	/* Close all idle connections */
+	for (i = 0; i < ESP8266_MAX_CONNECTIONS; i++) {
+		if (IsIdleLink(ESP8266, &ESP8266->Connection[i])) {
+			Links[i].Closing = 1;
+			ESP8266_CloseConnection(ESP8266, &ESP8266->Connection[i]);
+		}
+	}
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+ESP8266_Result_t ESP8266_HTTP_Abort(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request) {
+	ESP8266_Connection_t* Connection = Request->Connection;
+	ESP8266_HTTP_Request_t** Prev;
+	
+	/* Request is not in progress or already aborted */
+	if (Request->State == HTTP_STATE_IDLE || Request->Aborted) {
+		return ESP_OK;
+	}
+	Request->Aborted = 1;
+	
+	/* Request waits for retry, remove it from list */
+	if (Request->State == HTTP_STATE_RETRY) {
+		for (Prev = &RetryList; *Prev != NULL; Prev = &(*Prev)->Next) {
+			if (*Prev == Request) {
+				*Prev = Request->Next;
+				break;
+			}
+		}
+		Complete(ESP8266, Request, ESP8266_HTTP_ERROR_ABORTED);
+		return ESP_OK;
+	}
+	
+	/* Request was not sent yet, connection can be used for other requests */
+	if (Request->State == HTTP_STATE_QUEUED) {
+		Detach(Request);
+		Complete(ESP8266, Request, ESP8266_HTTP_ERROR_ABORTED);
+		return ESP_OK;
+	}
+	
+	/* Response can not be skipped, close connection */
+	if (Connection->Active && !Links[Connection->Number].Closing) {
+		Links[Connection->Number].Closing = 1;
+		ESP8266_CloseConnection(ESP8266, Connection);
+	}
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+ESP8266_Result_t ESP8266_HTTP_CacheClear(ESP8266_HTTP_Cache_t* Cache) {
+	uint8_t i;
+	
+	/* Remove all entries */
+	for (i = 0; i < Cache->EntriesCount; i++) {
+		Cache->Entries[i].Key = 0;
+	}
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+ESP8266_Result_t ESP8266_HTTP_Update(ESP8266_t* ESP8266) {
+	ESP8266_HTTP_Request_t** Prev = &RetryList;
+	ESP8266_HTTP_Request_t* Request;
+	ESP8266_HTTP_Request_t* Next;
+	ESP8266_Result_t result;
+	
+	/* Start requests again which were not answered on closed connection */
+	while ((Request = *Prev) != NULL) {
+		Next = Request->Next;
+		Request->Next = NULL;
+		Request->State = HTTP_STATE_IDLE;
+		result = ESP8266_HTTP_Request(ESP8266, Request);
+		
+		/* Module is busy, try again on next update */
+		if (result == ESP_BUSY) {
+			Request->State = HTTP_STATE_RETRY;
+			Request->Next = Next;
+			Prev = &Request->Next;
+			continue;
+		}
+		
+		/* Remove request from list */
+		*Prev = Next;
+		
+		/* Request could not be started */
+		if (result != ESP_OK) {
+			Complete(ESP8266, Request, ESP8266_HTTP_ERROR_CLOSED);
+		}
+	}
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+uint8_t ESP8266_HTTP_IsBusy(ESP8266_HTTP_Request_t* Request) {
+	/* Request is busy until done function is called */
+	return Request->State != HTTP_STATE_IDLE;
+}
+
+/******************************************/
+/*            Connection handler          */
+/******************************************/
+static void HandlerConnected(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	/* Connection is ready for requests */
+	Links[Connection->Number].Connected = 1;
+	Links[Connection->Number].LastUsed = ESP8266->Time;
+	
+	/* Send first queued request, preopened connection stays idle */
+	SendNext(ESP8266, Connection);
+}
+
+static void HandlerError(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	ESP8266_HTTP_Request_t* Request = (ESP8266_HTTP_Request_t *)Connection->UserParameters;
+	ESP8266_HTTP_Request_t* Next;
+	
+	/* Remove link from pool, connection which lost data is still active until it is closed */
+	Links[Connection->Number].Connected = 0;
+	Links[Connection->Number].Closing = Connection->Active;
+	Connection->UserParameters = NULL;
+	
+	/* All queued requests failed */
+	while (Request != NULL) {
+		Next = Request->Next;
+		Complete(ESP8266, Request, ESP8266_HTTP_ERROR_CONNECT);
+		Request = Next;
+	}
+}
+
+static void HandlerDataSent(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t success) {
+	ESP8266_HTTP_Request_t* Request;
+	
+	/* Connection can not be used anymore, queued requests are handled when it is closed */
+	if (!success) {
+		if (Connection->Active && !Links[Connection->Number].Closing) {
+			Links[Connection->Number].Closing = 1;
+			ESP8266_CloseConnection(ESP8266, Connection);
+		}
+		return;
+	}
+	
+	/* Request is sent, wait for response, it might already be in progress */
+	for (Request = (ESP8266_HTTP_Request_t *)Connection->UserParameters; Request != NULL; Request = Request->Next) {
+		if (Request->State == HTTP_STATE_SENDING) {
+			Request->State = HTTP_STATE_HEAD;
+			break;
+		}
+	}
+	
+	/* Send next pipelined request */
+	SendNext(ESP8266, Connection);
+}
+
+static void HandlerDataReceived(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer) {
+	ESP8266_HTTP_Request_t* Request;
+	const char* data = Buffer;
+	uint16_t length = Connection->DataSize, used;
+	uint8_t done;
+	
+	/* Ignore data on connection which is closing */
+	if (Links[Connection->Number].Closing) {
+		return;
+	}
+	
+	/* Responses come in the same order as requests were sent */
+	while (
+		(Request = (ESP8266_HTTP_Request_t *)Connection->UserParameters) != NULL &&
+		Request->State >= HTTP_STATE_SENDING
+	) {
+		done = 0;
+		used = 0;
+		
+		/* Wait for entire response head */
+		if (Request->State != HTTP_STATE_BODY) {
+			if (!Connection->HeadersDone) {
+				/* Data are not HTTP response */
+				if (Connection->BodyOffset < length) {
+					Finish(ESP8266, Request, ESP8266_HTTP_ERROR_PARSE);
+				}
+				return;
+			}
+			
+			/* Save response informations */
+			Request->StatusCode = Connection->StatusCode;
+			Request->ContentLength = Connection->ContentLength;
+			Request->Chunked = Connection->Chunked;
+			Request->ChunkState = HTTP_CHUNK_SIZE_FIRST;
+			Request->ChunkRemaining = 0;
+			Request->State = HTTP_STATE_BODY;
+			
+			/* Check response with cache, body of unchanged resource comes from storage */
+			if (Request->CacheKey && !CacheResponse(ESP8266, Request)) {
+				Finish(ESP8266, Request, ESP8266_HTTP_ERROR_CACHE);
+				return;
+			}
+			
+			/* Response without body is finished with head */
+			done = !ResponseHasBody(Request);
+			
+			/* Compressed body goes through decoder */
+			if (Request->Compressed && done) {
+				Request->Compressed = 0;
+			} else if (Request->Compressed) {
+				ESP8266_INFLATE_Init(Request->Inflate, ESP8266_INFLATE_FORMAT_AUTO);
+				Request->InflateResult = ESP8266_INFLATE_NEED_INPUT;
+			}
+		}
+		
+		/* Process body part of received data */
+		if (!done) {
+			used = BodyReceived(ESP8266, Request, data + Connection->BodyOffset, length - Connection->BodyOffset, &done);
+			if (!done || Request->Aborted) {
+				return;
+			}
+		}
+		
+		/* Skip data of finished response */
+		used += Connection->BodyOffset;
+		data += used;
+		length -= used;
+		
+		/* Finish request */
+		Finish(ESP8266, Request, BodyResult(Request));
+		
+		/* Rest of data is start of next pipelined response */
+		if (length == 0 || Connection->UserParameters == NULL || Links[Connection->Number].Closing) {
+			return;
+		}
+		ESP8266_ParseHeaders(ESP8266, Connection, data, length);
+	}
+}
+
+static void HandlerClosed(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	ESP8266_HTTP_Request_t* Request = (ESP8266_HTTP_Request_t *)Connection->UserParameters;
+	ESP8266_HTTP_Request_t* First = Request;
+	ESP8266_HTTP_Request_t* Next;
+	
+	/* Remove link from pool */
+	Links[Connection->Number].Connected = 0;
+	Links[Connection->Number].Closing = 0;
+	Connection->UserParameters = NULL;
+	
+	/* Check first request, body without length ends when connection is closed */
+	if (
+		Request != NULL && Request->State == HTTP_STATE_BODY &&
+		!Request->Chunked && !Request->ContentLength && !Request->Aborted
+	) {
+		Next = Request->Next;
+		Complete(ESP8266, Request, BodyResult(Request));
+		Request = Next;
+	}
+	
+	/* Requests without response are repeated on new connection when possible */
+	while (Request != NULL) {
+		Next = Request->Next;
+		if (Request->Aborted) {
+			Complete(ESP8266, Request, ESP8266_HTTP_ERROR_ABORTED);
+		} else if (
+			Request->State == HTTP_STATE_BODY ||
+			(Request == First && Connection->HeadersLength) ||
+			!Retry(ESP8266, Request)
+		) {
+			Complete(ESP8266, Request, ESP8266_HTTP_ERROR_CLOSED);
+		}
+		Request = Next;
+	}
+}
+
+static void HandlerHeader(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const char* line) {
+	ESP8266_HTTP_Request_t* Request = (ESP8266_HTTP_Request_t *)Connection->UserParameters;
+	
+	/* Header belongs to first request in queue which waits for response */
+	if (Request == NULL || Request->State < HTTP_STATE_SENDING || Links[Connection->Number].Closing) {
+		return;
+	}
+	
+	/* Check if body is compressed */
+	if (Request->Inflate != NULL) {
+		EncodingHeader(Request, line);
+	}
+	
+	/* Save validator of new resource to cache */
+	if (Request->CacheKey && Connection->StatusCode == 200) {
+		CacheHeader(ESP8266, Request, line);
+	}
+	
+	/* Pass line to user */
+	if (Request->Header != NULL) {
+		Request->Header(ESP8266, Request, line);
+	}
+}
+
+/******************************************/
+/*            Private functions           */
+/******************************************/
+static void Finish(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, ESP8266_HTTP_Result_t result) {
+	ESP8266_Connection_t* Connection = Request->Connection;
+	uint8_t first = Connection->UserParameters == Request;
+	uint8_t keep;
+	
+	/* Check if connection stays open for next requests */
+	keep =
+		Request->KeepAlive && result == ESP8266_HTTP_OK &&
+		Connection->Active && Connection->KeepAlive && !Links[Connection->Number].Closing;
+	
+	/* Remove request from connection queue */
+	Detach(Request);
+	
+	/* Next response starts */
+	if (first) {
+		ESP8266_ResetHeaders(ESP8266, Connection);
+	}
+	
+	/* Keep connection open when server allows it */
+	if (keep) {
+		Links[Connection->Number].LastUsed = ESP8266->Time;
+	} else if (Connection->Active && !Links[Connection->Number].Closing) {
+		/* Close connection, queued requests are handled when it is closed */
+		Links[Connection->Number].Closing = 1;
+		ESP8266_CloseConnection(ESP8266, Connection);
+	}
+	
+	/* Notify user */
+	Complete(ESP8266, Request, result);
+}
+
+static void Complete(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, ESP8266_HTTP_Result_t result) {
+	/* Cache entry is valid only when response was received completely */
+	if (Request->CacheState != HTTP_CACHE_NONE) {
+		CacheComplete(ESP8266, Request, result);
+	}
+	
+	/* Request is not in progress anymore */
+	Request->State = HTTP_STATE_IDLE;
+	Request->Connection = NULL;
+	Request->Next = NULL;
+	
+	/* Notify user */
+	if (Request->Done != NULL) {
+		Request->Done(ESP8266, Request, result);
+	}
+}
+
+static uint8_t Retry(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request) {
+	ESP8266_HTTP_Request_t** Last;
+	
+	/* Only request on connection used before is repeated */
+	if (!Request->Reused) {
+		return 0;
+	}
+	
+	/* Request which was already sent might be processed by server, repeat only safe methods */
+	if (Request->State != HTTP_STATE_QUEUED && !IsSafeMethod(Request)) {
+		return 0;
+	}
+	
+	/* Add request to end of retry list, it is started from update function */
+	Request->State = HTTP_STATE_RETRY;
+	Request->Connection = NULL;
+	Request->Next = NULL;
+	for (Last = &RetryList; *Last != NULL; Last = &(*Last)->Next);
+	*Last = Request;
+	return 1;
+}
+
+static uint8_t IsSafeMethod(ESP8266_HTTP_Request_t* Request) {
+	/* Methods without side effects on server, default method is GET */
+	return
+		Request->Method == NULL ||
+		strcmp(Request->Method, "GET") == 0 ||
+		strcmp(Request->Method, "HEAD") == 0 ||
+		strcmp(Request->Method, "OPTIONS") == 0;
+}
+
+static void Attach(ESP8266_Connection_t* Connection, ESP8266_HTTP_Request_t* Request) {
+	ESP8266_HTTP_Request_t* Last;
+	
+	/* Request waits to be sent */
+	Request->Connection = Connection;
+	Request->Next = NULL;
+	Request->State = HTTP_STATE_QUEUED;
+	
+	/* Add to the end of connection queue */
+	if (Connection->UserParameters == NULL) {
+		Connection->UserParameters = Request;
+	} else {
+		for (Last = (ESP8266_HTTP_Request_t *)Connection->UserParameters; Last->Next != NULL; Last = Last->Next);
+		Last->Next = Request;
+	}
+}
+
+static void Detach(ESP8266_HTTP_Request_t* Request) {
+	ESP8266_HTTP_Request_t* Prev;
+	
+	/* Remove request from connection queue */
+	if (Request->Connection->UserParameters == Request) {
+		Request->Connection->UserParameters = Request->Next;
+	} else {
+		for (Prev = (ESP8266_HTTP_Request_t *)Request->Connection->UserParameters; Prev != NULL; Prev = Prev->Next) {
+			if (Prev->Next == Request) {
+				Prev->Next = Request->Next;
+				break;
+			}
+		}
+	}
+	Request->Next = NULL;
+}
+
+static void SendNext(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	ESP8266_HTTP_Request_t* Request;
+	
+	/* Connection must be ready */
+	if (!Links[Connection->Number].Connected || Links[Connection->Number].Closing) {
+		return;
+	}
+	
+	/* Find first request which was not sent yet, requests are sent one after another */
+	for (Request = (ESP8266_HTTP_Request_t *)Connection->UserParameters; Request != NULL; Request = Request->Next) {
+		if (Request->State == HTTP_STATE_SENDING) {
+			return;
+		}
+		if (Request->State == HTTP_STATE_QUEUED) {
+			break;
+		}
+	}
+	if (Request == NULL) {
+		return;
+	}
+	
+	/* Send request directly from segments */
+	if (ESP8266_RequestSendSegments(ESP8266, Connection, Request->Segments, Request->SegmentsCount) != ESP_OK) {
+		Finish(ESP8266, Request, ESP8266_HTTP_ERROR_SEND);
+		return;
+	}
+	Request->State = HTTP_STATE_SENDING;
+}
+
+static ESP8266_Result_t StartLink(ESP8266_t* ESP8266, const char* host, uint16_t port, ESP8266_HTTP_Request_t* Request) {
+	ESP8266_Connection_t* Connection;
+	ESP8266_Result_t result;
+	uint8_t i;
+	
+	/* Start connection, host is also connection name for pool */
+	result = ESP8266_StartClientConnection(ESP8266, (char *)host, (char *)host, port ? port : 80, NULL);
+	if (result != ESP_OK) {
+		/* Make space when all connections are used */
+		for (i = 0; i < ESP8266_MAX_CONNECTIONS; i++) {
+			if (!ESP8266->Connection[i].Active) {
+				return result;
+			}
+		}
+		return EvictLink(ESP8266);
+	}
+	
+	/* Attach handler to connection */
+	Connection = &ESP8266->Connection[ESP8266->StartConnectionSent];
+	Connection->Handler = &HTTP_Handler;
+	
+	/* Add link to pool */
+	Links[Connection->Number].Port = port ? port : 80;
+	Links[Connection->Number].Connected = 0;
+	Links[Connection->Number].Closing = 0;
+	Links[Connection->Number].LastUsed = ESP8266->Time;
+	
+	/* Request is sent when connection is active */
+	if (Request != NULL) {
+		Attach(Connection, Request);
+	}
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+static ESP8266_Connection_t* FindLink(ESP8266_t* ESP8266, const char* host, uint16_t port, uint8_t pipeline) {
+	uint8_t i;
+	ESP8266_Connection_t* found = NULL;
+	
+	/* Host must fit to connection name to be compared */
+	if (strlen(host) >= sizeof(ESP8266->Connection[0].Name)) {
+		return NULL;
+	}
+	
+	/* Find link to server */
+	for (i = 0; i < ESP8266_MAX_CONNECTIONS; i++) {
+		if (
+			ESP8266->Connection[i].Active && ESP8266->Connection[i].Handler == &HTTP_Handler &&
+			!Links[i].Closing && Links[i].Port == (port ? port : 80) &&
+			strcmp(ESP8266->Connection[i].Name, host) == 0
+		) {
+			/* Idle link is the best choice */
+			if (ESP8266->Connection[i].UserParameters == NULL) {
+				return &ESP8266->Connection[i];
+			}
+			
+			/* Busy link when request can be pipelined */
+			if (pipeline && found == NULL && CanPipeline(&ESP8266->Connection[i])) {
+				found = &ESP8266->Connection[i];
+			}
+		}
+	}
+	
+	/* Return busy link or NULL */
+	return found;
+}
+
+static uint8_t IsIdleLink(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	/* Active HTTP connection without request which is not closing */
+	return
+		Connection->Active &&
+		Connection->Handler == &HTTP_Handler &&
+		Connection->UserParameters == NULL &&
+		!Links[Connection->Number].Closing;
+}
+
+static uint8_t CanPipeline(ESP8266_Connection_t* Connection) {
+	ESP8266_HTTP_Request_t* Request;
+	uint8_t count = 0;
+	
+	/* All requests in queue must allow pipelining and be safe to repeat */
+	for (Request = (ESP8266_HTTP_Request_t *)Connection->UserParameters; Request != NULL; Request = Request->Next) {
+		if (!Request->Pipeline || !Request->KeepAlive || !IsSafeMethod(Request)) {
+			return 0;
+		}
+		count++;
+	}
+	
+	/* Check pipeline depth */
+	return count < ESP8266_HTTP_PIPELINE_DEPTH;
+}
+
+static ESP8266_Result_t EvictLink(ESP8266_t* ESP8266) {
+	uint8_t i;
+	int8_t lru = -1;
+	
+	/* Wait for connection which is already closing */
+	for (i = 0; i < ESP8266_MAX_CONNECTIONS; i++) {
+		if (ESP8266->Connection[i].Active && ESP8266->Connection[i].Handler == &HTTP_Handler && Links[i].Closing) {
+			return ESP_BUSY;
+		}
+	}
+	
+	/* Find least recently used idle link */
+	for (i = 0; i < ESP8266_MAX_CONNECTIONS; i++) {
+		if (
+			IsIdleLink(ESP8266, &ESP8266->Connection[i]) && Links[i].Connected &&
+			(lru < 0 || (ESP8266->Time - Links[i].LastUsed) > (ESP8266->Time - Links[lru].LastUsed))
+		) {
+			lru = i;
+		}
+	}
+	
+	/* There is no idle link to close */
+	if (lru < 0) {
+		return ESP_ERROR;
+	}
+	
+	/* Close it, new connection can be started when it is closed */
+	Links[lru].Closing = 1;
+	ESP8266_CloseConnection(ESP8266, &ESP8266->Connection[lru]);
+	
+	/* Try again later */
+	return ESP_BUSY;
+}
+
+static void BuildRequest(ESP8266_HTTP_Request_t* Request) {
+	ESP8266_HTTP_CacheEntry_t* Entry;
+	
+	/* Reset segments */
+	Request->SegmentsCount = 0;
+	
+	/* Request line */
+	AddString(Request, Request->Method != NULL ? Request->Method : "GET");
+	AddString(Request, " ");
+	AddString(Request, Request->Path != NULL ? Request->Path : "/");
+	AddString(Request, " HTTP/1.1\r\nHost: ");
+	
+	/* Host header, port is added only when not default */
+	AddString(Request, Request->Host);
+	if (Request->Port && Request->Port != 80) {
+		Request->PortString[0] = ':';
+		ESP8266_NumberToString(&Request->PortString[1], Request->Port);
+		AddString(Request, Request->PortString);
+	}
+	AddString(Request, "\r\n");
+	
+	/* Body length */
+	if (Request->Body != NULL && Request->BodyLength) {
+		AddString(Request, "Content-Length: ");
+		ESP8266_NumberToString(Request->LengthString, Request->BodyLength);
+		AddString(Request, Request->LengthString);
+		AddString(Request, "\r\n");
+	}
+	
+	/* Connection is closed after response if not kept alive */
+	if (!Request->KeepAlive) {
+		AddString(Request, "Connection: close\r\n");
+	}
+	
+	/* Compressed response is accepted when there is decoder */
+	if (Request->Inflate != NULL) {
+		AddString(Request, "Accept-Encoding: gzip, deflate\r\n");
+	}
+	
+	/* User headers */
+	if (Request->Headers != NULL) {
+		AddString(Request, Request->Headers);
+	}
+	
+	/* Conditional request when resource is in cache */
+	if (
+		Request->CacheKey && (Entry = CacheFind(Request)) != NULL &&
+		Entry->Valid && (Request->Cache->Write == NULL || Entry->HasBody)
+	) {
+		AddString(Request, Entry->IsTag ? "If-None-Match: " : "If-Modified-Since: ");
+		AddString(Request, Entry->Validator);
+		AddString(Request, "\r\n");
+	}
+	
+	/* End of head */
+	AddString(Request, "\r\n");
+	
+	/* Body */
+	if (Request->Body != NULL) {
+		AddSegment(Request, Request->Body, Request->BodyLength);
+	}
+}
+
+static void AddSegment(ESP8266_HTTP_Request_t* Request, const void* data, uint32_t length) {
+	/* Ignore empty segments */
+	if (length == 0 || Request->SegmentsCount >= ESP8266_HTTP_MAX_SEGMENTS) {
+		return;
+	}
+	
+	/* Save segment */
+	Request->Segments[Request->SegmentsCount].Data = data;
+	Request->Segments[Request->SegmentsCount].Length = length;
+	Request->SegmentsCount++;
+}
+
+static void AddString(ESP8266_HTTP_Request_t* Request, const char* str) {
+	/* Add string without termination */
+	AddSegment(Request, str, strlen(str));
+}
+
+static uint8_t ResponseHasBody(ESP8266_HTTP_Request_t* Request) {
+	/* Response to HEAD request never has body */
+	if (Request->Method != NULL && strcmp(Request->Method, "HEAD") == 0) {
+		return 0;
+	}
+	
+	/* Informational, "No Content" and "Not Modified" responses */
+	if (Request->StatusCode < 200 || Request->StatusCode == 204 || Request->StatusCode == 304) {
+		return 0;
+	}
+	
+	/* Connection stays open and there is no length, body is empty */
+	if (!Request->Chunked && !Request->ContentLength && Request->Connection->KeepAlive) {
+		return 0;
+	}
+	
+	/* Response has body */
+	return 1;
+}
+
+static uint16_t BodyReceived(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const char* data, uint16_t length, uint8_t* done) {
+	/* Decode chunked body */
+	if (Request->Chunked) {
+		return ChunkedDecode(ESP8266, Request, data, length, done);
+	}
+	
+	/* Do not pass more than content length */
+	if (Request->ContentLength && length > (Request->ContentLength - Request->BodyReceived)) {
+		length = Request->ContentLength - Request->BodyReceived;
+	}
+	
+	/* Pass data to sink */
+	if (length) {
+		PassBody(ESP8266, Request, data, length);
+	}
+	
+	/* Check if entire body is received */
+	*done = Request->ContentLength && Request->BodyReceived >= Request->ContentLength;
+	
+	/* Return number of body bytes */
+	return length;
+}
+
+static uint16_t ChunkedDecode(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const char* data, uint16_t length, uint8_t* done) {
+	uint16_t i = 0, count;
+	int8_t value;
+	char ch;
+	
+	/* Go through all characters */
+	while (i < length) {
+		ch = data[i];
+		switch (Request->ChunkState) {
+			case HTTP_CHUNK_SIZE_FIRST:
+				/* Chunk size must start with hex digit */
+				if (HexValue(ch) < 0) {
+					Request->ChunkState = HTTP_CHUNK_ERROR;
+					*done = 1;
+					return i;
+				}
+				Request->ChunkRemaining = 0;
+				Request->ChunkState = HTTP_CHUNK_SIZE;
+				break;
+			case HTTP_CHUNK_SIZE:
+				/* Parse size, anything else starts extension or line end */
+				value = HexValue(ch);
+				if (value < 0) {
+					Request->ChunkState = HTTP_CHUNK_EXTENSION;
+					break;
+				}
+				Request->ChunkRemaining = 16 * Request->ChunkRemaining + value;
+				i++;
+				break;
+			case HTTP_CHUNK_EXTENSION:
+				/* Ignore chunk extensions up to end of line */
+				if (ch == '\n') {
+					Request->ChunkState = Request->ChunkRemaining ? HTTP_CHUNK_DATA : HTTP_CHUNK_TRAILER;
+				}
+				i++;
+				break;
+			case HTTP_CHUNK_DATA:
+				/* Pass as much chunk data as available */
+				count = length - i;
+				if (count > Request->ChunkRemaining) {
+					count = Request->ChunkRemaining;
+				}
+				PassBody(ESP8266, Request, &data[i], count);
+				Request->ChunkRemaining -= count;
+				i += count;
+				
+				/* Chunk is finished with CRLF */
+				if (Request->ChunkRemaining == 0) {
+					Request->ChunkState = HTTP_CHUNK_DATA_END;
+				}
+				break;
+			case HTTP_CHUNK_DATA_END:
+				/* Skip CRLF after chunk data */
+				if (ch == '\n') {
+					Request->ChunkState = HTTP_CHUNK_SIZE_FIRST;
+				}
+				i++;
+				break;
+			case HTTP_CHUNK_TRAILER:
+				/* Empty line is end of body */
+				if (ch == '\n') {
+					*done = 1;
+					return i + 1;
+				}
+				if (ch != '\r') {
+					Request->ChunkState = HTTP_CHUNK_TRAILER_LINE;
+				}
+				i++;
+				break;
+			case HTTP_CHUNK_TRAILER_LINE:
+				/* Ignore trailer headers */
+				if (ch == '\n') {
+					Request->ChunkState = HTTP_CHUNK_TRAILER;
+				}
+				i++;
+				break;
+			default:
+				*done = 1;
+				return i;
+		}
+	}
+	
+	/* Body is not finished yet */
+	*done = 0;
+	return i;
+}
+
+static int8_t HexValue(char ch) {
+	/* Convert hex character to number */
+	if (ch >= '0' && ch <= '9') {
+		return ch - '0';
+	}
+	if (ch >= 'a' && ch <= 'f') {
+		return ch - 'a' + 10;
+	}
+	if (ch >= 'A' && ch <= 'F') {
+		return ch - 'A' + 10;
+	}
+	return -1;
+}
+
+static void PassBody(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const char* data, uint16_t length) {
+	const uint8_t* out;
+	uint16_t used, count;
+	
+	/* Count body as received from server */
+	Request->BodyReceived += length;
+	
+	/* Uncompressed body goes directly to sink */
+	if (!Request->Compressed) {
+		SinkBody(ESP8266, Request, (const uint8_t *)data, length);
+		return;
+	}
+	
+	/* Data after end of compressed stream or after error are ignored */
+	if (Request->InflateResult == ESP8266_INFLATE_DONE || Request->InflateResult == ESP8266_INFLATE_ERROR) {
+		return;
+	}
+	
+	/* Decompress data, window is passed to sink each time it is full */
+	do {
+		Request->InflateResult = ESP8266_INFLATE_Decode(Request->Inflate, (const uint8_t *)data, length, &used);
+		data += used;
+		length -= used;
+		while ((count = ESP8266_INFLATE_Output(Request->Inflate, &out)) != 0) {
+			SinkBody(ESP8266, Request, out, count);
+		}
+	} while (Request->InflateResult == ESP8266_INFLATE_OUTPUT);
+}
+
+static void SinkBody(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const uint8_t* data, uint16_t length) {
+	/* Save body to cache storage */
+	if (Request->CacheState == HTTP_CACHE_BODY) {
+		CacheWrite(Request, data, length);
+	}
+	
+	/* Pass data to sink */
+	Request->SinkLength += length;
+	if (Request->Sink != NULL) {
+		Request->Sink(ESP8266, Request, data, length);
+	}
+}
+
+static ESP8266_HTTP_Result_t BodyResult(ESP8266_HTTP_Request_t* Request) {
+	/* Chunked encoding is not valid */
+	if (Request->ChunkState == HTTP_CHUNK_ERROR) {
+		return ESP8266_HTTP_ERROR_PARSE;
+	}
+	
+	/* Compressed stream must be valid and complete */
+	if (Request->Compressed && Request->InflateResult != ESP8266_INFLATE_DONE) {
+		return ESP8266_HTTP_ERROR_DECODE;
+	}
+	
+	/* Body is OK */
+	return ESP8266_HTTP_OK;
+}
+
+static void EncodingHeader(ESP8266_HTTP_Request_t* Request, const char* line) {
+	/* Only encodings which were accepted are decompressed */
+	if (!ESP8266_HeaderMatch(line, "content-encoding:")) {
+		return;
+	}
+	line = ESP8266_SkipSpaces(line + 17);
+	Request->Compressed = ESP8266_HeaderMatch(line, "gzip") || ESP8266_HeaderMatch(line, "x-gzip") || ESP8266_HeaderMatch(line, "deflate");
+}
+
+static uint32_t CacheKey(ESP8266_HTTP_Request_t* Request) {
+	const char* str;
+	uint32_t hash = 2166136261UL;
+	uint16_t port = Request->Port ? Request->Port : 80;
+	
+	/* FNV-1a hash of host, port and path */
+	for (str = Request->Host; *str; str++) {
+		hash = (hash ^ (uint8_t)*str) * 16777619UL;
+	}
+	hash = (hash ^ (port >> 8)) * 16777619UL;
+	hash = (hash ^ (port & 0xFF)) * 16777619UL;
+	for (str = Request->Path != NULL ? Request->Path : "/"; *str; str++) {
+		hash = (hash ^ (uint8_t)*str) * 16777619UL;
+	}
+	
+	/* Key 0 is used for empty entries */
+	return hash ? hash : 1;
+}
+
+static ESP8266_HTTP_CacheEntry_t* CacheFind(ESP8266_HTTP_Request_t* Request) {
+	uint8_t i;
+	
+	/* Find entry with request key */
+	for (i = 0; i < Request->Cache->EntriesCount; i++) {
+		if (Request->Cache->Entries[i].Key == Request->CacheKey) {
+			return &Request->Cache->Entries[i];
+		}
+	}
+	
+	/* Resource is not in cache */
+	return NULL;
+}
+
+static ESP8266_HTTP_CacheEntry_t* CacheAllocate(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request) {
+	ESP8266_HTTP_Cache_t* Cache = Request->Cache;
+	ESP8266_HTTP_CacheEntry_t* Entry = NULL;
+	uint8_t i;
+	
+	/* Use entry of the same resource */
+	if ((Entry = CacheFind(Request)) == NULL) {
+		for (i = 0; i < Cache->EntriesCount; i++) {
+			/* Empty entry is the best choice */
+			if (!Cache->Entries[i].Key) {
+				Entry = &Cache->Entries[i];
+				break;
+			}
+			
+			/* Otherwise least recently used entry */
+			if (Entry == NULL || (ESP8266->Time - Cache->Entries[i].LastUsed) > (ESP8266->Time - Entry->LastUsed)) {
+				Entry = &Cache->Entries[i];
+			}
+		}
+		if (Entry == NULL) {
+			return NULL;
+		}
+	}
+	
+	/* Reset entry for new response */
+	Entry->Key = Request->CacheKey;
+	Entry->Validator[0] = 0;
+	Entry->IsTag = 0;
+	Entry->Valid = 0;
+	Entry->HasBody = 0;
+	Entry->BodyLength = 0;
+	Entry->LastUsed = ESP8266->Time;
+	
+	/* Return entry */
+	return Entry;
+}
+
+static void CacheHeader(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const char* line) {
+	ESP8266_HTTP_CacheEntry_t* Entry;
+	uint8_t tag = ESP8266_HeaderMatch(line, "etag:");
+	
+	/* Only validators are saved, cut line can not be used */
+	if ((!tag && !ESP8266_HeaderMatch(line, "last-modified:")) || strlen(line) >= (ESP8266_HEADER_LINE_SIZE - 1)) {
+		return;
+	}
+	
+	/* Get entry, first validator of response resets it */
+	if (Request->CacheState == HTTP_CACHE_NONE) {
+		Entry = CacheAllocate(ESP8266, Request);
+		Request->CacheState = HTTP_CACHE_VALIDATOR;
+	} else {
+		Entry = CacheFind(Request);
+	}
+	if (Entry == NULL) {
+		return;
+	}
+	
+	/* Tag is used when both are present */
+	if (tag || !Entry->IsTag) {
+		line = ESP8266_SkipSpaces(line + (tag ? 5 : 14));
+		strncpy(Entry->Validator, line, ESP8266_HTTP_CACHE_VALIDATOR_SIZE - 1);
+		Entry->Validator[ESP8266_HTTP_CACHE_VALIDATOR_SIZE - 1] = 0;
+		Entry->IsTag = tag;
+	}
+}
+
+static uint8_t CacheResponse(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request) {
+	ESP8266_HTTP_Cache_t* Cache = Request->Cache;
+	ESP8266_HTTP_CacheEntry_t* Entry = CacheFind(Request);
+	uint32_t offset;
+	uint16_t count;
+	
+	/* Resource was not changed */
+	if (Request->StatusCode == 304) {
+		if (Entry == NULL || !Entry->Valid) {
+			return 1;
+		}
+		Entry->LastUsed = ESP8266->Time;
+		
+		/* Without storage, application uses its own copy */
+		if (!Entry->HasBody || Cache->Read == NULL) {
+			return 1;
+		}
+		
+		/* Pass body from storage to sink */
+		for (offset = 0; offset < Entry->BodyLength; offset += count) {
+			count = (Entry->BodyLength - offset) > ESP8266_HTTP_CACHE_READ_SIZE ? ESP8266_HTTP_CACHE_READ_SIZE : (Entry->BodyLength - offset);
+			count = Cache->Read(Cache, Entry - Cache->Entries, offset, CacheBuffer, count);
+			if (count == 0) {
+				/* Storage failed, remove entry */
+				Entry->Key = 0;
+				return 0;
+			}
+			Request->BodyReceived += count;
+			Request->SinkLength += count;
+			if (Request->Sink != NULL) {
+				Request->Sink(ESP8266, Request, CacheBuffer, count);
+			}
+		}
+		Request->FromCache = 1;
+		return 1;
+	}
+	
+	/* Only new resource changes cache */
+	if (Request->StatusCode != 200) {
+		return 1;
+	}
+	
+	/* Resource without validator can not be cached */
+	if (Request->CacheState == HTTP_CACHE_NONE || Entry == NULL) {
+		if (Entry != NULL) {
+			Entry->Key = 0;
+		}
+		Request->CacheState = HTTP_CACHE_NONE;
+		return 1;
+	}
+	
+	/* Save body to storage when it is not too long */
+	if (Cache->Write != NULL) {
+		if (Cache->Read != NULL && (!Cache->MaxBodyLength || Request->Chunked || Request->ContentLength <= Cache->MaxBodyLength)) {
+			Request->CacheState = HTTP_CACHE_BODY;
+		} else {
+			/* Validator without body is not used when storage is used */
+			Entry->Key = 0;
+			Request->CacheState = HTTP_CACHE_NONE;
+		}
+	}
+	
+	/* Return OK */
+	return 1;
+}
+
+static void CacheWrite(ESP8266_HTTP_Request_t* Request, const uint8_t* data, uint16_t length) {
+	ESP8266_HTTP_Cache_t* Cache = Request->Cache;
+	ESP8266_HTTP_CacheEntry_t* Entry = CacheFind(Request);
+	
+	/* Write data at body offset */
+	if (
+		Entry == NULL ||
+		(Cache->MaxBodyLength && (Request->SinkLength + length) > Cache->MaxBodyLength) ||
+		!Cache->Write(Cache, Entry - Cache->Entries, Request->SinkLength, data, length)
+	) {
+		/* Body can not be saved, remove entry */
+		if (Entry != NULL) {
+			Entry->Key = 0;
+		}
+		Request->CacheState = HTTP_CACHE_NONE;
+	}
+}
+
+static void CacheComplete(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, ESP8266_HTTP_Result_t result) {
+	ESP8266_HTTP_CacheEntry_t* Entry = CacheFind(Request);
+	
+	/* Entry was reused by other resource */
+	if (Entry != NULL) {
+		if (result == ESP8266_HTTP_OK) {
+			/* Entry can be used for next requests */
+			Entry->Valid = 1;
+			Entry->HasBody = Request->CacheState == HTTP_CACHE_BODY;
+			Entry->BodyLength = Request->SinkLength;
+			Entry->LastUsed = ESP8266->Time;
+		} else {
+			/* Response is not complete */
+			Entry->Key = 0;
+		}
+	}
+	Request->CacheState = HTTP_CACHE_NONE;
+}
@@ -0,0 +1,393 @@
+/**
+ * @author  Tilen Majerle
+ * @email   tilen@majerle.eu
+ * @website http://stm32f4-discovery.com
+ * @link
+ * @version v0.6
+ * @ide     Keil uVision
+ * @license GNU GPL v3
+ * @brief   HTTP/1.1 client on top of ESP8266 connection API
+ *
+\verbatim
+   ----------------------------------------------------------------------
+    Copyright (C) Tilen Majerle, 2016
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------
+\endverbatim
+ */
+#ifndef ESP8266_HTTP_H
+#define ESP8266_HTTP_H 006
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup ESP8266_HTTP
+ * @brief    HTTP/1.1 client on top of ESP8266 connection API
+ * @{
+ *
+ * Module opens client connection, sends request and parses response. Application only fills @ref ESP8266_HTTP_Request_t structure.
+ *
+ * \par Request
+ *
+ * Request head is not formatted to any buffer. It is sent directly from request strings as array of segments,
+ * using @ref ESP8266_RequestSendSegments function. Strings must stay valid until request is finished.
+ *
+ * \par Response
+ *
+ * Response head is parsed by ESP8266 stack. Body is passed to sink function as it arrives.
+ * When server uses "Transfer-Encoding: chunked", body is decoded before it is passed to sink.
+ *
+ * Request is finished when last chunk or "Content-Length" bytes are received, without waiting for server to close connection.
+ * Only when response has none of them, body ends when connection is closed.
+ *
+ * \par Persistent connections
+ *
+ * When @ref ESP8266_HTTP_Request_t.KeepAlive is set, connection stays open after response and is reused
+ * for next request to the same host and port. Idle connections are kept in pool over all ESP8266 connections.
+ * When there is no free connection for new server, least recently used idle connection is closed.
+ * Connections can be opened in advance with @ref ESP8266_HTTP_Preopen function.
+ *
+ * When server closes idle connection, it is removed from pool. If server closes reused connection
+ * before any response data, request is started again on new connection, but only when it was not sent yet
+ * or it uses safe method (GET, HEAD or OPTIONS). Other requests are finished with @ref ESP8266_HTTP_ERROR_CLOSED,
+ * because server might have processed them already.
+ * Requests are started again from @ref ESP8266_HTTP_Update function, which must be called periodically.
+ *
+ * \par Pipelining
+ *
+ * When @ref ESP8266_HTTP_Request_t.Pipeline is also set, request can be queued on connection which still waits for other responses.
+ * Requests are sent one after another without waiting for responses and responses are passed to requests in the same order.
+ * When server closes connection, requests without response are started again on new connection.
+ *
+ * Only requests with safe method (GET, HEAD or OPTIONS) are pipelined, other requests wait for idle connection.
+ *
+ * \par Cache
+ *
+ * When @ref ESP8266_HTTP_Request_t.Cache is set for GET request, "ETag" or "Last-Modified" header of response is saved to cache entry
+ * and sent back with next request to the same resource as "If-None-Match" or "If-Modified-Since" header.
+ * When resource was not changed, server responds with "304 Not Modified" without body.
+ *
+ * Entries only keep validators. When cache has storage functions, body is also written to user storage while it is received
+ * and is passed to sink again from storage when server responds with 304. Without storage, application gets status code 304
+ * and uses its own copy of resource.
+ *
+ * \par Compression
+ *
+ * When @ref ESP8266_HTTP_Request_t.Inflate is set, request accepts gzip and deflate compressed responses.
+ * Compressed body is decompressed as it is received and only decompressed data are passed to sink.
+ * Cache storage keeps decompressed body.
+ *
+ * \par Changelog
+ *
+\verbatim
+ Version 0.7
+  - Only unsent requests or requests with safe method are repeated on new connection
+  - Requests are repeated from ESP8266_HTTP_Update function
+
+ Version 0.6
+  - Decompression of gzip and deflate responses
+
+ Version 0.5
+  - Cache with conditional requests
+
+ Version 0.4
+  - Response header lines are passed to request header function
+  - Requests can be aborted
+
+ Version 0.3
+  - Requests pipelining
+
+ Version 0.2
+  - Persistent connections pool
+
+ Version 0.1
+  - First release
+\endverbatim
+ *
+ * \par Dependencies
+ *
+\verbatim
+ - ESP8266 stack
+ - ESP8266 inflate decoder
+\endverbatim
+ */
+
+/* Include ESP layer */
+#include "esp8266.h"
+
+/* Include decoder for compressed responses */
+#include "esp8266_inflate.h"
+
+/**
+ * @defgroup ESP8266_HTTP_Macros
+ * @brief    Library defines
+ * @{
+ */
+
+/**
+ * @brief  Maximal number of segments for request head and body
+ */
+#define ESP8266_HTTP_MAX_SEGMENTS    20
+
+/**
+ * @brief  Maximal number of requests waiting for response on one connection when pipelining is used
+ */
+#define ESP8266_HTTP_PIPELINE_DEPTH  4
+
+/**
+ * @brief  Size of cache entry validator including string termination. Longer validators are not saved
+ */
+#define ESP8266_HTTP_CACHE_VALIDATOR_SIZE  ESP8266_HEADER_LINE_SIZE
+
+/**
+ * @brief  Number of bytes read from cache storage at a time when body is passed to sink from cache
+ */
+#define ESP8266_HTTP_CACHE_READ_SIZE       128
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup ESP8266_HTTP_Typedefs
+ * @brief    Library Typedefs
+ * @{
+ */
+
+/**
+ * @brief  HTTP request result enumeration
+ */
+typedef enum {
+	ESP8266_HTTP_OK = 0x00,      /*!< Response was received completely */
+	ESP8266_HTTP_ERROR_CONNECT,  /*!< Connection to server could not be made */
+	ESP8266_HTTP_ERROR_SEND,     /*!< Request could not be sent */
+	ESP8266_HTTP_ERROR_CLOSED,   /*!< Connection was closed before response was received completely */
+	ESP8266_HTTP_ERROR_PARSE,    /*!< Response is not valid HTTP */
+	ESP8266_HTTP_ERROR_ABORTED,  /*!< Request was aborted with @ref ESP8266_HTTP_Abort function */
+	ESP8266_HTTP_ERROR_CACHE,    /*!< Server responded with 304, but body could not be read from cache storage */
+	ESP8266_HTTP_ERROR_DECODE    /*!< Compressed response body is not valid or not complete */
+} ESP8266_HTTP_Result_t;
+
+/* Forward declarations */
+struct _ESP8266_HTTP_Request_t;
+struct _ESP8266_HTTP_Cache_t;
+
+/**
+ * @brief  Function which writes part of body to cache storage
+ * @param  *Cache: Pointer to @ref ESP8266_HTTP_Cache_t cache
+ * @param  entry: Index of entry in cache entries array
+ * @param  offset: Offset of data in body
+ * @param  *data: Pointer to data
+ * @param  length: Number of bytes to write
+ * @return 1 when data are written, 0 otherwise. Body is not kept in cache when write fails
+ */
+typedef uint8_t (*ESP8266_HTTP_CacheWrite_t)(struct _ESP8266_HTTP_Cache_t* Cache, uint8_t entry, uint32_t offset, const uint8_t* data, uint16_t length);
+
+/**
+ * @brief  Function which reads part of body from cache storage
+ * @param  *Cache: Pointer to @ref ESP8266_HTTP_Cache_t cache
+ * @param  entry: Index of entry in cache entries array
+ * @param  offset: Offset of data in body
+ * @param  *data: Pointer to buffer for data
+ * @param  length: Number of bytes to read
+ * @return Number of bytes read, 0 on error
+ */
+typedef uint16_t (*ESP8266_HTTP_CacheRead_t)(struct _ESP8266_HTTP_Cache_t* Cache, uint8_t entry, uint32_t offset, uint8_t* data, uint16_t length);
+
+/**
+ * @brief  HTTP cache entry
+ */
+typedef struct {
+	uint32_t Key;                /*!< Hash of host, port and path. 0 when entry is not used */
+	char Validator[ESP8266_HTTP_CACHE_VALIDATOR_SIZE]; /*!< Value of "ETag" or "Last-Modified" header */
+	uint8_t IsTag;               /*!< Set to 1 when validator is from "ETag" header */
+	uint8_t Valid;               /*!< Set to 1 when response was received completely */
+	uint8_t HasBody;             /*!< Set to 1 when body is saved in storage */
+	uint32_t BodyLength;         /*!< Number of bytes of body in storage */
+	uint32_t LastUsed;           /*!< Time when entry was last used */
+} ESP8266_HTTP_CacheEntry_t;
+
+/**
+ * @brief  HTTP cache structure
+ * @note   Entries array is provided by user and must be cleared to zero before first use
+ */
+typedef struct _ESP8266_HTTP_Cache_t {
+	ESP8266_HTTP_CacheEntry_t* Entries; /*!< Pointer to array of cache entries */
+	uint8_t EntriesCount;        /*!< Number of entries in array */
+	ESP8266_HTTP_CacheWrite_t Write; /*!< Function which writes body to storage or NULL to keep validators only */
+	ESP8266_HTTP_CacheRead_t Read;   /*!< Function which reads body from storage or NULL to keep validators only */
+	uint32_t MaxBodyLength;      /*!< Maximal body length saved to storage. When 0, length is not limited */
+	void* UserParameters;        /*!< User parameters pointer */
+} ESP8266_HTTP_Cache_t;
+
+/**
+ * @brief  Function which receives response body data
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Request: Pointer to @ref ESP8266_HTTP_Request_t request
+ * @param  *data: Pointer to body data
+ * @param  length: Number of bytes in data
+ */
+typedef void (*ESP8266_HTTP_Sink_t)(ESP8266_t* ESP8266, struct _ESP8266_HTTP_Request_t* Request, const uint8_t* data, uint16_t length);
+
+/**
+ * @brief  Function which is called when request is finished
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Request: Pointer to @ref ESP8266_HTTP_Request_t request
+ * @param  result: Member of @ref ESP8266_HTTP_Result_t enumeration
+ */
+typedef void (*ESP8266_HTTP_Done_t)(ESP8266_t* ESP8266, struct _ESP8266_HTTP_Request_t* Request, ESP8266_HTTP_Result_t result);
+
+/**
+ * @brief  Function which receives response header lines
+ * @note   Function is called for each header line after status line, before body is passed to sink.
+ *         @ref ESP8266_HTTP_Request_t.StatusCode is not valid yet, use status code of connection instead
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Request: Pointer to @ref ESP8266_HTTP_Request_t request
+ * @param  *line: Header line without line end. Longer lines are cut to @ref ESP8266_HEADER_LINE_SIZE - 1 characters
+ */
+typedef void (*ESP8266_HTTP_Header_t)(ESP8266_t* ESP8266, struct _ESP8266_HTTP_Request_t* Request, const char* line);
+
+/**
+ * @brief  HTTP request structure
+ * @note   Structure must stay valid until done function is called
+ */
+typedef struct _ESP8266_HTTP_Request_t {
+	const char* Method;          /*!< Request method. When NULL, "GET" is used */
+	const char* Host;            /*!< Server host name or IP address */
+	uint16_t Port;               /*!< Server port. When 0, port 80 is used */
+	const char* Path;            /*!< Path to resource. When NULL, "/" is used */
+	const char* Headers;         /*!< Additional header lines, each ends with "\r\n", or NULL */
+	const void* Body;            /*!< Pointer to request body or NULL */
+	uint32_t BodyLength;         /*!< Number of bytes in request body */
+	ESP8266_HTTP_Sink_t Sink;    /*!< Function which receives response body or NULL to ignore body */
+	ESP8266_HTTP_Done_t Done;    /*!< Function called when request is finished or NULL */
+	ESP8266_HTTP_Header_t Header; /*!< Function which receives response header lines or NULL */
+	void* UserParameters;        /*!< User parameters pointer */
+	uint8_t KeepAlive;           /*!< Set to 1 to keep connection open after response and reuse it for next requests to the same server */
+	uint8_t Pipeline;            /*!< Set to 1 to allow request to be sent on connection which waits for other responses. @ref KeepAlive must also be set */
+	ESP8266_HTTP_Cache_t* Cache; /*!< Pointer to cache used for GET request or NULL */
+	ESP8266_INFLATE_t* Inflate;  /*!< Pointer to decoder used for compressed responses or NULL to accept uncompressed responses only */
+	uint8_t FromCache;           /*!< Set to 1 when server responded with 304 and body was passed to sink from cache storage */
+	uint8_t Compressed;          /*!< Set to 1 when response body was compressed and was decompressed before it was passed to sink */
+	uint16_t StatusCode;         /*!< Response status code */
+	uint32_t ContentLength;      /*!< Value of "Content-Length" header of response, 0 if not present */
+	uint8_t Chunked;             /*!< Set to 1 when response body uses chunked transfer encoding */
+	uint32_t BodyReceived;       /*!< Number of body bytes received, after chunked decoding and before decompression */
+	uint32_t SinkLength;         /*!< Number of body bytes passed to sink */
+	ESP8266_Connection_t* Connection; /*!< Connection used for request. Private member */
+	uint8_t State;               /*!< Request state. Private member */
+	uint8_t Reused;              /*!< Set to 1 when request was sent on connection used before. Private member */
+	uint8_t Aborted;             /*!< Set to 1 when request was aborted. Private member */
+	struct _ESP8266_HTTP_Request_t* Next; /*!< Next request in connection queue. Private member */
+	uint32_t CacheKey;           /*!< Cache key of request, 0 when cache is not used. Private member */
+	uint8_t CacheState;          /*!< Cache state of response. Private member */
+	uint8_t InflateResult;       /*!< Last result of decoder for compressed response. Private member */
+	uint8_t ChunkState;          /*!< Chunked decoder state. Private member */
+	uint32_t ChunkRemaining;     /*!< Number of bytes left in current chunk or current chunk size while parsed. Private member */
+	char PortString[6];          /*!< Port as string for "Host" header. Private member */
+	char LengthString[11];       /*!< Body length as string for "Content-Length" header. Private member */
+	ESP8266_Segment_t Segments[ESP8266_HTTP_MAX_SEGMENTS]; /*!< Segments of request. Private member */
+	uint8_t SegmentsCount;       /*!< Number of used segments. Private member */
+} ESP8266_HTTP_Request_t;
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup ESP8266_HTTP_Functions
+ * @brief    Library Functions
+ * @{
+ */
+
+/**
+ * @brief  Starts new HTTP request
+ * @note   Function starts client connection to server. Request is sent when connection is active
+ *         and done function is called when response is received or error occurred.
+ *         Connection is closed after request is finished, unless @ref ESP8266_HTTP_Request_t.KeepAlive is set
+ *         and server keeps it open. Idle connection to the same server is used when available.
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Request: Pointer to @ref ESP8266_HTTP_Request_t structure with request parameters
+ * @return Member of @ref ESP8266_Result_t enumeration. When ESP_BUSY is returned, try again later
+ */
+ESP8266_Result_t ESP8266_HTTP_Request(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request);
+
+/**
+ * @brief  Opens connection to server in advance and keeps it in pool of idle connections
+ * @note   Connection is used by first request with @ref ESP8266_HTTP_Request_t.KeepAlive set to the same host and port
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *host: Server host name or IP address
+ * @param  port: Server port. When 0, port 80 is used
+ * @return Member of @ref ESP8266_Result_t enumeration. When ESP_BUSY is returned, try again later
+ */
+ESP8266_Result_t ESP8266_HTTP_Preopen(ESP8266_t* ESP8266, const char* host, uint16_t port);
+
+/**
+ * @brief  Closes all idle connections in pool
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_HTTP_CloseIdle(ESP8266_t* ESP8266);
+
+/**
+ * @brief  Aborts request in progress
+ * @note   Request which was not sent yet is removed from connection queue and done function is called immediately.
+ *         When request was already sent, its connection is closed and done function is called when connection is closed.
+ *         Function can be called from sink function of request
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Request: Pointer to @ref ESP8266_HTTP_Request_t structure
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_HTTP_Abort(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request);
+
+/**
+ * @brief  Removes all entries from cache
+ * @param  *Cache: Pointer to @ref ESP8266_HTTP_Cache_t structure
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_HTTP_CacheClear(ESP8266_HTTP_Cache_t* Cache);
+
+/**
+ * @brief  Starts requests again which were not answered before server closed reused connection
+ * @note   Function must be called periodically, for example from main loop after @ref ESP8266_Update
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_HTTP_Update(ESP8266_t* ESP8266);
+
+/**
+ * @brief  Checks if request is in progress
+ * @param  *Request: Pointer to @ref ESP8266_HTTP_Request_t structure
+ * @return 1 if request is in progress, 0 otherwise
+ */
+uint8_t ESP8266_HTTP_IsBusy(ESP8266_HTTP_Request_t* Request);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
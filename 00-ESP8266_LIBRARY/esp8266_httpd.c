@@ -0,0 +1,481 @@
+/**
+ * |----------------------------------------------------------------------
+ * | Copyright (C) Tilen Majerle, 2016
+ * |
+ * | This program is free software: you can redistribute it and/or modify
+ * | it under the terms of the GNU General Public License as published by
+ * | the Free Software Foundation, either version 3 of the License, or
+ * | any later version.
+ * |
+ * | This program is distributed in the hope that it will be useful,
+ * | but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * | MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * | GNU General Public License for more details.
+ * |
+ * | You should have received a copy of the GNU General Public License
+ * | along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * |----------------------------------------------------------------------
+ */
+#include "esp8266_httpd.h"
+
+/* Request states */
+#define HTTPD_STATE_IDLE               0
+#define HTTPD_STATE_HEAD               1
+#define HTTPD_STATE_BODY               2
+#define HTTPD_STATE_HANDLER            3
+#define HTTPD_STATE_SENDING            4
+#define HTTPD_STATE_CLOSED             5
+
+/* Private functions */
+static void HandlerConnected(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void HandlerDataSent(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t success);
+static void HandlerDataReceived(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer);
+static void HandlerClosed(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void HandlerHeader(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const char* line);
+static void HandlerFirstLine(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const char* line);
+static void ResetRequest(ESP8266_HTTPD_Request_t* Request);
+static void Received(ESP8266_t* ESP8266, ESP8266_HTTPD_Request_t* Request);
+static const ESP8266_HTTPD_Route_t* FindRoute(ESP8266_HTTPD_t* Server, const char* method, const char* path);
+static const ESP8266_HTTPD_Asset_t* FindAsset(ESP8266_HTTPD_t* Server, const char* method, const char* path);
+static const ESP8266_HTTPD_Asset_t* FindIdentity(ESP8266_HTTPD_t* Server, const ESP8266_HTTPD_Asset_t* Asset);
+static void RespondAsset(ESP8266_t* ESP8266, ESP8266_HTTPD_Request_t* Request);
+static ESP8266_Result_t Send(ESP8266_t* ESP8266, ESP8266_HTTPD_Request_t* Request, const char* head, const char* headers, const void* body, uint32_t length);
+static const char* Reason(uint16_t status);
+
+/* Connection handler of server */
+static const ESP8266_Handler_t HTTPD_Handler = {
+	HandlerConnected,
+	NULL,
+	NULL,
+	HandlerDataSent,
+	HandlerDataReceived,
+	HandlerClosed,
+	HandlerHeader,
+	HandlerFirstLine
+};
+
+/* Server which handles new connections */
+static ESP8266_HTTPD_t* ActiveServer;
+
+/******************************************/
+/*             Public functions           */
+/******************************************/
+ESP8266_Result_t ESP8266_HTTPD_Start(ESP8266_t* ESP8266, ESP8266_HTTPD_t* Server, uint16_t port) {
+	/* Check parameters */
+	if (Server == NULL || (Server->Routes == NULL && Server->RoutesCount) || (Server->Assets == NULL && Server->AssetsCount)) {
+		return ESP_ERROR;
+	}
+	
+	/* New server connections are handled by server */
+	ActiveServer = Server;
+	ESP8266_SetServerHandler(ESP8266, &HTTPD_Handler);
+	
+	/* Enable server on module */
+	return ESP8266_ServerEnable(ESP8266, port);
+}
+
+ESP8266_Result_t ESP8266_HTTPD_Stop(ESP8266_t* ESP8266) {
+	/* New server connections use callbacks */
+	ESP8266_SetServerHandler(ESP8266, NULL);
+	
+	/* Disable server on module */
+	return ESP8266_ServerDisable(ESP8266);
+}
+
+ESP8266_Result_t ESP8266_HTTPD_Respond(ESP8266_t* ESP8266, ESP8266_HTTPD_Request_t* Request, uint16_t status, const char* headers, const void* body, uint32_t length) {
+	/* Response is possible once, after request was received */
+	if (Request->State != HTTPD_STATE_HANDLER || !Request->Connection->Active) {
+		return ESP_ERROR;
+	}
+	
+	/* Status line, responses without body have no length */
+	sprintf(Request->Head, "HTTP/1.1 %u %s\r\n", (unsigned)status, Reason(status));
+	if (status >= 200 && status != 204 && status != 304) {
+		sprintf(&Request->Head[strlen(Request->Head)], "Content-Length: %lu\r\n", (unsigned long)length);
+	} else {
+		length = 0;
+	}
+	
+	/* Send response */
+	return Send(ESP8266, Request, Request->Head, headers, body, length);
+}
+
+/******************************************/
+/*            Handler functions           */
+/******************************************/
+static void HandlerConnected(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	ESP8266_HTTPD_Request_t* Request = &ActiveServer->Requests[Connection->Number];
+	
+	/* Connection has its own request structure */
+	ResetRequest(Request);
+	Request->Connection = Connection;
+	Request->Server = ActiveServer;
+	Connection->UserParameters = Request;
+}
+
+static void HandlerDataSent(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t success) {
+	ESP8266_HTTPD_Request_t* Request = (ESP8266_HTTPD_Request_t *)Connection->UserParameters;
+	
+	/* Only response is sent */
+	if (Request == NULL || Request->State != HTTPD_STATE_SENDING) {
+		return;
+	}
+	
+	/* Wait for next request or close connection */
+	if (success && Request->KeepAlive) {
+		ResetRequest(Request);
+		ESP8266_ResetHeaders(ESP8266, Connection);
+#if ESP8266_USE_PASSIVE_RECEIVE
+		/* Read next request from module */
+		ESP8266_SetReceiveHold(ESP8266, Connection, 0);
+#endif
+	} else {
+		Request->State = HTTPD_STATE_CLOSED;
+		ESP8266_CloseConnection(ESP8266, Connection);
+	}
+}
+
+static void HandlerDataReceived(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer) {
+	ESP8266_HTTPD_Request_t* Request = (ESP8266_HTTPD_Request_t *)Connection->UserParameters;
+	uint16_t length = Connection->DataSize - Connection->BodyOffset;
+	
+	/* Data of next request can not be kept until response is sent, connection is closed after response */
+	if (Request == NULL || Request->State >= HTTPD_STATE_HANDLER) {
+		if (Request != NULL && length) {
+			Request->KeepAlive = 0;
+		}
+		return;
+	}
+	
+	/* Wait for entire request head */
+	if (!Connection->HeadersDone) {
+		/* Data are not HTTP request */
+		if (Connection->BodyOffset < Connection->DataSize) {
+			Request->Error = 400;
+			Request->KeepAlive = 0;
+			Received(ESP8266, Request);
+		}
+		return;
+	}
+	
+	/* Head was received */
+	if (Request->State != HTTPD_STATE_BODY) {
+		Request->ContentLength = Connection->ContentLength;
+		Request->KeepAlive = Connection->KeepAlive;
+		Request->State = HTTPD_STATE_BODY;
+		
+		/* Chunked body is not supported, connection is closed after response */
+		if (Connection->Chunked) {
+			Request->Error = 501;
+			Request->KeepAlive = 0;
+			Received(ESP8266, Request);
+			return;
+		}
+	}
+	
+	/* Pass body to route, data after body belong to next request and connection is closed after response */
+	if (length > (Request->ContentLength - Request->BodyReceived)) {
+		length = Request->ContentLength - Request->BodyReceived;
+		Request->KeepAlive = 0;
+	}
+	if (length && !Request->Error && Request->Route != NULL && Request->Route->Body != NULL) {
+		Request->Route->Body(ESP8266, Request, (const uint8_t *)&Buffer[Connection->BodyOffset], length);
+	}
+	Request->BodyReceived += length;
+	
+	/* Handle request when entire body is received */
+	if (Request->BodyReceived >= Request->ContentLength && Request->State == HTTPD_STATE_BODY) {
+		Received(ESP8266, Request);
+	}
+}
+
+static void HandlerClosed(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	ESP8266_HTTPD_Request_t* Request = (ESP8266_HTTPD_Request_t *)Connection->UserParameters;
+	
+	/* Request can not be responded anymore */
+	if (Request != NULL) {
+		Request->State = HTTPD_STATE_CLOSED;
+	}
+	Connection->UserParameters = NULL;
+}
+
+static void HandlerHeader(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const char* line) {
+	ESP8266_HTTPD_Request_t* Request = (ESP8266_HTTPD_Request_t *)Connection->UserParameters;
+	
+	/* Check headers for asset */
+	if (Request != NULL && Request->State == HTTPD_STATE_HEAD && Request->Asset != NULL) {
+		if (ESP8266_HeaderMatch(line, "if-none-match:")) {
+			const ESP8266_HTTPD_Asset_t* Identity = FindIdentity(Request->Server, Request->Asset);
+			
+			/* One of tags or any tag matches, bit 1 is for uncompressed copy */
+			Request->NotModified = Request->Asset->ETag != NULL && (strstr(line, Request->Asset->ETag) != NULL || strchr(line, '*') != NULL);
+			if (Identity != NULL && Identity->ETag != NULL && (strstr(line, Identity->ETag) != NULL || strchr(line, '*') != NULL)) {
+				Request->NotModified |= 0x02;
+			}
+		} else if (ESP8266_HeaderMatch(line, "accept-encoding:")) {
+			/* Check for gzip in list of encodings */
+			for (line += 16; *line; line++) {
+				if (ESP8266_HeaderMatch(line, "gzip")) {
+					Request->AcceptGzip = 1;
+				}
+			}
+		}
+		return;
+	}
+	
+	/* Pass line to route */
+	if (
+		Request != NULL && Request->State == HTTPD_STATE_HEAD && !Request->Error &&
+		Request->Route != NULL && Request->Route->Header != NULL
+	) {
+		Request->Route->Header(ESP8266, Request, line);
+	}
+}
+
+static void HandlerFirstLine(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const char* line) {
+	ESP8266_HTTPD_Request_t* Request = (ESP8266_HTTPD_Request_t *)Connection->UserParameters;
+	const char* path;
+	const char* end;
+	char* query;
+	
+	/* Line starts new request */
+	if (Request == NULL || Request->State != HTTPD_STATE_IDLE) {
+		return;
+	}
+	Request->State = HTTPD_STATE_HEAD;
+	
+	/* Line was cut, path is not complete */
+	if (strlen(line) >= (ESP8266_REQUEST_LINE_SIZE - 1)) {
+		Request->Error = 414;
+		return;
+	}
+	
+	/* Method and path are separated with spaces */
+	path = strchr(line, ' ');
+	if (path == NULL || (path - line) >= ESP8266_HTTPD_METHOD_SIZE) {
+		Request->Error = 400;
+		return;
+	}
+	memcpy(Request->Method, line, path - line);
+	Request->Method[path - line] = 0;
+	path++;
+	if ((end = strchr(path, ' ')) == NULL) {
+		end = path + strlen(path);
+	}
+	memcpy(Request->Path, path, end - path);
+	Request->Path[end - path] = 0;
+	
+	/* Split query from path */
+	if ((query = strchr(Request->Path, '?')) != NULL) {
+		*query++ = 0;
+		Request->Query = query;
+	}
+	
+	/* Find route for request, static asset is used when there is no route */
+	Request->Route = FindRoute(Request->Server, Request->Method, Request->Path);
+	if (Request->Route == NULL) {
+		Request->Asset = FindAsset(Request->Server, Request->Method, Request->Path);
+	}
+}
+
+/******************************************/
+/*            Private functions           */
+/******************************************/
+static void ResetRequest(ESP8266_HTTPD_Request_t* Request) {
+	/* Clear informations of previous request */
+	Request->Method[0] = 0;
+	Request->Path[0] = 0;
+	Request->Query = "";
+	Request->ContentLength = 0;
+	Request->BodyReceived = 0;
+	Request->Route = NULL;
+	Request->Asset = NULL;
+	Request->UserParameters = NULL;
+	Request->Error = 0;
+	Request->KeepAlive = 0;
+	Request->NotModified = 0;
+	Request->AcceptGzip = 0;
+	Request->State = HTTPD_STATE_IDLE;
+}
+
+static void Received(ESP8266_t* ESP8266, ESP8266_HTTPD_Request_t* Request) {
+	/* Request waits for response */
+	Request->State = HTTPD_STATE_HANDLER;
+	
+#if ESP8266_USE_PASSIVE_RECEIVE
+	/* Next request stays in module until response is sent */
+	ESP8266_SetReceiveHold(ESP8266, Request->Connection, 1);
+#endif
+	
+	/* Server responds with error or route handles request */
+	if (Request->Error) {
+		ESP8266_HTTPD_Respond(ESP8266, Request, Request->Error, NULL, NULL, 0);
+	} else if (Request->Asset != NULL) {
+		RespondAsset(ESP8266, Request);
+	} else if (Request->Route == NULL || Request->Route->Handler == NULL) {
+		ESP8266_HTTPD_Respond(ESP8266, Request, 404, NULL, NULL, 0);
+	} else {
+		Request->Route->Handler(ESP8266, Request);
+	}
+}
+
+static const ESP8266_HTTPD_Route_t* FindRoute(ESP8266_HTTPD_t* Server, const char* method, const char* path) {
+	const ESP8266_HTTPD_Route_t* Route;
+	uint16_t len;
+	uint8_t i;
+	
+	/* First matching route is used */
+	for (i = 0; i < Server->RoutesCount; i++) {
+		Route = &Server->Routes[i];
+		
+		/* Method must match, GET routes also handle HEAD requests */
+		if (
+			Route->Method != NULL && strcmp(Route->Method, method) != 0 &&
+			!(strcmp(method, "HEAD") == 0 && strcmp(Route->Method, "GET") == 0)
+		) {
+			continue;
+		}
+		
+		/* Path must match exactly or with prefix */
+		len = strlen(Route->Path);
+		if (len && Route->Path[len - 1] == '*') {
+			if (strncmp(Route->Path, path, len - 1) == 0) {
+				return Route;
+			}
+		} else if (strcmp(Route->Path, path) == 0) {
+			return Route;
+		}
+	}
+	
+	/* There is no route */
+	return NULL;
+}
+
+static const ESP8266_HTTPD_Asset_t* FindAsset(ESP8266_HTTPD_t* Server, const char* method, const char* path) {
+	uint16_t i;
+	
+	/* Assets are only read */
+	if (strcmp(method, "GET") != 0 && strcmp(method, "HEAD") != 0) {
+		return NULL;
+	}
+	
+	/* Path must match exactly */
+	for (i = 0; i < Server->AssetsCount; i++) {
+		if (strcmp(Server->Assets[i].Path, path) == 0) {
+			return &Server->Assets[i];
+		}
+	}
+	
+	/* There is no asset */
+	return NULL;
+}
+
+static const ESP8266_HTTPD_Asset_t* FindIdentity(ESP8266_HTTPD_t* Server, const ESP8266_HTTPD_Asset_t* Asset) {
+	uint16_t i;
+	
+	/* Asset is not compressed */
+	if (!Asset->Gzip) {
+		return NULL;
+	}
+	
+	/* Uncompressed copy has the same path */
+	for (i = 0; i < Server->AssetsCount; i++) {
+		if (!Server->Assets[i].Gzip && strcmp(Server->Assets[i].Path, Asset->Path) == 0) {
+			return &Server->Assets[i];
+		}
+	}
+	
+	/* There is no copy */
+	return NULL;
+}
+
+static void RespondAsset(ESP8266_t* ESP8266, ESP8266_HTTPD_Request_t* Request) {
+	const ESP8266_HTTPD_Asset_t* Asset = Request->Asset;
+	uint8_t NotModified = Request->NotModified & 0x01;
+	
+	/* Client can not decode compressed body */
+	if (Asset->Gzip && !Request->AcceptGzip) {
+		/* Use uncompressed copy when there is one */
+		Asset = FindIdentity(Request->Server, Asset);
+		if (Asset == NULL) {
+			ESP8266_HTTPD_Respond(ESP8266, Request, 406, NULL, NULL, 0);
+			return;
+		}
+		NotModified = Request->NotModified & 0x02;
+	}
+	
+	/* Client has the same version, send prepared head only */
+	if (NotModified && Asset->NotModifiedHead != NULL) {
+		Send(ESP8266, Request, Asset->NotModifiedHead, NULL, NULL, 0);
+		return;
+	}
+	
+	/* Send prepared head and body from flash */
+	Send(ESP8266, Request, Asset->Head, NULL, Asset->Data, Asset->Length);
+}
+
+static ESP8266_Result_t Send(ESP8266_t* ESP8266, ESP8266_HTTPD_Request_t* Request, const char* head, const char* headers, const void* body, uint32_t length) {
+	uint8_t count = 0;
+	
+	/* Status line and generated headers */
+	Request->Segments[count].Data = head;
+	Request->Segments[count++].Length = strlen(head);
+	
+	/* Connection is closed after response when client does not keep it */
+	if (!Request->KeepAlive) {
+		Request->Segments[count].Data = "Connection: close\r\n";
+		Request->Segments[count++].Length = 19;
+	}
+	
+	/* User headers */
+	if (headers != NULL && *headers) {
+		Request->Segments[count].Data = headers;
+		Request->Segments[count++].Length = strlen(headers);
+	}
+	
+	/* End of head */
+	Request->Segments[count].Data = "\r\n";
+	Request->Segments[count++].Length = 2;
+	
+	/* Body is not sent for HEAD request */
+	if (body != NULL && length && strcmp(Request->Method, "HEAD") != 0) {
+		Request->Segments[count].Data = body;
+		Request->Segments[count++].Length = length;
+	}
+	
+	/* Send response directly from segments */
+	if (ESP8266_RequestSendSegments(ESP8266, Request->Connection, Request->Segments, count) != ESP_OK) {
+		Request->State = HTTPD_STATE_CLOSED;
+		ESP8266_CloseConnection(ESP8266, Request->Connection);
+		return ESP_ERROR;
+	}
+	Request->State = HTTPD_STATE_SENDING;
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+static const char* Reason(uint16_t status) {
+	/* Reason phrase of common status codes */
+	switch (status) {
+		case 101: return "Switching Protocols";
+		case 200: return "OK";
+		case 201: return "Created";
+		case 204: return "No Content";
+		case 301: return "Moved Permanently";
+		case 302: return "Found";
+		case 304: return "Not Modified";
+		case 400: return "Bad Request";
+		case 401: return "Unauthorized";
+		case 403: return "Forbidden";
+		case 404: return "Not Found";
+		case 405: return "Method Not Allowed";
+		case 406: return "Not Acceptable";
+		case 413: return "Payload Too Large";
+		case 414: return "URI Too Long";
+		case 500: return "Internal Server Error";
+		case 501: return "Not Implemented";
+		case 503: return "Service Unavailable";
+		default: return "";
+	}
+}
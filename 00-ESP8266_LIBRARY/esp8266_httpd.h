@@ -0,0 +1,289 @@
+/**
+ * @author  Tilen Majerle
+ * @email   tilen@majerle.eu
+ * @website http://stm32f4-discovery.com
+ * @link
+ * @version v0.2
+ * @ide     Keil uVision
+ * @license GNU GPL v3
+ * @brief   HTTP server with routing on top of ESP8266 server connections
+ *
+\verbatim
+   ----------------------------------------------------------------------
+    Copyright (C) Tilen Majerle, 2016
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------
+\endverbatim
+ */
+#ifndef ESP8266_HTTPD_H
+#define ESP8266_HTTPD_H 002
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup ESP8266_HTTPD
+ * @brief    HTTP server with routing on top of ESP8266 server connections
+ * @{
+ *
+ * Server parses requests incrementally as they are received, also when request is split to multiple +IPD packets,
+ * and dispatches them to routes in constant table according to method and path.
+ *
+ * Each connection has its own request structure inside @ref ESP8266_HTTPD_t structure, there is no dynamic allocation.
+ * Requests on one connection are processed one after another. Pipelined requests are not supported:
+ * when data of next request are received before response is sent, connection is closed after response, so client sends request again.
+ * With @ref ESP8266_USE_PASSIVE_RECEIVE enabled, server does not read data from module until response is sent,
+ * so next request of keep-alive connection is not lost.
+ *
+ * \par Routes
+ *
+ * Route path matches request path exactly. When route path ends with "*", it matches all paths starting with it.
+ * First matching route in table is used. Request without route gets "404 Not Found" response.
+ *
+\code{.c}
+static const ESP8266_HTTPD_Route_t Routes[] = {
+	{"GET", "/", IndexHandler, NULL, NULL},
+	{"POST", "/config", ConfigHandler, ConfigBody, NULL},
+	{NULL, "/files*", FilesHandler, NULL, FilesHeader},
+};
+\endcode
+ *
+ * \par Request body
+ *
+ * Body is passed to body function of route in parts as it is received, it is not saved.
+ * Handler function is called when entire request is received and must respond with @ref ESP8266_HTTPD_Respond,
+ * either immediately or later. Requests with chunked body get "501 Not Implemented" response.
+ *
+ * \par Response
+ *
+ * Response head is generated by server and sent together with user headers and body directly from user memory
+ * with @ref ESP8266_RequestSendSegments, so body can be constant data in flash.
+ *
+ * Length of request line is limited with @ref ESP8266_REQUEST_LINE_SIZE, independently of header lines. Requests with longer lines get "414 URI Too Long" response.
+ *
+ * \par Static assets
+ *
+ * Fixed files, such as HTML, JS and CSS of configuration page, can be compiled to constant tables at build time with
+ * tools/esp8266_httpd_assets.py script and set to server with Assets and AssetsCount members of @ref ESP8266_HTTPD_t structure.
+ *
+\verbatim
+ python esp8266_httpd_assets.py --gzip --cache "max-age=86400" www/ assets
+\endverbatim
+ *
+ * Script refuses paths server can not match, paths which are too long for @ref ESP8266_REQUEST_LINE_SIZE
+ * or have characters which clients escape. When request line size is changed, it must be passed to script with --line-size option.
+ *
+ * Script generates assets.c and assets.h files. Each asset has response head, ETag and body prepared in flash,
+ * so nothing is formatted or copied at runtime and body is sent directly from flash in @ref ESP8266_SEND_CHUNK_SIZE parts.
+ *
+ * GET and HEAD requests without route are answered with asset of the same path. When request has If-None-Match header with ETag
+ * of asset, "304 Not Modified" response without body is sent. Assets compressed with gzip are only sent to clients which accept gzip encoding,
+ * other clients get uncompressed copy of the same path, which script stores after compressed asset. When there is no copy,
+ * because script was run with --no-identity option, these clients get "406 Not Acceptable" response.
+ *
+ * \par Changelog
+ *
+\verbatim
+ Version 0.2
+  - Added static assets with precomputed responses and ETag validation
+  - Request line is limited with ESP8266_REQUEST_LINE_SIZE instead of header line size
+
+ Version 0.1
+  - First release
+\endverbatim
+ *
+ * \par Dependencies
+ *
+\verbatim
+ - ESP8266 stack
+\endverbatim
+ */
+
+/* Include ESP layer */
+#include "esp8266.h"
+
+/**
+ * @defgroup ESP8266_HTTPD_Macros
+ * @brief    Library defines
+ * @{
+ */
+
+/**
+ * @brief  Maximal length of request method including string termination
+ */
+#define ESP8266_HTTPD_METHOD_SIZE    8
+
+/**
+ * @brief  Size of buffer for response status line and generated headers
+ */
+#define ESP8266_HTTPD_HEAD_SIZE      96
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup ESP8266_HTTPD_Typedefs
+ * @brief    Library Typedefs
+ * @{
+ */
+
+/* Forward declarations */
+struct _ESP8266_HTTPD_t;
+struct _ESP8266_HTTPD_Request_t;
+
+/**
+ * @brief  Function which handles request when it is received completely
+ * @note   Function must respond to request with @ref ESP8266_HTTPD_Respond, immediately or later
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Request: Pointer to @ref ESP8266_HTTPD_Request_t request
+ */
+typedef void (*ESP8266_HTTPD_Handler_t)(ESP8266_t* ESP8266, struct _ESP8266_HTTPD_Request_t* Request);
+
+/**
+ * @brief  Function which receives part of request body
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Request: Pointer to @ref ESP8266_HTTPD_Request_t request
+ * @param  *data: Pointer to body data
+ * @param  length: Number of bytes in data
+ */
+typedef void (*ESP8266_HTTPD_Body_t)(ESP8266_t* ESP8266, struct _ESP8266_HTTPD_Request_t* Request, const uint8_t* data, uint16_t length);
+
+/**
+ * @brief  Function which receives request header line
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Request: Pointer to @ref ESP8266_HTTPD_Request_t request
+ * @param  *line: Header line without line end. Longer lines are cut to @ref ESP8266_HEADER_LINE_SIZE - 1 characters
+ */
+typedef void (*ESP8266_HTTPD_Header_t)(ESP8266_t* ESP8266, struct _ESP8266_HTTPD_Request_t* Request, const char* line);
+
+/**
+ * @brief  Route of server
+ */
+typedef struct {
+	const char* Method;             /*!< Request method or NULL for any method */
+	const char* Path;               /*!< Request path. When it ends with "*", all paths starting with it match */
+	ESP8266_HTTPD_Handler_t Handler; /*!< Function called when request is received */
+	ESP8266_HTTPD_Body_t Body;      /*!< Function which receives request body or NULL to ignore body */
+	ESP8266_HTTPD_Header_t Header;  /*!< Function which receives request header lines or NULL */
+} ESP8266_HTTPD_Route_t;
+
+/**
+ * @brief  Static asset, generated with tools/esp8266_httpd_assets.py script
+ */
+typedef struct {
+	const char* Path;               /*!< Request path of asset */
+	const char* Head;               /*!< Status line and header lines of "200 OK" response, each ends with "\r\n" */
+	const char* NotModifiedHead;    /*!< Status line and header lines of "304 Not Modified" response or NULL when asset has no ETag */
+	const char* ETag;               /*!< Entity tag including quotes or NULL */
+	const uint8_t* Data;            /*!< Pointer to response body */
+	uint32_t Length;                /*!< Number of bytes in body */
+	uint8_t Gzip;                   /*!< Set to 1 when body is compressed with gzip */
+} ESP8266_HTTPD_Asset_t;
+
+/**
+ * @brief  Request structure, one for each connection
+ */
+typedef struct _ESP8266_HTTPD_Request_t {
+	char Method[ESP8266_HTTPD_METHOD_SIZE]; /*!< Request method */
+	char Path[ESP8266_REQUEST_LINE_SIZE]; /*!< Request path without query */
+	const char* Query;              /*!< Query string after "?" in path or empty string */
+	uint32_t ContentLength;         /*!< Length of request body */
+	uint32_t BodyReceived;          /*!< Number of body bytes passed to body function */
+	const ESP8266_HTTPD_Route_t* Route; /*!< Route of request or NULL when there is none */
+	const ESP8266_HTTPD_Asset_t* Asset; /*!< Asset of request when there is no route or NULL */
+	ESP8266_Connection_t* Connection; /*!< Connection of request */
+	struct _ESP8266_HTTPD_t* Server; /*!< Server request belongs to */
+	void* UserParameters;           /*!< User parameters pointer, cleared for each request */
+	uint8_t State;                  /*!< Request state. Private member */
+	uint16_t Error;                 /*!< Status code of error response generated by server, 0 if none. Private member */
+	uint8_t KeepAlive;              /*!< Set to 1 when connection stays open after response. Private member */
+	uint8_t NotModified;            /*!< Bit 0 is set when If-None-Match header matches ETag of asset, bit 1 for its uncompressed copy. Private member */
+	uint8_t AcceptGzip;             /*!< Set to 1 when client accepts gzip encoding. Private member */
+	char Head[ESP8266_HTTPD_HEAD_SIZE]; /*!< Response status line and generated headers. Private member */
+	ESP8266_Segment_t Segments[5];  /*!< Segments of response. Private member */
+} ESP8266_HTTPD_Request_t;
+
+/**
+ * @brief  Server structure
+ * @note   Structure must stay valid while server is running
+ */
+typedef struct _ESP8266_HTTPD_t {
+	const ESP8266_HTTPD_Route_t* Routes; /*!< Pointer to routes table */
+	uint8_t RoutesCount;            /*!< Number of routes in table */
+	const ESP8266_HTTPD_Asset_t* Assets; /*!< Pointer to static assets table or NULL */
+	uint16_t AssetsCount;           /*!< Number of assets in table */
+	void* UserParameters;           /*!< User parameters pointer */
+	ESP8266_HTTPD_Request_t Requests[ESP8266_MAX_CONNECTIONS]; /*!< Requests of connections. Private member */
+} ESP8266_HTTPD_t;
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup ESP8266_HTTPD_Functions
+ * @brief    Library Functions
+ * @{
+ */
+
+/**
+ * @brief  Starts server on port
+ * @note   All new server connections are handled by HTTP server
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Server: Pointer to @ref ESP8266_HTTPD_t structure with routes
+ * @param  port: Server port
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_HTTPD_Start(ESP8266_t* ESP8266, ESP8266_HTTPD_t* Server, uint16_t port);
+
+/**
+ * @brief  Stops server
+ * @note   New server connections use server callback functions again
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_HTTPD_Stop(ESP8266_t* ESP8266);
+
+/**
+ * @brief  Sends response to request
+ * @note   Function can be called once for each request, after handler function of route was called.
+ *         Headers and body must stay valid until response is sent
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Request: Pointer to @ref ESP8266_HTTPD_Request_t request
+ * @param  status: Status code of response
+ * @param  *headers: Additional header lines, each ends with "\r\n", or NULL
+ * @param  *body: Pointer to response body or NULL
+ * @param  length: Number of bytes in body
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_HTTPD_Respond(ESP8266_t* ESP8266, ESP8266_HTTPD_Request_t* Request, uint16_t status, const char* headers, const void* body, uint32_t length);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
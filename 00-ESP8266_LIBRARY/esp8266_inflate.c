@@ -0,0 +1,733 @@
+/**
+ * |----------------------------------------------------------------------
+ * | Copyright (C) Tilen Majerle, 2016
+ * |
+ * | This program is free software: you can redistribute it and/or modify
+ * | it under the terms of the GNU General Public License as published by
+ * | the Free Software Foundation, either version 3 of the License, or
+ * | any later version.
+ * |
+ * | This program is distributed in the hope that it will be useful,
+ * | but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * | MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * | GNU General Public License for more details.
+ * |
+ * | You should have received a copy of the GNU General Public License
+ * | along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * |----------------------------------------------------------------------
+ */
+#include "esp8266_inflate.h"
+
+/* Decoder states */
+#define INFLATE_STATE_DETECT           0
+#define INFLATE_STATE_ZLIB             1
+#define INFLATE_STATE_GZIP             2
+#define INFLATE_STATE_GZIP_EXTRA_LEN   3
+#define INFLATE_STATE_GZIP_EXTRA       4
+#define INFLATE_STATE_GZIP_STRING      5
+#define INFLATE_STATE_GZIP_HCRC        6
+#define INFLATE_STATE_BLOCK            7
+#define INFLATE_STATE_STORED           8
+#define INFLATE_STATE_STORED_CHECK     9
+#define INFLATE_STATE_STORED_DATA      10
+#define INFLATE_STATE_TABLE            11
+#define INFLATE_STATE_CODE_LENGTHS     12
+#define INFLATE_STATE_LENGTHS          13
+#define INFLATE_STATE_LENGTHS_REPEAT   14
+#define INFLATE_STATE_CODES            15
+#define INFLATE_STATE_LENGTH_EXTRA     16
+#define INFLATE_STATE_DISTANCE         17
+#define INFLATE_STATE_DISTANCE_EXTRA   18
+#define INFLATE_STATE_COPY             19
+#define INFLATE_STATE_TRAILER          20
+#define INFLATE_STATE_DONE             21
+#define INFLATE_STATE_ERROR            22
+
+/* Gzip header flags */
+#define INFLATE_GZIP_FHCRC             0x02
+#define INFLATE_GZIP_FEXTRA            0x04
+#define INFLATE_GZIP_FNAME             0x08
+#define INFLATE_GZIP_FCOMMENT          0x10
+
+/* Symbol decode results when there is no symbol */
+#define INFLATE_SYMBOL_NEED            -1
+#define INFLATE_SYMBOL_INVALID         -2
+
+/* Modulo for Adler-32 checksum */
+#define INFLATE_ADLER_BASE             65521UL
+
+/* Base lengths and extra bits for length symbols 257 to 285 */
+static const uint16_t LengthBase[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t LengthExtra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+/* Base distances and extra bits for distance symbols 0 to 29 */
+static const uint16_t DistanceBase[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t DistanceExtra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/* Order of code length codes in dynamic block header */
+static const uint8_t CodeLengthOrder[19] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+/* CRC-32 table for 4 bits at a time */
+static const uint32_t CrcTable[16] = {
+	0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL, 0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+	0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL, 0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+};
+
+/* Private functions */
+static ESP8266_INFLATE_Result_t Process(ESP8266_INFLATE_t* Inflate, const uint8_t** data, const uint8_t* end);
+static uint8_t Fill(ESP8266_INFLATE_t* Inflate, const uint8_t** data, const uint8_t* end, uint8_t bits);
+static uint16_t Take(ESP8266_INFLATE_t* Inflate, uint8_t bits);
+static int16_t DecodeSymbol(ESP8266_INFLATE_t* Inflate, const uint16_t* count, const uint16_t* symbol, const uint8_t** data, const uint8_t* end);
+static int16_t Construct(uint16_t* count, uint16_t* symbol, const uint8_t* lengths, uint16_t n);
+static uint8_t ConstructTables(ESP8266_INFLATE_t* Inflate);
+static void FixedTables(ESP8266_INFLATE_t* Inflate);
+static void GzipNext(ESP8266_INFLATE_t* Inflate);
+static void EndBlock(ESP8266_INFLATE_t* Inflate);
+static void Put(ESP8266_INFLATE_t* Inflate, uint8_t ch);
+
+/******************************************/
+/*             Public functions           */
+/******************************************/
+ESP8266_Result_t ESP8266_INFLATE_Init(ESP8266_INFLATE_t* Inflate, ESP8266_INFLATE_Format_t format) {
+	/* Reset decoder, window content is not important */
+	Inflate->Format = format;
+	Inflate->Final = 0;
+	Inflate->Flags = 0;
+	Inflate->BitBuffer = 0;
+	Inflate->BitCount = 0;
+	Inflate->Counter = 0;
+	Inflate->Value = 0;
+	Inflate->Total = 0;
+	Inflate->Position = 0;
+	Inflate->Flushed = 0;
+	
+	/* Set first state and checksum start value for format */
+	if (format == ESP8266_INFLATE_FORMAT_ZLIB) {
+		Inflate->State = INFLATE_STATE_ZLIB;
+		Inflate->Check = 1;
+	} else if (format == ESP8266_INFLATE_FORMAT_GZIP) {
+		Inflate->State = INFLATE_STATE_GZIP;
+		Inflate->Check = 0xFFFFFFFFUL;
+	} else if (format == ESP8266_INFLATE_FORMAT_RAW) {
+		Inflate->State = INFLATE_STATE_BLOCK;
+		Inflate->Check = 0;
+	} else {
+		Inflate->State = INFLATE_STATE_DETECT;
+		Inflate->Check = 0;
+	}
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+ESP8266_INFLATE_Result_t ESP8266_INFLATE_Decode(ESP8266_INFLATE_t* Inflate, const uint8_t* data, uint16_t length, uint16_t* used) {
+	const uint8_t* ptr = data;
+	ESP8266_INFLATE_Result_t result;
+	
+	/* Process as much input as possible */
+	result = Process(Inflate, &ptr, data + length);
+	
+	/* Save number of used bytes */
+	*used = (uint16_t)(ptr - data);
+	
+	/* Return result */
+	return result;
+}
+
+uint16_t ESP8266_INFLATE_Output(ESP8266_INFLATE_t* Inflate, const uint8_t** data) {
+	uint16_t count;
+	
+	/* Get data since last call */
+	count = Inflate->Position - Inflate->Flushed;
+	*data = &Inflate->Window[Inflate->Flushed];
+	Inflate->Flushed = Inflate->Position;
+	
+	/* Continue at beginning of window when it is full */
+	if (Inflate->Position == ESP8266_INFLATE_WINDOW_SIZE) {
+		Inflate->Position = 0;
+		Inflate->Flushed = 0;
+	}
+	
+	/* Return number of bytes */
+	return count;
+}
+
+/******************************************/
+/*            Private functions           */
+/******************************************/
+static ESP8266_INFLATE_Result_t Process(ESP8266_INFLATE_t* Inflate, const uint8_t** data, const uint8_t* end) {
+	int16_t symbol;
+	uint16_t i, src;
+	uint8_t ch, b0, b1;
+	
+	/* Run states until input is used or output window is full */
+	while (1) {
+		switch (Inflate->State) {
+			case INFLATE_STATE_DETECT:
+				/* Check first 2 bytes without using them */
+				if (!Fill(Inflate, data, end, 16)) {
+					return ESP8266_INFLATE_NEED_INPUT;
+				}
+				b0 = Inflate->BitBuffer & 0xFF;
+				b1 = (Inflate->BitBuffer >> 8) & 0xFF;
+				
+				/* Gzip magic number, zlib header or raw deflate data */
+				if (b0 == 0x1F && b1 == 0x8B) {
+					Inflate->Format = ESP8266_INFLATE_FORMAT_GZIP;
+					Inflate->State = INFLATE_STATE_GZIP;
+					Inflate->Check = 0xFFFFFFFFUL;
+				} else if ((b0 & 0x0F) == 8 && (((uint16_t)b0 << 8) | b1) % 31 == 0) {
+					Inflate->Format = ESP8266_INFLATE_FORMAT_ZLIB;
+					Inflate->State = INFLATE_STATE_ZLIB;
+					Inflate->Check = 1;
+				} else {
+					Inflate->Format = ESP8266_INFLATE_FORMAT_RAW;
+					Inflate->State = INFLATE_STATE_BLOCK;
+				}
+				break;
+			case INFLATE_STATE_ZLIB:
+				/* Read zlib header */
+				if (!Fill(Inflate, data, end, 16)) {
+					return ESP8266_INFLATE_NEED_INPUT;
+				}
+				b0 = Take(Inflate, 8);
+				b1 = Take(Inflate, 8);
+				
+				/* Method must be deflate and preset dictionary is not supported */
+				if ((b0 & 0x0F) != 8 || (b0 >> 4) > 7 || (((uint16_t)b0 << 8) | b1) % 31 != 0 || (b1 & 0x20)) {
+					Inflate->State = INFLATE_STATE_ERROR;
+					break;
+				}
+				Inflate->State = INFLATE_STATE_BLOCK;
+				break;
+			case INFLATE_STATE_GZIP:
+				/* Read fixed part of gzip header byte by byte */
+				while (Inflate->Counter < 10) {
+					if (!Fill(Inflate, data, end, 8)) {
+						return ESP8266_INFLATE_NEED_INPUT;
+					}
+					ch = Take(Inflate, 8);
+					
+					/* Check magic number and method, save flags */
+					if ((Inflate->Counter == 0 && ch != 0x1F) || (Inflate->Counter == 1 && ch != 0x8B) || (Inflate->Counter == 2 && ch != 8)) {
+						Inflate->State = INFLATE_STATE_ERROR;
+						break;
+					}
+					if (Inflate->Counter == 3) {
+						Inflate->Flags = ch;
+					}
+					Inflate->Counter++;
+				}
+				
+				/* Continue with optional fields */
+				if (Inflate->State == INFLATE_STATE_GZIP) {
+					GzipNext(Inflate);
+				}
+				break;
+			case INFLATE_STATE_GZIP_EXTRA_LEN:
+				/* Read length of extra field */
+				if (!Fill(Inflate, data, end, 16)) {
+					return ESP8266_INFLATE_NEED_INPUT;
+				}
+				Inflate->Counter = Take(Inflate, 16);
+				Inflate->State = INFLATE_STATE_GZIP_EXTRA;
+				break;
+			case INFLATE_STATE_GZIP_EXTRA:
+				/* Skip extra field */
+				while (Inflate->Counter) {
+					if (!Fill(Inflate, data, end, 8)) {
+						return ESP8266_INFLATE_NEED_INPUT;
+					}
+					Take(Inflate, 8);
+					Inflate->Counter--;
+				}
+				GzipNext(Inflate);
+				break;
+			case INFLATE_STATE_GZIP_STRING:
+				/* Skip file name or comment up to and including zero */
+				do {
+					if (!Fill(Inflate, data, end, 8)) {
+						return ESP8266_INFLATE_NEED_INPUT;
+					}
+				} while (Take(Inflate, 8) != 0);
+				GzipNext(Inflate);
+				break;
+			case INFLATE_STATE_GZIP_HCRC:
+				/* Skip header CRC */
+				if (!Fill(Inflate, data, end, 16)) {
+					return ESP8266_INFLATE_NEED_INPUT;
+				}
+				Take(Inflate, 16);
+				GzipNext(Inflate);
+				break;
+			case INFLATE_STATE_BLOCK:
+				/* Read block header */
+				if (!Fill(Inflate, data, end, 3)) {
+					return ESP8266_INFLATE_NEED_INPUT;
+				}
+				Inflate->Final = Take(Inflate, 1);
+				
+				/* Check block type */
+				switch (Take(Inflate, 2)) {
+					case 0:
+						Inflate->State = INFLATE_STATE_STORED;
+						break;
+					case 1:
+						FixedTables(Inflate);
+						Inflate->State = INFLATE_STATE_CODES;
+						break;
+					case 2:
+						Inflate->State = INFLATE_STATE_TABLE;
+						break;
+					default:
+						Inflate->State = INFLATE_STATE_ERROR;
+						break;
+				}
+				break;
+			case INFLATE_STATE_STORED:
+				/* Stored block starts at byte boundary */
+				Take(Inflate, Inflate->BitCount & 0x07);
+				
+				/* Read length */
+				if (!Fill(Inflate, data, end, 16)) {
+					return ESP8266_INFLATE_NEED_INPUT;
+				}
+				Inflate->Counter = Take(Inflate, 16);
+				Inflate->State = INFLATE_STATE_STORED_CHECK;
+				break;
+			case INFLATE_STATE_STORED_CHECK:
+				/* Length must match its complement */
+				if (!Fill(Inflate, data, end, 16)) {
+					return ESP8266_INFLATE_NEED_INPUT;
+				}
+				if ((Take(Inflate, 16) ^ Inflate->Counter) != 0xFFFF) {
+					Inflate->State = INFLATE_STATE_ERROR;
+					break;
+				}
+				Inflate->State = INFLATE_STATE_STORED_DATA;
+				break;
+			case INFLATE_STATE_STORED_DATA:
+				/* Copy bytes, first from bit buffer and then directly from input */
+				while (Inflate->Counter) {
+					if (Inflate->Position == ESP8266_INFLATE_WINDOW_SIZE) {
+						return ESP8266_INFLATE_OUTPUT;
+					}
+					if (Inflate->BitCount) {
+						Put(Inflate, Take(Inflate, 8));
+					} else if (*data != end) {
+						Put(Inflate, *(*data)++);
+					} else {
+						return ESP8266_INFLATE_NEED_INPUT;
+					}
+					Inflate->Counter--;
+				}
+				EndBlock(Inflate);
+				break;
+			case INFLATE_STATE_TABLE:
+				/* Read number of codes in dynamic block */
+				if (!Fill(Inflate, data, end, 14)) {
+					return ESP8266_INFLATE_NEED_INPUT;
+				}
+				Inflate->LiteralCodes = Take(Inflate, 5) + 257;
+				Inflate->DistanceCodes = Take(Inflate, 5) + 1;
+				Inflate->LengthCodes = Take(Inflate, 4) + 4;
+				if (Inflate->LiteralCodes > 286 || Inflate->DistanceCodes > 30) {
+					Inflate->State = INFLATE_STATE_ERROR;
+					break;
+				}
+				Inflate->Counter = 0;
+				Inflate->State = INFLATE_STATE_CODE_LENGTHS;
+				break;
+			case INFLATE_STATE_CODE_LENGTHS:
+				/* Read lengths of code length codes */
+				while (Inflate->Counter < Inflate->LengthCodes) {
+					if (!Fill(Inflate, data, end, 3)) {
+						return ESP8266_INFLATE_NEED_INPUT;
+					}
+					Inflate->Lengths[CodeLengthOrder[Inflate->Counter++]] = Take(Inflate, 3);
+				}
+				for (i = Inflate->Counter; i < 19; i++) {
+					Inflate->Lengths[CodeLengthOrder[i]] = 0;
+				}
+				
+				/* Code length code is saved to literal table, it must be complete */
+				if (Construct(Inflate->LiteralCount, Inflate->LiteralSymbol, Inflate->Lengths, 19) != 0) {
+					Inflate->State = INFLATE_STATE_ERROR;
+					break;
+				}
+				Inflate->Counter = 0;
+				Inflate->State = INFLATE_STATE_LENGTHS;
+				break;
+			case INFLATE_STATE_LENGTHS:
+				/* Read literal and distance code lengths */
+				while (Inflate->Counter < Inflate->LiteralCodes + Inflate->DistanceCodes) {
+					symbol = DecodeSymbol(Inflate, Inflate->LiteralCount, Inflate->LiteralSymbol, data, end);
+					if (symbol == INFLATE_SYMBOL_NEED) {
+						return ESP8266_INFLATE_NEED_INPUT;
+					}
+					if (symbol == INFLATE_SYMBOL_INVALID) {
+						Inflate->State = INFLATE_STATE_ERROR;
+						break;
+					}
+					
+					/* Length or repeat code */
+					if (symbol < 16) {
+						Inflate->Lengths[Inflate->Counter++] = symbol;
+					} else {
+						Inflate->Symbol = symbol;
+						Inflate->State = INFLATE_STATE_LENGTHS_REPEAT;
+						break;
+					}
+				}
+				
+				/* Build tables when all lengths are known */
+				if (Inflate->State == INFLATE_STATE_LENGTHS) {
+					Inflate->State = ConstructTables(Inflate) ? INFLATE_STATE_CODES : INFLATE_STATE_ERROR;
+				}
+				break;
+			case INFLATE_STATE_LENGTHS_REPEAT:
+				/* Read repeat count */
+				ch = Inflate->Symbol == 16 ? 2 : (Inflate->Symbol == 17 ? 3 : 7);
+				if (!Fill(Inflate, data, end, ch)) {
+					return ESP8266_INFLATE_NEED_INPUT;
+				}
+				i = Take(Inflate, ch) + (Inflate->Symbol == 18 ? 11 : 3);
+				
+				/* Repeat previous length or zero */
+				ch = 0;
+				if (Inflate->Symbol == 16) {
+					if (Inflate->Counter == 0) {
+						Inflate->State = INFLATE_STATE_ERROR;
+						break;
+					}
+					ch = Inflate->Lengths[Inflate->Counter - 1];
+				}
+				if (Inflate->Counter + i > Inflate->LiteralCodes + Inflate->DistanceCodes) {
+					Inflate->State = INFLATE_STATE_ERROR;
+					break;
+				}
+				while (i--) {
+					Inflate->Lengths[Inflate->Counter++] = ch;
+				}
+				Inflate->State = INFLATE_STATE_LENGTHS;
+				break;
+			case INFLATE_STATE_CODES:
+				/* Symbol is not decoded when there is no space for literal */
+				if (Inflate->Position == ESP8266_INFLATE_WINDOW_SIZE) {
+					return ESP8266_INFLATE_OUTPUT;
+				}
+				
+				/* Decode literal or length symbol */
+				symbol = DecodeSymbol(Inflate, Inflate->LiteralCount, Inflate->LiteralSymbol, data, end);
+				if (symbol == INFLATE_SYMBOL_NEED) {
+					return ESP8266_INFLATE_NEED_INPUT;
+				}
+				if (symbol < 256) {
+					/* Literal or invalid code */
+					if (symbol < 0) {
+						Inflate->State = INFLATE_STATE_ERROR;
+					} else {
+						Put(Inflate, symbol);
+					}
+				} else if (symbol == 256) {
+					/* End of block */
+					EndBlock(Inflate);
+				} else if (symbol - 257 < 29) {
+					/* Length, extra bits follow */
+					Inflate->Symbol = symbol - 257;
+					Inflate->State = INFLATE_STATE_LENGTH_EXTRA;
+				} else {
+					Inflate->State = INFLATE_STATE_ERROR;
+				}
+				break;
+			case INFLATE_STATE_LENGTH_EXTRA:
+				/* Read extra bits of length */
+				if (!Fill(Inflate, data, end, LengthExtra[Inflate->Symbol])) {
+					return ESP8266_INFLATE_NEED_INPUT;
+				}
+				Inflate->Length = LengthBase[Inflate->Symbol] + Take(Inflate, LengthExtra[Inflate->Symbol]);
+				Inflate->State = INFLATE_STATE_DISTANCE;
+				break;
+			case INFLATE_STATE_DISTANCE:
+				/* Decode distance symbol */
+				symbol = DecodeSymbol(Inflate, Inflate->DistanceCount, Inflate->DistanceSymbol, data, end);
+				if (symbol == INFLATE_SYMBOL_NEED) {
+					return ESP8266_INFLATE_NEED_INPUT;
+				}
+				if (symbol < 0 || symbol >= 30) {
+					Inflate->State = INFLATE_STATE_ERROR;
+					break;
+				}
+				Inflate->Symbol = symbol;
+				Inflate->State = INFLATE_STATE_DISTANCE_EXTRA;
+				break;
+			case INFLATE_STATE_DISTANCE_EXTRA:
+				/* Read extra bits of distance */
+				if (!Fill(Inflate, data, end, DistanceExtra[Inflate->Symbol])) {
+					return ESP8266_INFLATE_NEED_INPUT;
+				}
+				Inflate->Distance = DistanceBase[Inflate->Symbol] + Take(Inflate, DistanceExtra[Inflate->Symbol]);
+				
+				/* Distance must be inside output and inside window */
+				if (Inflate->Distance > Inflate->Total || Inflate->Distance > ESP8266_INFLATE_WINDOW_SIZE) {
+					Inflate->State = INFLATE_STATE_ERROR;
+					break;
+				}
+				Inflate->State = INFLATE_STATE_COPY;
+				break;
+			case INFLATE_STATE_COPY:
+				/* Copy bytes from window */
+				while (Inflate->Length) {
+					if (Inflate->Position == ESP8266_INFLATE_WINDOW_SIZE) {
+						return ESP8266_INFLATE_OUTPUT;
+					}
+					if (Inflate->Position >= Inflate->Distance) {
+						src = Inflate->Position - Inflate->Distance;
+					} else {
+						src = ESP8266_INFLATE_WINDOW_SIZE - (Inflate->Distance - Inflate->Position);
+					}
+					Put(Inflate, Inflate->Window[src]);
+					Inflate->Length--;
+				}
+				Inflate->State = INFLATE_STATE_CODES;
+				break;
+			case INFLATE_STATE_TRAILER:
+				/* Read checksum, big endian for zlib, little endian CRC and size for gzip */
+				while (Inflate->Counter < (Inflate->Format == ESP8266_INFLATE_FORMAT_GZIP ? 8 : (Inflate->Format == ESP8266_INFLATE_FORMAT_ZLIB ? 4 : 0))) {
+					if (!Fill(Inflate, data, end, 8)) {
+						return ESP8266_INFLATE_NEED_INPUT;
+					}
+					ch = Take(Inflate, 8);
+					if (Inflate->Format == ESP8266_INFLATE_FORMAT_ZLIB) {
+						Inflate->Value = (Inflate->Value << 8) | ch;
+					} else {
+						Inflate->Value |= (uint32_t)ch << (8 * (Inflate->Counter & 0x03));
+					}
+					
+					/* Check CRC of gzip before size */
+					if (++Inflate->Counter == 4 && Inflate->Format == ESP8266_INFLATE_FORMAT_GZIP) {
+						if ((Inflate->Value ^ Inflate->Check) != 0xFFFFFFFFUL) {
+							Inflate->State = INFLATE_STATE_ERROR;
+							break;
+						}
+						Inflate->Value = 0;
+					}
+				}
+				
+				/* Check last value against checksum or size, raw data have no trailer */
+				if (Inflate->State == INFLATE_STATE_TRAILER) {
+					if (Inflate->Format == ESP8266_INFLATE_FORMAT_ZLIB) {
+						Inflate->State = Inflate->Value == Inflate->Check ? INFLATE_STATE_DONE : INFLATE_STATE_ERROR;
+					} else if (Inflate->Format == ESP8266_INFLATE_FORMAT_GZIP) {
+						Inflate->State = Inflate->Value == Inflate->Total ? INFLATE_STATE_DONE : INFLATE_STATE_ERROR;
+					} else {
+						Inflate->State = INFLATE_STATE_DONE;
+					}
+				}
+				break;
+			case INFLATE_STATE_DONE:
+				return ESP8266_INFLATE_DONE;
+			default:
+				return ESP8266_INFLATE_ERROR;
+		}
+	}
+}
+
+static uint8_t Fill(ESP8266_INFLATE_t* Inflate, const uint8_t** data, const uint8_t* end, uint8_t bits) {
+	/* Load bytes to bit buffer until there is enough bits, maximal 16 bits can be requested */
+	while (Inflate->BitCount < bits) {
+		if (*data == end) {
+			return 0;
+		}
+		Inflate->BitBuffer |= (uint32_t)*(*data)++ << Inflate->BitCount;
+		Inflate->BitCount += 8;
+	}
+	return 1;
+}
+
+static uint16_t Take(ESP8266_INFLATE_t* Inflate, uint8_t bits) {
+	uint16_t value;
+	
+	/* Remove bits from bit buffer */
+	value = Inflate->BitBuffer & ((1UL << bits) - 1);
+	Inflate->BitBuffer >>= bits;
+	Inflate->BitCount -= bits;
+	
+	/* Return value */
+	return value;
+}
+
+static int16_t DecodeSymbol(ESP8266_INFLATE_t* Inflate, const uint16_t* count, const uint16_t* symbol, const uint8_t** data, const uint8_t* end) {
+	int16_t code = 0, first = 0, index = 0;
+	uint8_t len;
+	
+	/* Canonical Huffman code, bits are used only when symbol is complete */
+	for (len = 1; len < 16; len++) {
+		if (!Fill(Inflate, data, end, len)) {
+			return INFLATE_SYMBOL_NEED;
+		}
+		code |= (Inflate->BitBuffer >> (len - 1)) & 0x01;
+		if (code - (int16_t)count[len] < first) {
+			Take(Inflate, len);
+			return symbol[index + (code - first)];
+		}
+		index += count[len];
+		first += count[len];
+		first <<= 1;
+		code <<= 1;
+	}
+	
+	/* Code is not valid */
+	return INFLATE_SYMBOL_INVALID;
+}
+
+static int16_t Construct(uint16_t* count, uint16_t* symbol, const uint8_t* lengths, uint16_t n) {
+	uint16_t offs[16];
+	uint16_t i;
+	int16_t left;
+	
+	/* Count number of codes of each length */
+	for (i = 0; i < 16; i++) {
+		count[i] = 0;
+	}
+	for (i = 0; i < n; i++) {
+		count[lengths[i]]++;
+	}
+	
+	/* No codes is complete code */
+	if (count[0] == n) {
+		return 0;
+	}
+	
+	/* Check if code is over-subscribed */
+	left = 1;
+	for (i = 1; i < 16; i++) {
+		left <<= 1;
+		left -= count[i];
+		if (left < 0) {
+			return left;
+		}
+	}
+	
+	/* Sort symbols by length and by value inside length */
+	offs[1] = 0;
+	for (i = 1; i < 15; i++) {
+		offs[i + 1] = offs[i] + count[i];
+	}
+	for (i = 0; i < n; i++) {
+		if (lengths[i] != 0) {
+			symbol[offs[lengths[i]]++] = i;
+		}
+	}
+	
+	/* Return number of missing codes, 0 for complete code */
+	return left;
+}
+
+static uint8_t ConstructTables(ESP8266_INFLATE_t* Inflate) {
+	int16_t left;
+	
+	/* End of block code is required */
+	if (Inflate->Lengths[256] == 0) {
+		return 0;
+	}
+	
+	/* Incomplete code is allowed only for single code */
+	left = Construct(Inflate->LiteralCount, Inflate->LiteralSymbol, Inflate->Lengths, Inflate->LiteralCodes);
+	if (left < 0 || (left > 0 && Inflate->LiteralCodes - Inflate->LiteralCount[0] != 1)) {
+		return 0;
+	}
+	left = Construct(Inflate->DistanceCount, Inflate->DistanceSymbol, &Inflate->Lengths[Inflate->LiteralCodes], Inflate->DistanceCodes);
+	if (left < 0 || (left > 0 && Inflate->DistanceCodes - Inflate->DistanceCount[0] != 1)) {
+		return 0;
+	}
+	return 1;
+}
+
+static void FixedTables(ESP8266_INFLATE_t* Inflate) {
+	uint16_t i;
+	
+	/* Fixed literal and length code */
+	for (i = 0; i < 288; i++) {
+		Inflate->Lengths[i] = i < 144 ? 8 : (i < 256 ? 9 : (i < 280 ? 7 : 8));
+	}
+	Construct(Inflate->LiteralCount, Inflate->LiteralSymbol, Inflate->Lengths, 288);
+	
+	/* Fixed distance code */
+	for (i = 0; i < 30; i++) {
+		Inflate->Lengths[i] = 5;
+	}
+	Construct(Inflate->DistanceCount, Inflate->DistanceSymbol, Inflate->Lengths, 30);
+}
+
+static void GzipNext(ESP8266_INFLATE_t* Inflate) {
+	/* Go to next optional field of gzip header, flag is cleared when field is selected */
+	if (Inflate->Flags & INFLATE_GZIP_FEXTRA) {
+		Inflate->Flags &= ~INFLATE_GZIP_FEXTRA;
+		Inflate->State = INFLATE_STATE_GZIP_EXTRA_LEN;
+	} else if (Inflate->Flags & INFLATE_GZIP_FNAME) {
+		Inflate->Flags &= ~INFLATE_GZIP_FNAME;
+		Inflate->State = INFLATE_STATE_GZIP_STRING;
+	} else if (Inflate->Flags & INFLATE_GZIP_FCOMMENT) {
+		Inflate->Flags &= ~INFLATE_GZIP_FCOMMENT;
+		Inflate->State = INFLATE_STATE_GZIP_STRING;
+	} else if (Inflate->Flags & INFLATE_GZIP_FHCRC) {
+		Inflate->Flags &= ~INFLATE_GZIP_FHCRC;
+		Inflate->State = INFLATE_STATE_GZIP_HCRC;
+	} else {
+		Inflate->State = INFLATE_STATE_BLOCK;
+	}
+}
+
+static void EndBlock(ESP8266_INFLATE_t* Inflate) {
+	/* Continue with next block */
+	if (!Inflate->Final) {
+		Inflate->State = INFLATE_STATE_BLOCK;
+		return;
+	}
+	
+	/* Trailer starts at byte boundary */
+	Take(Inflate, Inflate->BitCount & 0x07);
+	Inflate->Counter = 0;
+	Inflate->Value = 0;
+	Inflate->State = INFLATE_STATE_TRAILER;
+}
+
+static void Put(ESP8266_INFLATE_t* Inflate, uint8_t ch) {
+	uint32_t s1, s2;
+	
+	/* Save byte to window */
+	Inflate->Window[Inflate->Position++] = ch;
+	Inflate->Total++;
+	
+	/* Update checksum */
+	if (Inflate->Format == ESP8266_INFLATE_FORMAT_GZIP) {
+		Inflate->Check ^= ch;
+		Inflate->Check = (Inflate->Check >> 4) ^ CrcTable[Inflate->Check & 0x0F];
+		Inflate->Check = (Inflate->Check >> 4) ^ CrcTable[Inflate->Check & 0x0F];
+	} else if (Inflate->Format == ESP8266_INFLATE_FORMAT_ZLIB) {
+		s1 = (Inflate->Check & 0xFFFF) + ch;
+		if (s1 >= INFLATE_ADLER_BASE) {
+			s1 -= INFLATE_ADLER_BASE;
+		}
+		s2 = (Inflate->Check >> 16) + s1;
+		if (s2 >= INFLATE_ADLER_BASE) {
+			s2 -= INFLATE_ADLER_BASE;
+		}
+		Inflate->Check = (s2 << 16) | s1;
+	}
+}
@@ -0,0 +1,213 @@
+/**
+ * @author  Tilen Majerle
+ * @email   tilen@majerle.eu
+ * @website http://stm32f4-discovery.com
+ * @link
+ * @version v0.1
+ * @ide     Keil uVision
+ * @license GNU GPL v3
+ * @brief   Streaming decoder for deflate, zlib and gzip compressed data
+ *
+\verbatim
+   ----------------------------------------------------------------------
+    Copyright (C) Tilen Majerle, 2016
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------
+\endverbatim
+ */
+#ifndef ESP8266_INFLATE_H
+#define ESP8266_INFLATE_H 001
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup ESP8266_INFLATE
+ * @brief    Streaming decoder for deflate, zlib and gzip compressed data
+ * @{
+ *
+ * Decoder takes compressed data in parts of any size, as they are received, and keeps its state between parts.
+ * Decompressed data are written to window buffer, which is also used for back references of compressed stream.
+ *
+ * \par Usage
+ *
+\code{.c}
+do {
+	//Decode as much as possible
+	result = ESP8266_INFLATE_Decode(&Inflate, data, length, &used);
+	data += used;
+	length -= used;
+	
+	//Process decompressed data
+	while ((count = ESP8266_INFLATE_Output(&Inflate, &out)) != 0) {
+		//Use count bytes from out
+	}
+} while (result == ESP8266_INFLATE_OUTPUT);
+\endcode
+ *
+ * \par Window size
+ *
+ * Deflate references up to 32768 bytes back, which is also default window size.
+ * Smaller window can be set with @ref ESP8266_INFLATE_WINDOW_SIZE when server is known to compress with smaller window.
+ * Reference behind window is reported as error.
+ *
+ * \par Benchmark
+ *
+ * Throughput of decoder can be measured on PC with tools/esp8266_inflate_bench.c program,
+ * which decodes gzip, zlib or raw deflate files in parts of the same size as received packets.
+ *
+ * \par Changelog
+ *
+\verbatim
+ Version 0.1
+  - First release
+\endverbatim
+ *
+ * \par Dependencies
+ *
+\verbatim
+ - ESP8266 stack
+\endverbatim
+ */
+
+/* Include ESP layer */
+#include "esp8266.h"
+
+/**
+ * @defgroup ESP8266_INFLATE_Macros
+ * @brief    Library defines
+ * @{
+ */
+
+/**
+ * @brief  Size of window buffer in units of bytes, maximal value is 32768
+ */
+#define ESP8266_INFLATE_WINDOW_SIZE     32768
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup ESP8266_INFLATE_Typedefs
+ * @brief    Library Typedefs
+ * @{
+ */
+
+/**
+ * @brief  Format of compressed data
+ */
+typedef enum {
+	ESP8266_INFLATE_FORMAT_AUTO = 0x00, /*!< Format is detected from first bytes of data */
+	ESP8266_INFLATE_FORMAT_RAW,         /*!< Deflate data without header */
+	ESP8266_INFLATE_FORMAT_ZLIB,        /*!< Deflate data with zlib header and Adler-32 checksum */
+	ESP8266_INFLATE_FORMAT_GZIP         /*!< Deflate data with gzip header and CRC-32 checksum */
+} ESP8266_INFLATE_Format_t;
+
+/**
+ * @brief  Decoder result enumeration
+ */
+typedef enum {
+	ESP8266_INFLATE_NEED_INPUT = 0x00, /*!< All input data were used, more data are needed */
+	ESP8266_INFLATE_OUTPUT,            /*!< Window is full. Read output and call decode function again with rest of data */
+	ESP8266_INFLATE_DONE,              /*!< End of compressed stream */
+	ESP8266_INFLATE_ERROR              /*!< Data are not valid */
+} ESP8266_INFLATE_Result_t;
+
+/**
+ * @brief  Decoder structure
+ * @note   All members are private
+ */
+typedef struct {
+	uint8_t Format;               /*!< Format of data */
+	uint8_t State;                /*!< Decoder state */
+	uint8_t Final;                /*!< Set to 1 when current block is last one */
+	uint8_t Flags;                /*!< Flags of gzip header */
+	uint32_t BitBuffer;           /*!< Bits received but not used yet */
+	uint8_t BitCount;             /*!< Number of bits in bit buffer */
+	uint16_t Counter;             /*!< Counter for current state */
+	uint16_t Symbol;              /*!< Symbol which waits for extra bits */
+	uint16_t Length;              /*!< Number of bytes left to copy */
+	uint16_t Distance;            /*!< Distance to copy from */
+	uint16_t LiteralCodes;        /*!< Number of literal and length codes in dynamic block */
+	uint16_t DistanceCodes;       /*!< Number of distance codes in dynamic block */
+	uint16_t LengthCodes;         /*!< Number of code length codes in dynamic block */
+	uint8_t Lengths[320];         /*!< Code lengths of dynamic block */
+	uint16_t LiteralCount[16];    /*!< Number of literal codes of each length */
+	uint16_t LiteralSymbol[288];  /*!< Literal symbols ordered by code */
+	uint16_t DistanceCount[16];   /*!< Number of distance codes of each length */
+	uint16_t DistanceSymbol[30];  /*!< Distance symbols ordered by code */
+	uint32_t Value;               /*!< Value of trailer */
+	uint32_t Check;               /*!< Checksum of output */
+	uint32_t Total;               /*!< Number of output bytes */
+	uint16_t Position;            /*!< Write position in window */
+	uint16_t Flushed;             /*!< Position in window up to which output was read */
+	uint8_t Window[ESP8266_INFLATE_WINDOW_SIZE]; /*!< Window buffer */
+} ESP8266_INFLATE_t;
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup ESP8266_INFLATE_Functions
+ * @brief    Library Functions
+ * @{
+ */
+
+/**
+ * @brief  Initializes decoder for new compressed stream
+ * @param  *Inflate: Pointer to @ref ESP8266_INFLATE_t structure
+ * @param  format: Member of @ref ESP8266_INFLATE_Format_t enumeration
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_INFLATE_Init(ESP8266_INFLATE_t* Inflate, ESP8266_INFLATE_Format_t format);
+
+/**
+ * @brief  Decodes part of compressed stream
+ * @note   Decoding stops when window is full. Output must be read with @ref ESP8266_INFLATE_Output function before next call
+ * @param  *Inflate: Pointer to @ref ESP8266_INFLATE_t structure
+ * @param  *data: Pointer to compressed data
+ * @param  length: Number of bytes of compressed data
+ * @param  *used: Pointer to variable where number of used input bytes is saved
+ * @return Member of @ref ESP8266_INFLATE_Result_t enumeration
+ */
+ESP8266_INFLATE_Result_t ESP8266_INFLATE_Decode(ESP8266_INFLATE_t* Inflate, const uint8_t* data, uint16_t length, uint16_t* used);
+
+/**
+ * @brief  Gets decompressed data which were not read yet
+ * @note   Call function until it returns 0. Data are valid until next call of @ref ESP8266_INFLATE_Decode function
+ * @param  *Inflate: Pointer to @ref ESP8266_INFLATE_t structure
+ * @param  **data: Pointer to variable where pointer to decompressed data is saved
+ * @return Number of decompressed bytes
+ */
+uint16_t ESP8266_INFLATE_Output(ESP8266_INFLATE_t* Inflate, const uint8_t** data);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,783 @@
+/**
+ * |----------------------------------------------------------------------
+ * | Copyright (C) Tilen Majerle, 2016
+ * |
+ * | This program is free software: you can redistribute it and/or modify
+ * | it under the terms of the GNU General Public License as published by
+ * | the Free Software Foundation, either version 3 of the License, or
+ * | any later version.
+ * |
+ * | This program is distributed in the hope that it will be useful,
+ * | but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * | MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * | GNU General Public License for more details.
+ * |
+ * | You should have received a copy of the GNU General Public License
+ * | along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * |----------------------------------------------------------------------
+ */
+#include "esp8266_mqtt.h"
+
+/* Client states */
+#define MQTT_STATE_IDLE                0
+#define MQTT_STATE_CONNECTING          1
+#define MQTT_STATE_CONNACK             2
+#define MQTT_STATE_CONNECTED           3
+#define MQTT_STATE_CLOSING             4
+#define MQTT_STATE_CLOSED              5
+
+/* Parser states */
+#define MQTT_PARSE_HEADER              0
+#define MQTT_PARSE_LENGTH              1
+#define MQTT_PARSE_TOPIC               2
+#define MQTT_PARSE_PACKETID            3
+#define MQTT_PARSE_PAYLOAD             4
+#define MQTT_PARSE_VARIABLE            5
+
+/* Packet types */
+#define MQTT_CONNECT                   0x10
+#define MQTT_CONNACK                   0x20
+#define MQTT_PUBLISH                   0x30
+#define MQTT_PUBACK                    0x40
+#define MQTT_SUBSCRIBE                 0x82
+#define MQTT_SUBACK                    0x90
+#define MQTT_UNSUBSCRIBE               0xA2
+#define MQTT_UNSUBACK                  0xB0
+#define MQTT_PINGREQ                   0xC0
+#define MQTT_PINGRESP                  0xD0
+#define MQTT_DISCONNECT                0xE0
+
+/* PUBLISH flags */
+#define MQTT_DUP                       0x08
+#define MQTT_QOS1                      0x02
+#define MQTT_RETAIN                    0x01
+
+/* Private functions */
+static void HandlerConnected(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void HandlerError(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void HandlerDataSent(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t success);
+static void HandlerDataReceived(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer);
+static void HandlerClosed(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void Closed(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT);
+static void Parse(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT, const uint8_t* data, uint16_t length);
+static void StartPayload(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT);
+static void PacketEnd(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT);
+static void Fail(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT);
+static uint8_t* Reserve(ESP8266_MQTT_t* MQTT, uint8_t header, uint32_t remaining);
+static uint8_t* PutString(uint8_t* ptr, const char* str);
+static uint8_t EncodePublish(ESP8266_MQTT_t* MQTT, uint8_t header, const char* topic, const void* data, uint16_t length, uint16_t packet_id);
+static void PubAck(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT, uint16_t packet_id);
+static void SendWaiting(ESP8266_MQTT_t* MQTT);
+static void Flush(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT);
+static uint16_t NewID(ESP8266_MQTT_t* MQTT);
+
+/* Connection handler of clients */
+static const ESP8266_Handler_t MQTT_Handler = {
+	HandlerConnected,
+	HandlerError,
+	NULL,
+	HandlerDataSent,
+	HandlerDataReceived,
+	HandlerClosed,
+	NULL,
+	NULL
+};
+
+/******************************************/
+/*             Public functions           */
+/******************************************/
+ESP8266_Result_t ESP8266_MQTT_Connect(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT, const char* host, uint16_t port) {
+	ESP8266_Connection_t* Connection;
+	ESP8266_Result_t result;
+	uint8_t i;
+	
+	/* Client has active connection */
+	if (MQTT->State != MQTT_STATE_IDLE && MQTT->State != MQTT_STATE_CLOSED) {
+		return ESP_BUSY;
+	}
+	
+	/* Start connection */
+	result = ESP8266_StartClientConnection(ESP8266, (char *)host, (char *)host, port ? port : 1883, MQTT);
+	if (result != ESP_OK) {
+		return result;
+	}
+	
+	/* Attach handler to connection */
+	Connection = &ESP8266->Connection[ESP8266->StartConnectionSent];
+	Connection->Handler = &MQTT_Handler;
+	MQTT->Connection = Connection;
+	
+	/* Prepare client */
+	MQTT->State = MQTT_STATE_CONNECTING;
+	MQTT->BufferLength = 0;
+	MQTT->Flushing = 0;
+	MQTT->AcksCount = 0;
+	MQTT->PingPending = 0;
+	MQTT->ParseState = MQTT_PARSE_HEADER;
+	MQTT->WaitTime = ESP8266->Time;
+	
+	/* Unacknowledged messages of previous connection are sent again */
+	for (i = 0; i < ESP8266_MQTT_INFLIGHT; i++) {
+		MQTT->InFlight[i].Resend = MQTT->InFlight[i].PacketID != 0;
+	}
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+ESP8266_Result_t ESP8266_MQTT_Disconnect(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT) {
+	/* Client must have connection */
+	if (MQTT->State == MQTT_STATE_IDLE || MQTT->State == MQTT_STATE_CLOSED) {
+		return ESP_ERROR;
+	}
+	
+	/* Send DISCONNECT when session is established, connection is closed after buffer is sent */
+	if (MQTT->State == MQTT_STATE_CONNECTED && Reserve(MQTT, MQTT_DISCONNECT, 0) != NULL) {
+		MQTT->State = MQTT_STATE_CLOSING;
+		Flush(ESP8266, MQTT);
+		if (MQTT->Flushing) {
+			return ESP_OK;
+		}
+	}
+	
+	/* Close connection now */
+	MQTT->State = MQTT_STATE_CLOSING;
+	return ESP8266_CloseConnection(ESP8266, MQTT->Connection);
+}
+
+ESP8266_Result_t ESP8266_MQTT_Publish(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT, const char* topic, const void* data, uint16_t length, uint8_t qos, uint8_t retain, uint16_t* packet_id) {
+	ESP8266_MQTT_InFlight_t* Entry = NULL;
+	uint16_t id = 0;
+	uint8_t i;
+	
+	/* Client must be connected and packet must fit to buffer */
+	if (MQTT->State != MQTT_STATE_CONNECTED || (9 + strlen(topic) + length) > ESP8266_MQTT_BUFFER_SIZE) {
+		return ESP_ERROR;
+	}
+	
+	/* QoS 1 message needs free entry in window */
+	if (qos) {
+		for (i = 0; i < ESP8266_MQTT_INFLIGHT; i++) {
+			if (MQTT->InFlight[i].PacketID == 0) {
+				Entry = &MQTT->InFlight[i];
+				break;
+			}
+		}
+		if (Entry == NULL) {
+			return ESP_BUSY;
+		}
+		id = NewID(MQTT);
+	}
+	
+	/* Encode message to buffer */
+	if (!EncodePublish(MQTT, MQTT_PUBLISH | (qos ? MQTT_QOS1 : 0) | (retain ? MQTT_RETAIN : 0), topic, data, length, id)) {
+		return ESP_BUSY;
+	}
+	
+	/* Save message until PUBACK */
+	if (Entry != NULL) {
+		Entry->PacketID = id;
+		Entry->Topic = topic;
+		Entry->Data = data;
+		Entry->Length = length;
+		Entry->Retain = retain;
+		Entry->Resend = 0;
+	}
+	if (packet_id != NULL) {
+		*packet_id = id;
+	}
+	
+	/* Send now if connection is idle, otherwise together with next packets */
+	Flush(ESP8266, MQTT);
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+ESP8266_Result_t ESP8266_MQTT_Subscribe(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT, const char* topic, uint8_t qos, uint16_t* packet_id) {
+	uint16_t id;
+	uint8_t* ptr;
+	
+	/* Client must be connected */
+	if (MQTT->State != MQTT_STATE_CONNECTED) {
+		return ESP_ERROR;
+	}
+	
+	/* Packet identifier, topic filter and QoS */
+	if ((ptr = Reserve(MQTT, MQTT_SUBSCRIBE, 5 + strlen(topic))) == NULL) {
+		return ESP_BUSY;
+	}
+	id = NewID(MQTT);
+	*ptr++ = id >> 8;
+	*ptr++ = id & 0xFF;
+	ptr = PutString(ptr, topic);
+	*ptr = qos ? 1 : 0;
+	if (packet_id != NULL) {
+		*packet_id = id;
+	}
+	
+	/* Send packet */
+	Flush(ESP8266, MQTT);
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+ESP8266_Result_t ESP8266_MQTT_Unsubscribe(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT, const char* topic) {
+	uint16_t id;
+	uint8_t* ptr;
+	
+	/* Client must be connected */
+	if (MQTT->State != MQTT_STATE_CONNECTED) {
+		return ESP_ERROR;
+	}
+	
+	/* Packet identifier and topic filter */
+	if ((ptr = Reserve(MQTT, MQTT_UNSUBSCRIBE, 4 + strlen(topic))) == NULL) {
+		return ESP_BUSY;
+	}
+	id = NewID(MQTT);
+	*ptr++ = id >> 8;
+	*ptr++ = id & 0xFF;
+	PutString(ptr, topic);
+	
+	/* Send packet */
+	Flush(ESP8266, MQTT);
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+ESP8266_Result_t ESP8266_MQTT_Update(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT) {
+	/* Server must answer CONNECT and PINGREQ in time */
+	if (
+		(MQTT->State == MQTT_STATE_CONNACK || (MQTT->State == MQTT_STATE_CONNECTED && MQTT->PingPending)) &&
+		(ESP8266->Time - MQTT->WaitTime) >= ESP8266_MQTT_TIMEOUT
+	) {
+		MQTT->State = MQTT_STATE_CLOSING;
+		return ESP8266_CloseConnection(ESP8266, MQTT->Connection);
+	}
+	
+	/* Nothing to do without session */
+	if (MQTT->State != MQTT_STATE_CONNECTED) {
+		return ESP_OK;
+	}
+	
+	/* Ping server when nothing was sent for keep alive time */
+	if (
+		MQTT->KeepAlive && !MQTT->PingPending &&
+		(ESP8266->Time - MQTT->LastSent) >= ((uint32_t)MQTT->KeepAlive * 1000) &&
+		Reserve(MQTT, MQTT_PINGREQ, 0) != NULL
+	) {
+		MQTT->PingPending = 1;
+		MQTT->WaitTime = ESP8266->Time;
+	}
+	
+	/* Send packets which wait */
+	SendWaiting(MQTT);
+	Flush(ESP8266, MQTT);
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+uint8_t ESP8266_MQTT_IsConnected(ESP8266_MQTT_t* MQTT) {
+	/* Session is established */
+	return MQTT->State == MQTT_STATE_CONNECTED;
+}
+
+/******************************************/
+/*            Handler functions           */
+/******************************************/
+static void HandlerConnected(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	ESP8266_MQTT_t* MQTT = (ESP8266_MQTT_t *)Connection->UserParameters;
+	uint32_t remaining;
+	uint8_t flags;
+	uint8_t* ptr;
+	
+	/* Client waits for connection */
+	if (MQTT == NULL || MQTT->State != MQTT_STATE_CONNECTING) {
+		return;
+	}
+	
+	/* Connect flags and length of payload */
+	flags = MQTT->CleanSession ? 0x02 : 0x00;
+	remaining = 12 + strlen(MQTT->ClientID);
+	if (MQTT->WillTopic != NULL) {
+		flags |= 0x04 | ((MQTT->WillQoS ? 1 : 0) << 3) | (MQTT->WillRetain ? 0x20 : 0x00);
+		remaining += 4 + strlen(MQTT->WillTopic) + strlen(MQTT->WillMessage);
+	}
+	if (MQTT->Username != NULL) {
+		flags |= 0x80;
+		remaining += 2 + strlen(MQTT->Username);
+	}
+	if (MQTT->Password != NULL) {
+		flags |= 0x40;
+		remaining += 2 + strlen(MQTT->Password);
+	}
+	
+	/* Packet does not fit to buffer */
+	if ((ptr = Reserve(MQTT, MQTT_CONNECT, remaining)) == NULL) {
+		ESP8266_CloseConnection(ESP8266, Connection);
+		return;
+	}
+	
+	/* Protocol name, level 4, flags and keep alive */
+	ptr = PutString(ptr, "MQTT");
+	*ptr++ = 4;
+	*ptr++ = flags;
+	*ptr++ = MQTT->KeepAlive >> 8;
+	*ptr++ = MQTT->KeepAlive & 0xFF;
+	
+	/* Payload */
+	ptr = PutString(ptr, MQTT->ClientID);
+	if (MQTT->WillTopic != NULL) {
+		ptr = PutString(ptr, MQTT->WillTopic);
+		ptr = PutString(ptr, MQTT->WillMessage);
+	}
+	if (MQTT->Username != NULL) {
+		ptr = PutString(ptr, MQTT->Username);
+	}
+	if (MQTT->Password != NULL) {
+		PutString(ptr, MQTT->Password);
+	}
+	
+	/* Wait for CONNACK */
+	MQTT->State = MQTT_STATE_CONNACK;
+	MQTT->WaitTime = ESP8266->Time;
+	Flush(ESP8266, MQTT);
+}
+
+static void HandlerError(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	ESP8266_MQTT_t* MQTT = (ESP8266_MQTT_t *)Connection->UserParameters;
+	
+	/* Connection is not used anymore, it might still be active until it is closed */
+	Connection->UserParameters = NULL;
+	
+	/* Connection failed or lost data */
+	if (MQTT != NULL && MQTT->State != MQTT_STATE_CLOSED) {
+		Closed(ESP8266, MQTT);
+	}
+}
+
+static void HandlerDataSent(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t success) {
+	ESP8266_MQTT_t* MQTT = (ESP8266_MQTT_t *)Connection->UserParameters;
+	
+	/* Only buffer is sent */
+	if (MQTT == NULL || !MQTT->Flushing) {
+		return;
+	}
+	
+	/* Connection is broken */
+	if (!success) {
+		MQTT->Flushing = 0;
+		MQTT->State = MQTT_STATE_CLOSING;
+		ESP8266_CloseConnection(ESP8266, Connection);
+		return;
+	}
+	
+	/* Remove sent data, packets added meanwhile move to beginning */
+	memmove(MQTT->Buffer, &MQTT->Buffer[MQTT->Flushing], MQTT->BufferLength - MQTT->Flushing);
+	MQTT->BufferLength -= MQTT->Flushing;
+	MQTT->Flushing = 0;
+	
+	/* DISCONNECT was sent */
+	if (MQTT->State == MQTT_STATE_CLOSING && !MQTT->BufferLength) {
+		ESP8266_CloseConnection(ESP8266, Connection);
+		return;
+	}
+	
+	/* Send all packets which wait in one cycle */
+	SendWaiting(MQTT);
+	Flush(ESP8266, MQTT);
+}
+
+static void HandlerDataReceived(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer) {
+	ESP8266_MQTT_t* MQTT = (ESP8266_MQTT_t *)Connection->UserParameters;
+	
+	/* Parse packets */
+	if (MQTT != NULL) {
+		Parse(ESP8266, MQTT, (const uint8_t *)&Buffer[Connection->BodyOffset], Connection->DataSize - Connection->BodyOffset);
+	}
+}
+
+static void HandlerClosed(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	ESP8266_MQTT_t* MQTT = (ESP8266_MQTT_t *)Connection->UserParameters;
+	
+	/* Connection is not used anymore */
+	Connection->UserParameters = NULL;
+	if (MQTT != NULL && MQTT->State != MQTT_STATE_CLOSED) {
+		Closed(ESP8266, MQTT);
+	}
+}
+
+/******************************************/
+/*            Private functions           */
+/******************************************/
+static void Closed(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT) {
+	uint16_t id;
+	uint8_t i;
+	
+	/* Clear connection state */
+	MQTT->State = MQTT_STATE_CLOSED;
+	MQTT->Connection = NULL;
+	MQTT->BufferLength = 0;
+	MQTT->Flushing = 0;
+	MQTT->AcksCount = 0;
+	
+	/* Session ends with connection, unacknowledged messages are dropped */
+	if (MQTT->CleanSession) {
+		for (i = 0; i < ESP8266_MQTT_INFLIGHT; i++) {
+			if ((id = MQTT->InFlight[i].PacketID) != 0) {
+				MQTT->InFlight[i].PacketID = 0;
+				if (MQTT->Published != NULL) {
+					MQTT->Published(ESP8266, MQTT, id, 0);
+				}
+			}
+		}
+	}
+	
+	/* Notify user */
+	if (MQTT->Disconnected != NULL) {
+		MQTT->Disconnected(ESP8266, MQTT);
+	}
+}
+
+static void Parse(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT, const uint8_t* data, uint16_t length) {
+	uint16_t count;
+	uint8_t ch;
+	
+	/* Parse until connection is closed */
+	while (length && (MQTT->State == MQTT_STATE_CONNACK || MQTT->State == MQTT_STATE_CONNECTED)) {
+		/* Payload of message goes to user in parts */
+		if (MQTT->ParseState == MQTT_PARSE_PAYLOAD) {
+			count = length;
+			if (count > MQTT->Remaining) {
+				count = MQTT->Remaining;
+			}
+			if (MQTT->Message != NULL) {
+				MQTT->Message(ESP8266, MQTT, MQTT->Topic, data, count, MQTT->PayloadReceived, MQTT->PayloadLength);
+			}
+			MQTT->PayloadReceived += count;
+			MQTT->Remaining -= count;
+			data += count;
+			length -= count;
+			
+			/* Message is complete */
+			if (!MQTT->Remaining) {
+				PacketEnd(ESP8266, MQTT);
+			}
+			continue;
+		}
+		
+		/* Other parts are parsed byte by byte */
+		ch = *data++;
+		length--;
+		switch (MQTT->ParseState) {
+			case MQTT_PARSE_HEADER:
+				/* Packet type and flags */
+				MQTT->Header = ch;
+				MQTT->Remaining = 0;
+				MQTT->LengthShift = 0;
+				MQTT->PacketLength = 0;
+				MQTT->ParseState = MQTT_PARSE_LENGTH;
+				break;
+			case MQTT_PARSE_LENGTH:
+				/* Remaining length has up to 4 bytes */
+				MQTT->Remaining |= (uint32_t)(ch & 0x7F) << MQTT->LengthShift;
+				MQTT->LengthShift += 7;
+				if (ch & 0x80) {
+					if (MQTT->LengthShift > 21) {
+						Fail(ESP8266, MQTT);
+					}
+					break;
+				}
+				
+				/* Messages with QoS 2 are not subscribed */
+				if ((MQTT->Header & 0xF0) == MQTT_PUBLISH) {
+					if ((MQTT->Header & 0x06) > MQTT_QOS1) {
+						Fail(ESP8266, MQTT);
+						break;
+					}
+					MQTT->TopicReceived = 0;
+					MQTT->ParseState = MQTT_PARSE_TOPIC;
+				} else {
+					MQTT->ParseState = MQTT_PARSE_VARIABLE;
+				}
+				
+				/* Packet without variable part */
+				if (!MQTT->Remaining) {
+					PacketEnd(ESP8266, MQTT);
+				}
+				break;
+			case MQTT_PARSE_TOPIC:
+				/* Topic length, then topic which is cut to buffer */
+				MQTT->Remaining--;
+				if (MQTT->PacketLength < 2) {
+					MQTT->Packet[MQTT->PacketLength++] = ch;
+					MQTT->TopicLength = ((uint16_t)MQTT->Packet[0] << 8) | MQTT->Packet[1];
+				} else {
+					if (MQTT->TopicReceived < (ESP8266_MQTT_TOPIC_SIZE - 1)) {
+						MQTT->Topic[MQTT->TopicReceived] = ch;
+					}
+					MQTT->TopicReceived++;
+				}
+				
+				/* Topic is complete */
+				if (MQTT->PacketLength == 2 && MQTT->TopicReceived == MQTT->TopicLength) {
+					MQTT->Topic[MQTT->TopicReceived < ESP8266_MQTT_TOPIC_SIZE ? MQTT->TopicReceived : (ESP8266_MQTT_TOPIC_SIZE - 1)] = 0;
+					MQTT->PacketLength = 0;
+					if (MQTT->Header & MQTT_QOS1) {
+						MQTT->ParseState = MQTT_PARSE_PACKETID;
+					} else {
+						StartPayload(ESP8266, MQTT);
+						break;
+					}
+				}
+				
+				/* Packet ended inside variable header */
+				if (!MQTT->Remaining) {
+					Fail(ESP8266, MQTT);
+				}
+				break;
+			case MQTT_PARSE_PACKETID:
+				/* Packet identifier of QoS 1 message */
+				MQTT->Remaining--;
+				MQTT->Packet[MQTT->PacketLength++] = ch;
+				if (MQTT->PacketLength == 2) {
+					StartPayload(ESP8266, MQTT);
+				} else if (!MQTT->Remaining) {
+					Fail(ESP8266, MQTT);
+				}
+				break;
+			case MQTT_PARSE_VARIABLE:
+				/* Save beginning of other packets */
+				MQTT->Remaining--;
+				if (MQTT->PacketLength < sizeof(MQTT->Packet)) {
+					MQTT->Packet[MQTT->PacketLength++] = ch;
+				}
+				if (!MQTT->Remaining) {
+					PacketEnd(ESP8266, MQTT);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+static void StartPayload(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT) {
+	/* Rest of packet is payload */
+	MQTT->PayloadLength = MQTT->Remaining;
+	MQTT->PayloadReceived = 0;
+	MQTT->ParseState = MQTT_PARSE_PAYLOAD;
+	
+	/* Empty message */
+	if (!MQTT->Remaining) {
+		if (MQTT->Message != NULL) {
+			MQTT->Message(ESP8266, MQTT, MQTT->Topic, NULL, 0, 0, 0);
+		}
+		PacketEnd(ESP8266, MQTT);
+	}
+}
+
+static void PacketEnd(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT) {
+	uint16_t id = ((uint16_t)MQTT->Packet[0] << 8) | MQTT->Packet[1];
+	uint8_t i;
+	
+	/* Next packet follows */
+	MQTT->ParseState = MQTT_PARSE_HEADER;
+	
+	/* Process packet */
+	switch (MQTT->Header & 0xF0) {
+		case MQTT_CONNACK:
+			/* Only answer to CONNECT */
+			if (MQTT->State != MQTT_STATE_CONNACK || MQTT->PacketLength < 2) {
+				Fail(ESP8266, MQTT);
+				return;
+			}
+			
+			/* Session is established or connection is closed */
+			if (MQTT->Packet[1] == 0) {
+				MQTT->State = MQTT_STATE_CONNECTED;
+				SendWaiting(MQTT);
+				Flush(ESP8266, MQTT);
+			} else {
+				Fail(ESP8266, MQTT);
+			}
+			if (MQTT->Connected != NULL) {
+				MQTT->Connected(ESP8266, MQTT, MQTT->Packet[1]);
+			}
+			break;
+		case MQTT_PUBLISH:
+			/* Acknowledge QoS 1 message */
+			if (MQTT->Header & MQTT_QOS1) {
+				PubAck(ESP8266, MQTT, id);
+			}
+			break;
+		case MQTT_PUBACK:
+			/* Message was delivered */
+			for (i = 0; i < ESP8266_MQTT_INFLIGHT; i++) {
+				if (MQTT->InFlight[i].PacketID == id && id) {
+					MQTT->InFlight[i].PacketID = 0;
+					if (MQTT->Published != NULL) {
+						MQTT->Published(ESP8266, MQTT, id, 1);
+					}
+					break;
+				}
+			}
+			break;
+		case MQTT_SUBACK:
+			/* Granted QoS */
+			if (MQTT->Subscribed != NULL && MQTT->PacketLength >= 3) {
+				MQTT->Subscribed(ESP8266, MQTT, id, MQTT->Packet[2]);
+			}
+			break;
+		case MQTT_UNSUBACK:
+			/* Nothing to do */
+			break;
+		case MQTT_PINGRESP:
+			/* Server is alive */
+			MQTT->PingPending = 0;
+			break;
+		default:
+			/* Packet is not expected by client */
+			Fail(ESP8266, MQTT);
+			break;
+	}
+}
+
+static void Fail(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT) {
+	/* Stop parsing and close connection */
+	MQTT->State = MQTT_STATE_CLOSING;
+	MQTT->ParseState = MQTT_PARSE_HEADER;
+	ESP8266_CloseConnection(ESP8266, MQTT->Connection);
+}
+
+static uint8_t* Reserve(ESP8266_MQTT_t* MQTT, uint8_t header, uint32_t remaining) {
+	uint8_t* ptr = &MQTT->Buffer[MQTT->BufferLength];
+	uint8_t size = remaining < 128 ? 2 : (remaining < 16384 ? 3 : 4);
+	
+	/* Packet must fit after data in buffer */
+	if ((MQTT->BufferLength + size + remaining) > ESP8266_MQTT_BUFFER_SIZE) {
+		return NULL;
+	}
+	MQTT->BufferLength += size + remaining;
+	MQTT->PacketsSent++;
+	
+	/* Fixed header with remaining length */
+	*ptr++ = header;
+	do {
+		*ptr = remaining & 0x7F;
+		remaining >>= 7;
+		if (remaining) {
+			*ptr |= 0x80;
+		}
+		ptr++;
+	} while (remaining);
+	
+	/* Return pointer to variable header */
+	return ptr;
+}
+
+static uint8_t* PutString(uint8_t* ptr, const char* str) {
+	uint16_t length = strlen(str);
+	
+	/* Length and characters */
+	*ptr++ = length >> 8;
+	*ptr++ = length & 0xFF;
+	memcpy(ptr, str, length);
+	return ptr + length;
+}
+
+static uint8_t EncodePublish(ESP8266_MQTT_t* MQTT, uint8_t header, const char* topic, const void* data, uint16_t length, uint16_t packet_id) {
+	uint8_t* ptr;
+	
+	/* Topic, packet identifier for QoS 1 and payload */
+	if ((ptr = Reserve(MQTT, header, 2 + strlen(topic) + (packet_id ? 2 : 0) + length)) == NULL) {
+		return 0;
+	}
+	ptr = PutString(ptr, topic);
+	if (packet_id) {
+		*ptr++ = packet_id >> 8;
+		*ptr++ = packet_id & 0xFF;
+	}
+	memcpy(ptr, data, length);
+	return 1;
+}
+
+static void PubAck(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT, uint16_t packet_id) {
+	/* Acknowledges are sent in order of messages */
+	if (MQTT->AcksCount >= ESP8266_MQTT_ACKS) {
+		Fail(ESP8266, MQTT);
+		return;
+	}
+	MQTT->Acks[MQTT->AcksCount++] = packet_id;
+	
+	/* Send when there is space in buffer */
+	SendWaiting(MQTT);
+	Flush(ESP8266, MQTT);
+}
+
+static void SendWaiting(ESP8266_MQTT_t* MQTT) {
+	ESP8266_MQTT_InFlight_t* Entry;
+	uint8_t* ptr;
+	uint8_t i;
+	
+	/* PUBACK packets first */
+	while (MQTT->AcksCount && (ptr = Reserve(MQTT, MQTT_PUBACK, 2)) != NULL) {
+		ptr[0] = MQTT->Acks[0] >> 8;
+		ptr[1] = MQTT->Acks[0] & 0xFF;
+		memmove(&MQTT->Acks[0], &MQTT->Acks[1], (--MQTT->AcksCount) * sizeof(MQTT->Acks[0]));
+	}
+	
+	/* Messages of previous connection are sent again with DUP flag after CONNACK */
+	if (MQTT->State != MQTT_STATE_CONNECTED) {
+		return;
+	}
+	for (i = 0; i < ESP8266_MQTT_INFLIGHT; i++) {
+		Entry = &MQTT->InFlight[i];
+		if (Entry->PacketID && Entry->Resend) {
+			if (!EncodePublish(MQTT, MQTT_PUBLISH | MQTT_DUP | MQTT_QOS1 | (Entry->Retain ? MQTT_RETAIN : 0), Entry->Topic, Entry->Data, Entry->Length, Entry->PacketID)) {
+				break;
+			}
+			Entry->Resend = 0;
+		}
+	}
+}
+
+static void Flush(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT) {
+	/* Wait for previous send cycle */
+	if (MQTT->Flushing || !MQTT->BufferLength || MQTT->Connection == NULL) {
+		return;
+	}
+	
+	/* Send all packets in buffer, next packets are added after them meanwhile */
+	MQTT->Segment.Data = MQTT->Buffer;
+	MQTT->Segment.Length = MQTT->BufferLength;
+	if (ESP8266_RequestSendSegments(ESP8266, MQTT->Connection, &MQTT->Segment, 1) != ESP_OK) {
+		return;
+	}
+	MQTT->Flushing = MQTT->BufferLength;
+	MQTT->SendCycles++;
+	MQTT->LastSent = ESP8266->Time;
+}
+
+static uint16_t NewID(ESP8266_MQTT_t* MQTT) {
+	uint8_t i;
+	
+	/* Next identifier which is not 0 and not used by message in window */
+	do {
+		if (++MQTT->NextID == 0) {
+			MQTT->NextID = 1;
+		}
+		for (i = 0; i < ESP8266_MQTT_INFLIGHT; i++) {
+			if (MQTT->InFlight[i].PacketID == MQTT->NextID) {
+				break;
+			}
+		}
+	} while (i < ESP8266_MQTT_INFLIGHT);
+	
+	/* Return identifier */
+	return MQTT->NextID;
+}
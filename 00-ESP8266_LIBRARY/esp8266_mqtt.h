@@ -0,0 +1,325 @@
+/**
+ * @author  Tilen Majerle
+ * @email   tilen@majerle.eu
+ * @website http://stm32f4-discovery.com
+ * @link
+ * @version v0.1
+ * @ide     Keil uVision
+ * @license GNU GPL v3
+ * @brief   MQTT 3.1.1 client on top of ESP8266 connections
+ *
+\verbatim
+   ----------------------------------------------------------------------
+    Copyright (C) Tilen Majerle, 2016
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------
+\endverbatim
+ */
+#ifndef ESP8266_MQTT_H
+#define ESP8266_MQTT_H 001
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup ESP8266_MQTT
+ * @brief    MQTT 3.1.1 client on top of ESP8266 connections
+ * @{
+ *
+ * Client supports publishing and subscribing with QoS 0 and QoS 1.
+ *
+ * \par Sending
+ *
+ * Packets are encoded to output buffer of client. When connection is idle, buffer is sent immediately.
+ * Packets which are added while previous data are sent wait in buffer and are all sent together in next AT+CIPSEND cycle,
+ * so many small PUBLISH packets need only few send cycles. @ref ESP8266_MQTT_t.PacketsSent and @ref ESP8266_MQTT_t.SendCycles
+ * show how many packets were batched.
+ *
+ * \par QoS 1
+ *
+ * Up to @ref ESP8266_MQTT_INFLIGHT QoS 1 messages can wait for PUBACK at the same time. Publish function returns ESP_BUSY when window is full.
+ * Published function is called with packet identifier when PUBACK is received.
+ *
+ * When client connects again with CleanSession set to 0, unacknowledged messages are sent again with DUP flag.
+ * Topic and data of QoS 1 message must therefore stay valid until published function is called.
+ * With CleanSession set to 1, unacknowledged messages are reported as failed when connection is closed.
+ *
+ * \par Receiving
+ *
+ * Packets are parsed as they are received, also when packet is split to multiple +IPD packets.
+ * Payload of PUBLISH packet is passed to message function in parts, together with offset and total length.
+ *
+ * \par Keep alive
+ *
+ * @ref ESP8266_MQTT_Update function must be called periodically. It sends PINGREQ when nothing was sent for keep alive time
+ * and closes connection when server does not respond in @ref ESP8266_MQTT_TIMEOUT milliseconds.
+ * Time is taken from @ref ESP8266_t.Time, which is updated with @ref ESP8266_TimeUpdate.
+ *
+ * \par Changelog
+ *
+\verbatim
+ Version 0.1
+  - First release
+\endverbatim
+ *
+ * \par Dependencies
+ *
+\verbatim
+ - ESP8266 stack
+\endverbatim
+ */
+
+/* Include ESP layer */
+#include "esp8266.h"
+
+/**
+ * @defgroup ESP8266_MQTT_Macros
+ * @brief    Library defines
+ * @{
+ */
+
+/**
+ * @brief  Size of output buffer in units of bytes. Largest packet must fit to buffer
+ */
+#define ESP8266_MQTT_BUFFER_SIZE         1024
+
+/**
+ * @brief  Maximal number of QoS 1 messages waiting for PUBACK
+ */
+#define ESP8266_MQTT_INFLIGHT            8
+
+/**
+ * @brief  Maximal number of PUBACK packets which wait for space in output buffer
+ */
+#define ESP8266_MQTT_ACKS                8
+
+/**
+ * @brief  Size of buffer for topic of received message, including string termination. Longer topics are cut
+ */
+#define ESP8266_MQTT_TOPIC_SIZE          64
+
+/**
+ * @brief  Time in milliseconds to wait for CONNACK and PINGRESP packets
+ */
+#define ESP8266_MQTT_TIMEOUT             10000
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup ESP8266_MQTT_Typedefs
+ * @brief    Library Typedefs
+ * @{
+ */
+
+/* Forward declaration */
+struct _ESP8266_MQTT_t;
+
+/**
+ * @brief  Function called when CONNACK is received
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *MQTT: Pointer to @ref ESP8266_MQTT_t client
+ * @param  code: Return code of CONNACK, 0 when connection was accepted. Connection is closed for other codes
+ */
+typedef void (*ESP8266_MQTT_Connected_t)(ESP8266_t* ESP8266, struct _ESP8266_MQTT_t* MQTT, uint8_t code);
+
+/**
+ * @brief  Function which receives part of message
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *MQTT: Pointer to @ref ESP8266_MQTT_t client
+ * @param  *topic: Topic of message
+ * @param  *data: Pointer to part of payload
+ * @param  length: Number of bytes in part
+ * @param  offset: Offset of part in payload
+ * @param  total: Total length of payload
+ */
+typedef void (*ESP8266_MQTT_Message_t)(ESP8266_t* ESP8266, struct _ESP8266_MQTT_t* MQTT, const char* topic, const uint8_t* data, uint16_t length, uint32_t offset, uint32_t total);
+
+/**
+ * @brief  Function called when packet is acknowledged
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *MQTT: Pointer to @ref ESP8266_MQTT_t client
+ * @param  packet_id: Packet identifier returned by publish or subscribe function
+ * @param  result: For PUBACK 1 when message was delivered or 0 when it was dropped, for SUBACK granted QoS or 0x80 on failure
+ */
+typedef void (*ESP8266_MQTT_Acked_t)(ESP8266_t* ESP8266, struct _ESP8266_MQTT_t* MQTT, uint16_t packet_id, uint8_t result);
+
+/**
+ * @brief  Function called when connection is closed
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *MQTT: Pointer to @ref ESP8266_MQTT_t client
+ */
+typedef void (*ESP8266_MQTT_Disconnected_t)(ESP8266_t* ESP8266, struct _ESP8266_MQTT_t* MQTT);
+
+/**
+ * @brief  QoS 1 message waiting for PUBACK
+ */
+typedef struct {
+	uint16_t PacketID;        /*!< Packet identifier, 0 when entry is free */
+	const char* Topic;        /*!< Topic of message */
+	const void* Data;         /*!< Payload of message */
+	uint16_t Length;          /*!< Length of payload */
+	uint8_t Retain;           /*!< Retain flag of message */
+	uint8_t Resend;           /*!< Set to 1 when message must be sent again after reconnect */
+} ESP8266_MQTT_InFlight_t;
+
+/**
+ * @brief  Client structure
+ * @note   Structure must stay valid while client is used
+ */
+typedef struct _ESP8266_MQTT_t {
+	const char* ClientID;               /*!< Client identifier */
+	const char* Username;               /*!< User name or NULL */
+	const char* Password;               /*!< Password or NULL */
+	uint16_t KeepAlive;                 /*!< Keep alive time in units of seconds, 0 to disable */
+	uint8_t CleanSession;               /*!< Set to 1 to start new session on server */
+	const char* WillTopic;              /*!< Topic of will message or NULL */
+	const char* WillMessage;            /*!< Will message */
+	uint8_t WillQoS;                    /*!< QoS of will message */
+	uint8_t WillRetain;                 /*!< Retain flag of will message */
+	ESP8266_MQTT_Connected_t Connected; /*!< Function called when CONNACK is received or NULL */
+	ESP8266_MQTT_Message_t Message;     /*!< Function which receives messages or NULL */
+	ESP8266_MQTT_Acked_t Published;     /*!< Function called when QoS 1 message is acknowledged or dropped or NULL */
+	ESP8266_MQTT_Acked_t Subscribed;    /*!< Function called when SUBACK is received or NULL */
+	ESP8266_MQTT_Disconnected_t Disconnected; /*!< Function called when connection is closed or NULL */
+	void* UserParameters;               /*!< User parameters pointer */
+	ESP8266_Connection_t* Connection;   /*!< Connection of client */
+	uint32_t PacketsSent;               /*!< Number of packets sent to module */
+	uint32_t SendCycles;                /*!< Number of AT+CIPSEND cycles used to send packets */
+	uint8_t State;                      /*!< Client state. Private member */
+	uint16_t NextID;                    /*!< Last used packet identifier. Private member */
+	ESP8266_MQTT_InFlight_t InFlight[ESP8266_MQTT_INFLIGHT]; /*!< QoS 1 messages waiting for PUBACK. Private member */
+	uint16_t Acks[ESP8266_MQTT_ACKS];   /*!< Packet identifiers of PUBACK packets waiting for space in buffer. Private member */
+	uint8_t AcksCount;                  /*!< Number of waiting PUBACK packets. Private member */
+	uint8_t Buffer[ESP8266_MQTT_BUFFER_SIZE]; /*!< Output buffer. Private member */
+	uint16_t BufferLength;              /*!< Number of bytes in output buffer. Private member */
+	uint16_t Flushing;                  /*!< Number of bytes at beginning of buffer which are being sent. Private member */
+	ESP8266_Segment_t Segment;          /*!< Segment used to send buffer. Private member */
+	uint32_t LastSent;                  /*!< Time when buffer was last sent. Private member */
+	uint32_t WaitTime;                  /*!< Time when CONNACK or PINGRESP waiting started. Private member */
+	uint8_t PingPending;                /*!< Set to 1 when PINGRESP is expected. Private member */
+	uint8_t ParseState;                 /*!< Packet parser state. Private member */
+	uint8_t Header;                     /*!< Fixed header of received packet. Private member */
+	uint32_t Remaining;                 /*!< Remaining length of received packet. Private member */
+	uint8_t LengthShift;                /*!< Shift of next remaining length byte. Private member */
+	uint8_t Packet[4];                  /*!< Variable header of received packet. Private member */
+	uint8_t PacketLength;               /*!< Number of bytes in variable header. Private member */
+	uint16_t TopicLength;               /*!< Length of topic of received message. Private member */
+	uint16_t TopicReceived;             /*!< Number of received topic bytes. Private member */
+	char Topic[ESP8266_MQTT_TOPIC_SIZE]; /*!< Topic of received message. Private member */
+	uint32_t PayloadLength;             /*!< Length of payload of received message. Private member */
+	uint32_t PayloadReceived;           /*!< Number of received payload bytes. Private member */
+} ESP8266_MQTT_t;
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup ESP8266_MQTT_Functions
+ * @brief    Library Functions
+ * @{
+ */
+
+/**
+ * @brief  Starts connection to MQTT server
+ * @note   CONNECT packet is sent when connection is active. Connected function is called when server answers
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *MQTT: Pointer to @ref ESP8266_MQTT_t client with parameters set
+ * @param  *host: Server host name or IP address
+ * @param  port: Server port, 0 for 1883
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_MQTT_Connect(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT, const char* host, uint16_t port);
+
+/**
+ * @brief  Sends DISCONNECT packet and closes connection
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *MQTT: Pointer to @ref ESP8266_MQTT_t client
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_MQTT_Disconnect(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT);
+
+/**
+ * @brief  Publishes message
+ * @note   Message is copied to output buffer. For QoS 1, topic and data must stay valid until published function is called
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *MQTT: Pointer to @ref ESP8266_MQTT_t client
+ * @param  *topic: Topic of message
+ * @param  *data: Pointer to payload
+ * @param  length: Length of payload
+ * @param  qos: QoS of message, 0 or 1
+ * @param  retain: Set to 1 to retain message on server
+ * @param  *packet_id: Pointer to variable where packet identifier of QoS 1 message is saved or NULL
+ * @return Member of @ref ESP8266_Result_t enumeration:
+ *            - ESP_OK: Message is in output buffer
+ *            - ESP_BUSY: Output buffer or QoS 1 window is full, try again later
+ *            - ESP_ERROR: Client is not connected or packet is larger than output buffer
+ */
+ESP8266_Result_t ESP8266_MQTT_Publish(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT, const char* topic, const void* data, uint16_t length, uint8_t qos, uint8_t retain, uint16_t* packet_id);
+
+/**
+ * @brief  Subscribes to topic
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *MQTT: Pointer to @ref ESP8266_MQTT_t client
+ * @param  *topic: Topic filter
+ * @param  qos: Maximal QoS of messages, 0 or 1
+ * @param  *packet_id: Pointer to variable where packet identifier is saved or NULL
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_MQTT_Subscribe(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT, const char* topic, uint8_t qos, uint16_t* packet_id);
+
+/**
+ * @brief  Unsubscribes from topic
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *MQTT: Pointer to @ref ESP8266_MQTT_t client
+ * @param  *topic: Topic filter
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_MQTT_Unsubscribe(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT, const char* topic);
+
+/**
+ * @brief  Handles keep alive, timeouts and data which wait in output buffer
+ * @note   Function must be called periodically
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *MQTT: Pointer to @ref ESP8266_MQTT_t client
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_MQTT_Update(ESP8266_t* ESP8266, ESP8266_MQTT_t* MQTT);
+
+/**
+ * @brief  Checks if client is connected to server
+ * @param  *MQTT: Pointer to @ref ESP8266_MQTT_t client
+ * @return 1 when CONNACK was received and connection is open, 0 otherwise
+ */
+uint8_t ESP8266_MQTT_IsConnected(ESP8266_MQTT_t* MQTT);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
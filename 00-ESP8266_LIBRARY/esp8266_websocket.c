@@ -0,0 +1,815 @@
+/**
+ * |----------------------------------------------------------------------
+ * | Copyright (C) Tilen Majerle, 2016
+ * |
+ * | This program is free software: you can redistribute it and/or modify
+ * | it under the terms of the GNU General Public License as published by
+ * | the Free Software Foundation, either version 3 of the License, or
+ * | any later version.
+ * |
+ * | This program is distributed in the hope that it will be useful,
+ * | but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * | MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * | GNU General Public License for more details.
+ * |
+ * | You should have received a copy of the GNU General Public License
+ * | along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * |----------------------------------------------------------------------
+ */
+#include "esp8266_websocket.h"
+
+/* Socket states */
+#define WEBSOCKET_STATE_IDLE           0
+#define WEBSOCKET_STATE_CONNECTING     1
+#define WEBSOCKET_STATE_HANDSHAKE      2
+#define WEBSOCKET_STATE_OPEN           3
+#define WEBSOCKET_STATE_CLOSED         4
+
+/* Handshake header flags */
+#define WEBSOCKET_UPGRADE              0x01
+#define WEBSOCKET_KEY                  0x02
+#define WEBSOCKET_VERSION              0x04
+#define WEBSOCKET_ACCEPT               0x08
+
+/* Frame header bits */
+#define WEBSOCKET_FIN                  0x80
+#define WEBSOCKET_RSV                  0x70
+#define WEBSOCKET_MASK                 0x80
+
+/* Close status codes */
+#define WEBSOCKET_CLOSE_PROTOCOL       1002
+#define WEBSOCKET_CLOSE_NOSTATUS       1005
+#define WEBSOCKET_CLOSE_ABNORMAL       1006
+#define WEBSOCKET_CLOSE_TOOBIG         1009
+
+/* GUID appended to key for accept value */
+#define WEBSOCKET_GUID                 "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+/* Private functions */
+static void HandlerConnected(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void HandlerError(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static uint16_t HandlerSendData(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer, uint16_t max_buffer_size);
+static void HandlerDataSent(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t success);
+static void HandlerDataReceived(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer);
+static void HandlerClosed(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection);
+static void HandlerHeader(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const char* line);
+static void ResetSocket(ESP8266_WEBSOCKET_t* Socket);
+static void Parse(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, uint8_t* data, uint16_t length);
+static void FrameStart(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket);
+static void FrameEnd(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket);
+static void Fail(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, uint16_t code);
+static void QueueControl(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, uint8_t opcode, const uint8_t* data, uint8_t length);
+static void SendPending(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket);
+static ESP8266_Result_t SendFrame(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, uint8_t first, const uint8_t* data, uint16_t length);
+static uint8_t Random(ESP8266_t* ESP8266, uint32_t* value);
+static void AcceptValue(const char* key, char* out);
+static void SHA1Block(uint32_t* hash, const uint8_t* block);
+static void Base64(const uint8_t* data, uint8_t length, char* out);
+
+/* Connection handler of sockets */
+static const ESP8266_Handler_t WEBSOCKET_Handler = {
+	HandlerConnected,
+	HandlerError,
+	HandlerSendData,
+	HandlerDataSent,
+	HandlerDataReceived,
+	HandlerClosed,
+	HandlerHeader,
+	NULL
+};
+
+/* Random generator state for keys and masks */
+static uint32_t RandomState = 0x2545F491;
+
+/******************************************/
+/*             Public functions           */
+/******************************************/
+void ESP8266_WEBSOCKET_Header(ESP8266_WEBSOCKET_t* Socket, const char* line) {
+	/* Check handshake headers of request */
+	if (ESP8266_HeaderMatch(line, "upgrade:")) {
+		/* Protocol must be websocket */
+		for (line += 8; *line; line++) {
+			if (ESP8266_HeaderMatch(line, "websocket")) {
+				Socket->Upgrade |= WEBSOCKET_UPGRADE;
+			}
+		}
+	} else if (ESP8266_HeaderMatch(line, "sec-websocket-key:")) {
+		/* Key is 16 bytes encoded with base64 */
+		line = ESP8266_SkipSpaces(line + 18);
+		if (strlen(line) == 24) {
+			strcpy(Socket->Key, line);
+			Socket->Upgrade |= WEBSOCKET_KEY;
+		}
+	} else if (ESP8266_HeaderMatch(line, "sec-websocket-version:")) {
+		/* Only version 13 is supported */
+		line = ESP8266_SkipSpaces(line + 22);
+		if (line[0] == '1' && line[1] == '3' && (line[2] < '0' || line[2] > '9')) {
+			Socket->Upgrade |= WEBSOCKET_VERSION;
+		}
+	}
+}
+
+ESP8266_Result_t ESP8266_WEBSOCKET_Accept(ESP8266_t* ESP8266, ESP8266_HTTPD_Request_t* Request, ESP8266_WEBSOCKET_t* Socket) {
+	uint8_t upgrade = Socket->Upgrade;
+	
+	/* Headers are used once */
+	Socket->Upgrade = 0;
+	
+	/* Request must be valid handshake on persistent connection */
+	if (upgrade != (WEBSOCKET_UPGRADE | WEBSOCKET_KEY | WEBSOCKET_VERSION) || !Request->KeepAlive) {
+		return ESP8266_HTTPD_Respond(ESP8266, Request, 400, NULL, NULL, 0);
+	}
+	
+	/* Prepare socket */
+	ResetSocket(Socket);
+	Socket->Connection = Request->Connection;
+	Socket->Client = 0;
+	
+	/* Response headers with accept value */
+	AcceptValue(Socket->Key, Socket->Accept);
+	sprintf(Socket->Head, "Upgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n", Socket->Accept);
+	
+	/* Send response */
+	if (ESP8266_HTTPD_Respond(ESP8266, Request, 101, Socket->Head, NULL, 0) != ESP_OK) {
+		return ESP_ERROR;
+	}
+	
+	/* Connection is handled by socket from now, frames may follow response immediately */
+	Socket->State = WEBSOCKET_STATE_HANDSHAKE;
+	Socket->Sending = 1;
+	Request->Connection->Handler = &WEBSOCKET_Handler;
+	Request->Connection->UserParameters = Socket;
+	
+#if ESP8266_USE_PASSIVE_RECEIVE
+	/* Frames are read from module again */
+	ESP8266_SetReceiveHold(ESP8266, Request->Connection, 0);
+#endif
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+ESP8266_Result_t ESP8266_WEBSOCKET_Connect(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, const char* host, uint16_t port, const char* path) {
+	ESP8266_Connection_t* Connection;
+	ESP8266_Result_t result;
+	uint32_t value;
+	uint8_t key[16];
+	uint8_t i;
+	
+	/* Random key, handshake is not possible without random generator of user */
+	for (i = 0; i < 16; i++) {
+		if (!Random(ESP8266, &value)) {
+			return ESP_ERROR;
+		}
+		key[i] = (uint8_t)value;
+	}
+	
+	/* Start connection */
+	result = ESP8266_StartClientConnection(ESP8266, (char *)host, (char *)host, port ? port : 80, Socket);
+	if (result != ESP_OK) {
+		return result;
+	}
+	
+	/* Attach handler to connection */
+	Connection = &ESP8266->Connection[ESP8266->StartConnectionSent];
+	Connection->Handler = &WEBSOCKET_Handler;
+	
+	/* Prepare socket */
+	ResetSocket(Socket);
+	Socket->Connection = Connection;
+	Socket->Client = 1;
+	Socket->Host = host;
+	Socket->Path = path;
+	Socket->State = WEBSOCKET_STATE_CONNECTING;
+	
+	/* Key and accept value server must return */
+	Base64(key, 16, Socket->Key);
+	AcceptValue(Socket->Key, Socket->Accept);
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+ESP8266_Result_t ESP8266_WEBSOCKET_Send(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, ESP8266_WEBSOCKET_Opcode_t opcode, const void* data, uint16_t length, uint8_t final) {
+	/* Socket must be open */
+	if (Socket->State != WEBSOCKET_STATE_OPEN || Socket->CloseSent) {
+		return ESP_ERROR;
+	}
+	
+	/* Control frames go first */
+	if (Socket->Sending || Socket->Pending) {
+		return ESP_BUSY;
+	}
+	
+	/* Send frame */
+	return SendFrame(ESP8266, Socket, (uint8_t)opcode | (final ? WEBSOCKET_FIN : 0), (const uint8_t *)data, length);
+}
+
+ESP8266_Result_t ESP8266_WEBSOCKET_Ping(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket) {
+	/* Socket must be open */
+	if (Socket->State != WEBSOCKET_STATE_OPEN || Socket->CloseSent) {
+		return ESP_ERROR;
+	}
+	
+	/* Control frame is already waiting */
+	if (Socket->Pending) {
+		return ESP_BUSY;
+	}
+	
+	/* Send ping without payload */
+	QueueControl(ESP8266, Socket, ESP8266_WEBSOCKET_PING, NULL, 0);
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+ESP8266_Result_t ESP8266_WEBSOCKET_Close(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, uint16_t code) {
+	uint8_t data[2];
+	
+	/* Socket must be open */
+	if (Socket->State != WEBSOCKET_STATE_OPEN || Socket->CloseSent) {
+		return ESP_ERROR;
+	}
+	
+	/* Close frame with status code */
+	data[0] = code >> 8;
+	data[1] = code & 0xFF;
+	QueueControl(ESP8266, Socket, ESP8266_WEBSOCKET_CLOSE, data, 2);
+	
+	/* Return OK */
+	return ESP_OK;
+}
+
+/******************************************/
+/*            Handler functions           */
+/******************************************/
+static void HandlerConnected(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	ESP8266_WEBSOCKET_t* Socket = (ESP8266_WEBSOCKET_t *)Connection->UserParameters;
+	
+	/* Only client connections are started by socket */
+	if (Socket == NULL || Socket->State != WEBSOCKET_STATE_CONNECTING) {
+		return;
+	}
+	
+	/* Handshake request */
+	Socket->Segments[0].Data = "GET ";
+	Socket->Segments[0].Length = 4;
+	Socket->Segments[1].Data = Socket->Path;
+	Socket->Segments[1].Length = strlen(Socket->Path);
+	Socket->Segments[2].Data = " HTTP/1.1\r\nHost: ";
+	Socket->Segments[2].Length = 17;
+	Socket->Segments[3].Data = Socket->Host;
+	Socket->Segments[3].Length = strlen(Socket->Host);
+	Socket->Segments[4].Data = "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Version: 13\r\nSec-WebSocket-Key: ";
+	Socket->Segments[4].Length = strlen(Socket->Segments[4].Data);
+	Socket->Segments[5].Data = Socket->Key;
+	Socket->Segments[5].Length = 24;
+	Socket->Segments[6].Data = "\r\n\r\n";
+	Socket->Segments[6].Length = 4;
+	
+	/* Send request directly from segments */
+	if (ESP8266_RequestSendSegments(ESP8266, Connection, Socket->Segments, 7) != ESP_OK) {
+		ESP8266_CloseConnection(ESP8266, Connection);
+		return;
+	}
+	Socket->State = WEBSOCKET_STATE_HANDSHAKE;
+	Socket->Sending = 1;
+}
+
+static void HandlerError(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	ESP8266_WEBSOCKET_t* Socket = (ESP8266_WEBSOCKET_t *)Connection->UserParameters;
+	
+	/* Connection is not used anymore, it might still be active until it is closed */
+	Connection->UserParameters = NULL;
+	
+	/* Client connection failed or lost data */
+	if (Socket != NULL && Socket->State != WEBSOCKET_STATE_CLOSED) {
+		Socket->State = WEBSOCKET_STATE_CLOSED;
+		Socket->Connection = NULL;
+		if (Socket->Closed != NULL) {
+			Socket->Closed(ESP8266, Socket, WEBSOCKET_CLOSE_ABNORMAL);
+		}
+	}
+}
+
+static uint16_t HandlerSendData(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer, uint16_t max_buffer_size) {
+	ESP8266_WEBSOCKET_t* Socket = (ESP8266_WEBSOCKET_t *)Connection->UserParameters;
+	uint32_t offset = Connection->SendOffset;
+	uint32_t position;
+	uint16_t i;
+	
+	/* Copy header, then payload masked with key at the end of header */
+	for (i = 0; i < max_buffer_size; i++, offset++) {
+		if (offset < Socket->SendHeadLength) {
+			Buffer[i] = Socket->SendHead[offset];
+		} else {
+			position = offset - Socket->SendHeadLength;
+			Buffer[i] = Socket->SendData[position] ^ Socket->SendHead[Socket->SendHeadLength - 4 + (position & 0x03)];
+		}
+	}
+	
+	/* Chunk is filled */
+	return max_buffer_size;
+}
+
+static void HandlerDataSent(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, uint8_t success) {
+	ESP8266_WEBSOCKET_t* Socket = (ESP8266_WEBSOCKET_t *)Connection->UserParameters;
+	
+	/* Frame was sent */
+	if (Socket == NULL) {
+		return;
+	}
+	Socket->Sending = 0;
+	
+	/* Connection is broken */
+	if (!success) {
+		ESP8266_CloseConnection(ESP8266, Connection);
+		return;
+	}
+	
+	/* Server handshake response was sent */
+	if (Socket->State == WEBSOCKET_STATE_HANDSHAKE && !Socket->Client) {
+		Socket->State = WEBSOCKET_STATE_OPEN;
+		if (Socket->Open != NULL) {
+			Socket->Open(ESP8266, Socket);
+		}
+	}
+	
+	/* Both close frames were exchanged */
+	if (Socket->CloseSent && Socket->CloseReceived && !Socket->Pending) {
+		ESP8266_CloseConnection(ESP8266, Connection);
+		return;
+	}
+	
+	/* Send control frame which waits */
+	SendPending(ESP8266, Socket);
+}
+
+static void HandlerDataReceived(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer) {
+	ESP8266_WEBSOCKET_t* Socket = (ESP8266_WEBSOCKET_t *)Connection->UserParameters;
+	
+	/* Socket does not receive */
+	if (Socket == NULL || Socket->State < WEBSOCKET_STATE_HANDSHAKE || Socket->State == WEBSOCKET_STATE_CLOSED) {
+		return;
+	}
+	
+	/* Client waits for entire response head */
+	if (Socket->Client && Socket->State == WEBSOCKET_STATE_HANDSHAKE) {
+		if (!Connection->HeadersDone) {
+			/* Response is not HTTP */
+			if (Connection->BodyOffset < Connection->DataSize) {
+				ESP8266_CloseConnection(ESP8266, Connection);
+			}
+			return;
+		}
+		
+		/* Server must switch protocol with accept value for our key */
+		if (Connection->StatusCode != 101 || Socket->Upgrade != (WEBSOCKET_UPGRADE | WEBSOCKET_ACCEPT)) {
+			ESP8266_CloseConnection(ESP8266, Connection);
+			return;
+		}
+		Socket->State = WEBSOCKET_STATE_OPEN;
+		if (Socket->Open != NULL) {
+			Socket->Open(ESP8266, Socket);
+		}
+	}
+	
+	/* Frames after head */
+	Parse(ESP8266, Socket, (uint8_t *)&Buffer[Connection->BodyOffset], Connection->DataSize - Connection->BodyOffset);
+}
+
+static void HandlerClosed(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
+	ESP8266_WEBSOCKET_t* Socket = (ESP8266_WEBSOCKET_t *)Connection->UserParameters;
+	
+	/* Connection is not used anymore */
+	Connection->UserParameters = NULL;
+	if (Socket == NULL || Socket->State == WEBSOCKET_STATE_CLOSED) {
+		return;
+	}
+	Socket->State = WEBSOCKET_STATE_CLOSED;
+	Socket->Connection = NULL;
+	
+	/* Notify user with status of close frame */
+	if (Socket->Closed != NULL) {
+		Socket->Closed(ESP8266, Socket, Socket->CloseReceived ? Socket->CloseCode : WEBSOCKET_CLOSE_ABNORMAL);
+	}
+}
+
+static void HandlerHeader(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, const char* line) {
+	ESP8266_WEBSOCKET_t* Socket = (ESP8266_WEBSOCKET_t *)Connection->UserParameters;
+	uint16_t length;
+	
+	/* Only client handshake response is parsed */
+	if (Socket == NULL || !Socket->Client || Socket->State != WEBSOCKET_STATE_HANDSHAKE) {
+		return;
+	}
+	
+	/* Check handshake headers of response */
+	if (ESP8266_HeaderMatch(line, "upgrade:")) {
+		ESP8266_WEBSOCKET_Header(Socket, line);
+	} else if (ESP8266_HeaderMatch(line, "sec-websocket-accept:")) {
+		/* Line may be cut, compare part which was received */
+		line = ESP8266_SkipSpaces(line + 21);
+		length = strlen(line);
+		if (length >= 20 && length <= 28 && strncmp(line, Socket->Accept, length) == 0) {
+			Socket->Upgrade |= WEBSOCKET_ACCEPT;
+		}
+	}
+}
+
+/******************************************/
+/*            Private functions           */
+/******************************************/
+static void ResetSocket(ESP8266_WEBSOCKET_t* Socket) {
+	/* Clear state of previous connection */
+	Socket->Opcode = 0;
+	Socket->MessageLength = 0;
+	Socket->State = WEBSOCKET_STATE_IDLE;
+	Socket->Upgrade = 0;
+	Socket->FrameHeadLength = 0;
+	Socket->FramePayload = 0;
+	Socket->Pending = 0;
+	Socket->CloseSent = 0;
+	Socket->CloseReceived = 0;
+	Socket->CloseCode = 0;
+	Socket->Sending = 0;
+}
+
+static void Parse(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, uint8_t* data, uint16_t length) {
+	uint8_t* mask;
+	uint16_t count, i;
+	uint8_t size;
+	
+	/* Data after close frame are ignored */
+	while (length && !Socket->CloseReceived) {
+		/* Collect frame header */
+		if (!Socket->FramePayload) {
+			Socket->Frame[Socket->FrameHeadLength++] = *data++;
+			length--;
+			
+			/* Header size is known after second byte */
+			if (Socket->FrameHeadLength < 2) {
+				continue;
+			}
+			size = 2 + ((Socket->Frame[1] & 0x7F) == 126 ? 2 : ((Socket->Frame[1] & 0x7F) == 127 ? 8 : 0)) + ((Socket->Frame[1] & WEBSOCKET_MASK) ? 4 : 0);
+			if (Socket->FrameHeadLength < size) {
+				continue;
+			}
+			
+			/* Header is complete */
+			FrameStart(ESP8266, Socket);
+			continue;
+		}
+		
+		/* Part of payload in this packet */
+		count = length;
+		if (count > (Socket->FrameLength - Socket->FrameReceived)) {
+			count = Socket->FrameLength - Socket->FrameReceived;
+		}
+		
+		/* Unmask in connection buffer */
+		if (Socket->Frame[1] & WEBSOCKET_MASK) {
+			mask = &Socket->Frame[Socket->FrameHeadLength - 4];
+			for (i = 0; i < count; i++) {
+				data[i] ^= mask[(Socket->FrameReceived + i) & 0x03];
+			}
+		}
+		
+		/* Control payload is saved, message payload goes to user */
+		if (Socket->FrameOpcode & 0x08) {
+			memcpy(&Socket->Control[Socket->FrameReceived], data, count);
+		} else {
+			Socket->MessageLength += count;
+			if (Socket->Message != NULL) {
+				Socket->Message(ESP8266, Socket, data, count, (Socket->Frame[0] & WEBSOCKET_FIN) && (Socket->FrameReceived + count) == Socket->FrameLength);
+			}
+		}
+		Socket->FrameReceived += count;
+		data += count;
+		length -= count;
+		
+		/* Entire payload received */
+		if (Socket->FrameReceived == Socket->FrameLength) {
+			FrameEnd(ESP8266, Socket);
+		}
+	}
+}
+
+static void FrameStart(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket) {
+	uint8_t opcode = Socket->Frame[0] & 0x0F;
+	uint8_t length = Socket->Frame[1] & 0x7F;
+	
+	/* Extensions are not negotiated, client frames are masked and server frames are not */
+	if ((Socket->Frame[0] & WEBSOCKET_RSV) || ((Socket->Frame[1] & WEBSOCKET_MASK) ? 1 : 0) == Socket->Client) {
+		Fail(ESP8266, Socket, WEBSOCKET_CLOSE_PROTOCOL);
+		return;
+	}
+	
+	/* Payload length */
+	if (length == 126) {
+		Socket->FrameLength = ((uint32_t)Socket->Frame[2] << 8) | Socket->Frame[3];
+	} else if (length == 127) {
+		/* Payloads over 4 GB are not supported */
+		if (Socket->Frame[2] || Socket->Frame[3] || Socket->Frame[4] || Socket->Frame[5]) {
+			Fail(ESP8266, Socket, WEBSOCKET_CLOSE_TOOBIG);
+			return;
+		}
+		Socket->FrameLength = ((uint32_t)Socket->Frame[6] << 24) | ((uint32_t)Socket->Frame[7] << 16) | ((uint32_t)Socket->Frame[8] << 8) | Socket->Frame[9];
+	} else {
+		Socket->FrameLength = length;
+	}
+	
+	/* Check opcode */
+	if (opcode & 0x08) {
+		/* Control frames are not fragmented and have short payload */
+		if (opcode > ESP8266_WEBSOCKET_PONG || !(Socket->Frame[0] & WEBSOCKET_FIN) || Socket->FrameLength > ESP8266_WEBSOCKET_CONTROL_SIZE) {
+			Fail(ESP8266, Socket, WEBSOCKET_CLOSE_PROTOCOL);
+			return;
+		}
+	} else if (opcode == ESP8266_WEBSOCKET_CONTINUATION) {
+		/* Continuation needs message in progress */
+		if (!Socket->Opcode) {
+			Fail(ESP8266, Socket, WEBSOCKET_CLOSE_PROTOCOL);
+			return;
+		}
+	} else {
+		/* New message can not start inside other message */
+		if (opcode > ESP8266_WEBSOCKET_BINARY || Socket->Opcode) {
+			Fail(ESP8266, Socket, WEBSOCKET_CLOSE_PROTOCOL);
+			return;
+		}
+		Socket->Opcode = opcode;
+		Socket->MessageLength = 0;
+	}
+	Socket->FrameOpcode = opcode;
+	Socket->FrameReceived = 0;
+	Socket->FramePayload = 1;
+	
+	/* Frame without payload ends immediately */
+	if (Socket->FrameLength == 0) {
+		FrameEnd(ESP8266, Socket);
+	}
+}
+
+static void FrameEnd(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket) {
+	/* Next frame header follows */
+	Socket->FrameHeadLength = 0;
+	Socket->FramePayload = 0;
+	
+	/* Check frame type */
+	switch (Socket->FrameOpcode) {
+		case ESP8266_WEBSOCKET_PING:
+			/* Answer with the same payload */
+			if (!Socket->CloseSent) {
+				QueueControl(ESP8266, Socket, ESP8266_WEBSOCKET_PONG, Socket->Control, Socket->FrameLength);
+			}
+			break;
+		case ESP8266_WEBSOCKET_PONG:
+			/* Nothing to do */
+			break;
+		case ESP8266_WEBSOCKET_CLOSE:
+			/* Save status code, close frame without code means no status */
+			Socket->CloseReceived = 1;
+			Socket->CloseCode = Socket->FrameLength >= 2 ? (((uint16_t)Socket->Control[0] << 8) | Socket->Control[1]) : WEBSOCKET_CLOSE_NOSTATUS;
+			
+			/* Answer with the same code or close connection when we started closing */
+			if (!Socket->CloseSent) {
+				QueueControl(ESP8266, Socket, ESP8266_WEBSOCKET_CLOSE, Socket->Control, Socket->FrameLength >= 2 ? 2 : 0);
+			} else if (!Socket->Sending && !Socket->Pending) {
+				ESP8266_CloseConnection(ESP8266, Socket->Connection);
+			}
+			break;
+		default:
+			/* Zero length last frame ends message too */
+			if (Socket->Frame[0] & WEBSOCKET_FIN) {
+				if (Socket->FrameLength == 0 && Socket->Message != NULL) {
+					Socket->Message(ESP8266, Socket, NULL, 0, 1);
+				}
+				Socket->Opcode = 0;
+			}
+			break;
+	}
+}
+
+static void Fail(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, uint16_t code) {
+	uint8_t data[2];
+	
+	/* Stop parsing, connection is closed after close frame is sent */
+	Socket->CloseReceived = 1;
+	Socket->CloseCode = code;
+	Socket->FrameHeadLength = 0;
+	Socket->FramePayload = 0;
+	
+	/* Send close frame with error code */
+	if (!Socket->CloseSent) {
+		data[0] = code >> 8;
+		data[1] = code & 0xFF;
+		QueueControl(ESP8266, Socket, ESP8266_WEBSOCKET_CLOSE, data, 2);
+	} else if (!Socket->Sending) {
+		ESP8266_CloseConnection(ESP8266, Socket->Connection);
+	}
+}
+
+static void QueueControl(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, uint8_t opcode, const uint8_t* data, uint8_t length) {
+	/* Nothing is sent after close frame */
+	if (Socket->CloseSent) {
+		return;
+	}
+	
+	/* Save frame, it replaces other control frame which waits */
+	if (length) {
+		memcpy(Socket->PendingData, data, length);
+	}
+	Socket->PendingLength = length;
+	Socket->Pending = opcode;
+	if (opcode == ESP8266_WEBSOCKET_CLOSE) {
+		Socket->CloseSent = 1;
+	}
+	
+	/* Send it now if possible */
+	SendPending(ESP8266, Socket);
+}
+
+static void SendPending(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket) {
+	uint8_t offset = Socket->Client ? 6 : 2;
+	uint8_t opcode = Socket->Pending;
+	
+	/* Wait for frame which is being sent */
+	if (!opcode || Socket->Sending || Socket->State == WEBSOCKET_STATE_CLOSED) {
+		return;
+	}
+	
+	/* Copy payload after header, so next control frame can wait while this one is sent */
+	memcpy(&Socket->SendHead[offset], Socket->PendingData, Socket->PendingLength);
+	Socket->Pending = 0;
+	if (SendFrame(ESP8266, Socket, WEBSOCKET_FIN | opcode, &Socket->SendHead[offset], Socket->PendingLength) != ESP_OK) {
+		ESP8266_CloseConnection(ESP8266, Socket->Connection);
+	}
+}
+
+static ESP8266_Result_t SendFrame(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, uint8_t first, const uint8_t* data, uint16_t length) {
+	ESP8266_Result_t result;
+	uint32_t mask;
+	
+	/* Header with short or 16-bit length */
+	Socket->SendHead[0] = first;
+	if (length < 126) {
+		Socket->SendHead[1] = length;
+		Socket->SendHeadLength = 2;
+	} else {
+		Socket->SendHead[1] = 126;
+		Socket->SendHead[2] = length >> 8;
+		Socket->SendHead[3] = length & 0xFF;
+		Socket->SendHeadLength = 4;
+	}
+	Socket->SendData = data;
+	Socket->SendLength = length;
+	
+	/* Client masks payload while it is copied to send buffer */
+	if (Socket->Client) {
+		if (!Random(ESP8266, &mask)) {
+			return ESP_ERROR;
+		}
+		Socket->SendHead[1] |= WEBSOCKET_MASK;
+		memcpy(&Socket->SendHead[Socket->SendHeadLength], &mask, 4);
+		Socket->SendHeadLength += 4;
+		result = ESP8266_RequestSendStream(ESP8266, Socket->Connection, Socket->SendHeadLength + length);
+	} else {
+		/* Server sends payload directly from user memory */
+		Socket->Segments[0].Data = Socket->SendHead;
+		Socket->Segments[0].Length = Socket->SendHeadLength;
+		Socket->Segments[1].Data = data;
+		Socket->Segments[1].Length = length;
+		result = ESP8266_RequestSendSegments(ESP8266, Socket->Connection, Socket->Segments, length ? 2 : 1);
+	}
+	
+	/* Frame is being sent */
+	if (result == ESP_OK) {
+		Socket->Sending = 1;
+	}
+	return result;
+}
+
+static uint8_t Random(ESP8266_t* ESP8266, uint32_t* value) {
+	/* Entropy of user is required */
+	if (!ESP8266_WEBSOCKET_Callback_Random(ESP8266, value)) {
+		return 0;
+	}
+	
+	/* Xorshift generator, mixed with entropy of user */
+	RandomState ^= *value;
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+	*value = RandomState;
+	return 1;
+}
+
+static void AcceptValue(const char* key, char* out) {
+	uint8_t block[128];
+	uint8_t digest[20];
+	uint32_t hash[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+	uint8_t i;
+	
+	/* Key and GUID are 60 bytes, padded to two blocks with length of 480 bits */
+	memcpy(block, key, 24);
+	memcpy(&block[24], WEBSOCKET_GUID, 36);
+	memset(&block[60], 0, sizeof(block) - 60);
+	block[60] = 0x80;
+	block[126] = 0x01;
+	block[127] = 0xE0;
+	
+	/* SHA-1 of both blocks */
+	SHA1Block(hash, block);
+	SHA1Block(hash, &block[64]);
+	for (i = 0; i < 20; i++) {
+		digest[i] = hash[i >> 2] >> (24 - 8 * (i & 0x03));
+	}
+	
+	/* Accept value is digest encoded with base64 */
+	Base64(digest, 20, out);
+}
+
+static void SHA1Block(uint32_t* hash, const uint8_t* block) {
+	uint32_t w[16];
+	uint32_t a, b, c, d, e, f, k, t;
+	uint8_t i;
+	
+	/* Load working values */
+	a = hash[0];
+	b = hash[1];
+	c = hash[2];
+	d = hash[3];
+	e = hash[4];
+	
+	/* 80 rounds, message schedule is kept in circular array */
+	for (i = 0; i < 80; i++) {
+		if (i < 16) {
+			w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) | ((uint32_t)block[4 * i + 2] << 8) | block[4 * i + 3];
+		} else {
+			t = w[(i + 13) & 0x0F] ^ w[(i + 8) & 0x0F] ^ w[(i + 2) & 0x0F] ^ w[i & 0x0F];
+			w[i & 0x0F] = (t << 1) | (t >> 31);
+		}
+		if (i < 20) {
+			f = (b & c) | (~b & d);
+			k = 0x5A827999;
+		} else if (i < 40) {
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1;
+		} else if (i < 60) {
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDC;
+		} else {
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6;
+		}
+		t = ((a << 5) | (a >> 27)) + f + e + k + w[i & 0x0F];
+		e = d;
+		d = c;
+		c = (b << 30) | (b >> 2);
+		b = a;
+		a = t;
+	}
+	
+	/* Add to hash */
+	hash[0] += a;
+	hash[1] += b;
+	hash[2] += c;
+	hash[3] += d;
+	hash[4] += e;
+}
+
+static void Base64(const uint8_t* data, uint8_t length, char* out) {
+	static const char Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	uint32_t value;
+	uint8_t i;
+	
+	/* Each 3 bytes give 4 characters, missing bytes are padded */
+	for (i = 0; i < length; i += 3) {
+		value = (uint32_t)data[i] << 16;
+		if ((i + 1) < length) {
+			value |= (uint32_t)data[i + 1] << 8;
+		}
+		if ((i + 2) < length) {
+			value |= data[i + 2];
+		}
+		*out++ = Alphabet[(value >> 18) & 0x3F];
+		*out++ = Alphabet[(value >> 12) & 0x3F];
+		*out++ = (i + 1) < length ? Alphabet[(value >> 6) & 0x3F] : '=';
+		*out++ = (i + 2) < length ? Alphabet[value & 0x3F] : '=';
+	}
+	*out = 0;
+}
+
+/******************************************/
+/*                CALLBACKS               */
+/******************************************/
+/* Called when random number is needed for key or mask */
+__weak uint8_t ESP8266_WEBSOCKET_Callback_Random(ESP8266_t* ESP8266, uint32_t* value) {
+	/* NOTE: This function Should not be modified, when the callback is needed,
+           the ESP8266_WEBSOCKET_Callback_Random could be implemented in the user file
+	*/
+	
+	/* There is no random generator, client can not connect */
+	return 0;
+}
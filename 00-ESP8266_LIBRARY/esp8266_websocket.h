@@ -0,0 +1,335 @@
+/**
+ * @author  Tilen Majerle
+ * @email   tilen@majerle.eu
+ * @website http://stm32f4-discovery.com
+ * @link
+ * @version v0.1
+ * @ide     Keil uVision
+ * @license GNU GPL v3
+ * @brief   WebSocket server and client connections on top of ESP8266 connections
+ *
+\verbatim
+   ----------------------------------------------------------------------
+    Copyright (C) Tilen Majerle, 2016
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+   ----------------------------------------------------------------------
+\endverbatim
+ */
+#ifndef ESP8266_WEBSOCKET_H
+#define ESP8266_WEBSOCKET_H 001
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup ESP8266_WEBSOCKET
+ * @brief    WebSocket server and client connections on top of ESP8266 connections
+ * @{
+ *
+ * After handshake, one connection stays open and messages are sent in both directions without new HTTP requests.
+ *
+ * Frames are decoded as they are received, also when frame is split to multiple +IPD packets.
+ * Payload is unmasked in connection buffer and passed to message function in parts, it is not saved.
+ * Ping frames are answered with pong frames automatically.
+ *
+ * \par Server
+ *
+ * Server connections are accepted from route of HTTP server. Route passes header lines to @ref ESP8266_WEBSOCKET_Header
+ * and calls @ref ESP8266_WEBSOCKET_Accept from its handler:
+ *
+\code{.c}
+static ESP8266_WEBSOCKET_t Sockets[ESP8266_MAX_CONNECTIONS];
+
+static void SocketHeader(ESP8266_t* ESP8266, ESP8266_HTTPD_Request_t* Request, const char* line) {
+	ESP8266_WEBSOCKET_Header(&Sockets[Request->Connection->Number], line);
+}
+
+static void SocketHandler(ESP8266_t* ESP8266, ESP8266_HTTPD_Request_t* Request) {
+	ESP8266_WEBSOCKET_t* Socket = &Sockets[Request->Connection->Number];
+	
+	//Set functions and accept connection
+	Socket->Message = SocketMessage;
+	ESP8266_WEBSOCKET_Accept(ESP8266, Request, Socket);
+}
+
+static const ESP8266_HTTPD_Route_t Routes[] = {
+	{"GET", "/ws", SocketHandler, NULL, SocketHeader},
+};
+\endcode
+ *
+ * \par Client
+ *
+ * Client connection is started with @ref ESP8266_WEBSOCKET_Connect. Open function is called when server accepts handshake.
+ *
+ * \par Sending
+ *
+ * Only one frame can be sent at a time on connection. Server frames are sent with @ref ESP8266_RequestSendSegments,
+ * frame header from socket structure and payload directly from user memory.
+ * Client frames must be masked, so payload is masked while it is copied to send buffer of stack with @ref ESP8266_RequestSendStream.
+ *
+ * Large messages can be sent as fragments, first frame with text or binary opcode and next frames with continuation opcode.
+ *
+ * \par Random numbers
+ *
+ * Handshake key and masks of client frames are made with xorshift generator, mixed with value of
+ * @ref ESP8266_WEBSOCKET_Callback_Random on each call. RFC 6455 requires masks which can not be predicted,
+ * so client needs callback implemented in user file with hardware RNG or ADC noise. Default implementation has no source of randomness,
+ * @ref ESP8266_WEBSOCKET_Connect returns ESP_ERROR and client can not connect. Server does not need random numbers.
+ *
+\code
+uint8_t ESP8266_WEBSOCKET_Callback_Random(ESP8266_t* ESP8266, uint32_t* value) {
+	//Use hardware random generator of STM32F4xx
+	return HAL_RNG_GenerateRandomNumber(&hrng, value) == HAL_OK;
+}
+\endcode
+ *
+ * \par Changelog
+ *
+\verbatim
+ Version 0.1
+  - First release
+\endverbatim
+ *
+ * \par Dependencies
+ *
+\verbatim
+ - ESP8266 stack
+ - ESP8266 HTTP server
+\endverbatim
+ */
+
+/* Include ESP layer */
+#include "esp8266.h"
+#include "esp8266_httpd.h"
+
+/**
+ * @defgroup ESP8266_WEBSOCKET_Macros
+ * @brief    Library defines
+ * @{
+ */
+
+/**
+ * @brief  Maximal payload length of control frame by WebSocket protocol
+ */
+#define ESP8266_WEBSOCKET_CONTROL_SIZE     125
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup ESP8266_WEBSOCKET_Typedefs
+ * @brief    Library Typedefs
+ * @{
+ */
+
+/**
+ * @brief  Frame opcodes
+ */
+typedef enum {
+	ESP8266_WEBSOCKET_CONTINUATION = 0x00, /*!< Next fragment of message */
+	ESP8266_WEBSOCKET_TEXT = 0x01,         /*!< Text message */
+	ESP8266_WEBSOCKET_BINARY = 0x02,       /*!< Binary message */
+	ESP8266_WEBSOCKET_CLOSE = 0x08,        /*!< Close frame */
+	ESP8266_WEBSOCKET_PING = 0x09,         /*!< Ping frame */
+	ESP8266_WEBSOCKET_PONG = 0x0A          /*!< Pong frame */
+} ESP8266_WEBSOCKET_Opcode_t;
+
+/* Forward declaration */
+struct _ESP8266_WEBSOCKET_t;
+
+/**
+ * @brief  Function called when connection is open
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Socket: Pointer to @ref ESP8266_WEBSOCKET_t socket
+ */
+typedef void (*ESP8266_WEBSOCKET_Open_t)(ESP8266_t* ESP8266, struct _ESP8266_WEBSOCKET_t* Socket);
+
+/**
+ * @brief  Function which receives part of message
+ * @note   Opcode of message is in @ref ESP8266_WEBSOCKET_t.Opcode
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Socket: Pointer to @ref ESP8266_WEBSOCKET_t socket
+ * @param  *data: Pointer to unmasked message data
+ * @param  length: Number of bytes in data
+ * @param  final: Set to 1 when this is last part of message
+ */
+typedef void (*ESP8266_WEBSOCKET_Message_t)(ESP8266_t* ESP8266, struct _ESP8266_WEBSOCKET_t* Socket, const uint8_t* data, uint16_t length, uint8_t final);
+
+/**
+ * @brief  Function called when connection is closed
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Socket: Pointer to @ref ESP8266_WEBSOCKET_t socket
+ * @param  code: Status code of close frame or 1006 when connection was closed without close frame
+ */
+typedef void (*ESP8266_WEBSOCKET_Closed_t)(ESP8266_t* ESP8266, struct _ESP8266_WEBSOCKET_t* Socket, uint16_t code);
+
+/**
+ * @brief  Socket structure
+ * @note   Structure must stay valid while connection is open
+ */
+typedef struct _ESP8266_WEBSOCKET_t {
+	ESP8266_WEBSOCKET_Open_t Open;      /*!< Function called when connection is open or NULL */
+	ESP8266_WEBSOCKET_Message_t Message; /*!< Function which receives messages or NULL */
+	ESP8266_WEBSOCKET_Closed_t Closed;  /*!< Function called when connection is closed or NULL */
+	void* UserParameters;               /*!< User parameters pointer */
+	ESP8266_Connection_t* Connection;   /*!< Connection of socket */
+	uint8_t Opcode;                     /*!< Opcode of message which is currently received */
+	uint32_t MessageLength;             /*!< Number of bytes of current message passed to message function */
+	uint8_t State;                      /*!< Socket state. Private member */
+	uint8_t Client;                     /*!< Set to 1 when socket is client. Private member */
+	const char* Host;                   /*!< Host of client handshake. Private member */
+	const char* Path;                   /*!< Path of client handshake. Private member */
+	char Key[25];                       /*!< Handshake key. Private member */
+	char Accept[29];                    /*!< Handshake accept value. Private member */
+	uint8_t Upgrade;                    /*!< Handshake header flags. Private member */
+	char Head[96];                      /*!< Headers of server handshake response. Private member */
+	uint8_t Frame[14];                  /*!< Header of received frame. Private member */
+	uint8_t FrameHeadLength;            /*!< Number of received header bytes. Private member */
+	uint8_t FramePayload;               /*!< Set to 1 when header is complete and payload is received. Private member */
+	uint8_t FrameOpcode;                /*!< Opcode of received frame. Private member */
+	uint32_t FrameLength;               /*!< Payload length of received frame. Private member */
+	uint32_t FrameReceived;             /*!< Number of received payload bytes. Private member */
+	uint8_t Control[ESP8266_WEBSOCKET_CONTROL_SIZE]; /*!< Payload of received control frame. Private member */
+	uint8_t Pending;                    /*!< Opcode of control frame waiting to be sent or 0. Private member */
+	uint8_t PendingData[ESP8266_WEBSOCKET_CONTROL_SIZE]; /*!< Payload of control frame waiting to be sent. Private member */
+	uint8_t PendingLength;              /*!< Payload length of control frame waiting to be sent. Private member */
+	uint8_t CloseSent;                  /*!< Set to 1 when close frame was sent. Private member */
+	uint8_t CloseReceived;              /*!< Set to 1 when close frame was received. Private member */
+	uint16_t CloseCode;                 /*!< Status code of close frame. Private member */
+	uint8_t Sending;                    /*!< Set to 1 while frame is sent. Private member */
+	uint8_t SendHead[8 + ESP8266_WEBSOCKET_CONTROL_SIZE]; /*!< Header of sent frame, followed by payload of control frame. Private member */
+	uint8_t SendHeadLength;             /*!< Length of header of sent frame. Private member */
+	const uint8_t* SendData;            /*!< Payload of sent frame. Private member */
+	uint16_t SendLength;                /*!< Payload length of sent frame. Private member */
+	ESP8266_Segment_t Segments[7];      /*!< Segments of sent data. Private member */
+} ESP8266_WEBSOCKET_t;
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup ESP8266_WEBSOCKET_Functions
+ * @brief    Library Functions
+ * @{
+ */
+
+/**
+ * @brief  Checks header line of HTTP server request for handshake
+ * @note   Call it from header function of route for all lines
+ * @param  *Socket: Pointer to @ref ESP8266_WEBSOCKET_t socket for connection of request
+ * @param  *line: Header line
+ * @retval None
+ */
+void ESP8266_WEBSOCKET_Header(ESP8266_WEBSOCKET_t* Socket, const char* line);
+
+/**
+ * @brief  Accepts HTTP server request as WebSocket connection
+ * @note   Call it from handler of route instead of @ref ESP8266_HTTPD_Respond.
+ *         Request which is not valid handshake gets "400 Bad Request" response
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Request: Pointer to @ref ESP8266_HTTPD_Request_t request
+ * @param  *Socket: Pointer to @ref ESP8266_WEBSOCKET_t socket, header lines of request were passed to it
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_WEBSOCKET_Accept(ESP8266_t* ESP8266, ESP8266_HTTPD_Request_t* Request, ESP8266_WEBSOCKET_t* Socket);
+
+/**
+ * @brief  Starts client connection to WebSocket server
+ * @note   Host and path must stay valid until open or closed function is called
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Socket: Pointer to @ref ESP8266_WEBSOCKET_t socket with functions set
+ * @param  *host: Server host name or IP address
+ * @param  port: Server port
+ * @param  *path: Path of request
+ * @return Member of @ref ESP8266_Result_t enumeration. ESP_ERROR is returned when @ref ESP8266_WEBSOCKET_Callback_Random is not implemented
+ */
+ESP8266_Result_t ESP8266_WEBSOCKET_Connect(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, const char* host, uint16_t port, const char* path);
+
+/**
+ * @brief  Sends frame
+ * @note   Data must stay valid until frame is sent. Client frames can not be longer than 65535 bytes
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Socket: Pointer to @ref ESP8266_WEBSOCKET_t socket
+ * @param  opcode: Text or binary opcode for first frame of message, continuation opcode for next fragments
+ * @param  *data: Pointer to frame payload
+ * @param  length: Number of bytes in payload
+ * @param  final: Set to 1 when frame is last fragment of message
+ * @return Member of @ref ESP8266_Result_t enumeration:
+ *            - ESP_OK: Frame is being sent
+ *            - ESP_BUSY: Previous frame is still being sent
+ *            - ESP_ERROR: Socket is not open or client has no random number for mask
+ */
+ESP8266_Result_t ESP8266_WEBSOCKET_Send(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, ESP8266_WEBSOCKET_Opcode_t opcode, const void* data, uint16_t length, uint8_t final);
+
+/**
+ * @brief  Sends ping frame
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Socket: Pointer to @ref ESP8266_WEBSOCKET_t socket
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_WEBSOCKET_Ping(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket);
+
+/**
+ * @brief  Starts closing handshake
+ * @note   Connection is closed when other side answers with close frame
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *Socket: Pointer to @ref ESP8266_WEBSOCKET_t socket
+ * @param  code: Status code of close frame, 1000 for normal closure
+ * @return Member of @ref ESP8266_Result_t enumeration
+ */
+ESP8266_Result_t ESP8266_WEBSOCKET_Close(ESP8266_t* ESP8266, ESP8266_WEBSOCKET_t* Socket, uint16_t code);
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup ESP8266_WEBSOCKET_Callbacks
+ * @brief    Library callback functions
+ *
+ *           Callback functions are called from library to user which should implement it when needs it.
+ * @{
+ */
+
+/**
+ * @brief  Random number callback
+ *
+ *         Function is called each time random number is needed for handshake key or mask of client frame
+ * @param  *ESP8266: Pointer to working @ref ESP8266_t structure
+ * @param  *value: Pointer to variable where random value is saved, it is mixed to state of generator
+ * @retval 1 when value was generated, 0 when there is no random source
+ * @note   Default implementation returns 0, so client handshake and frames fail until user implements it
+ * @note   With weak parameter to prevent link errors if not defined by user
+ */
+uint8_t ESP8266_WEBSOCKET_Callback_Random(ESP8266_t* ESP8266, uint32_t* value);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+#
+# |----------------------------------------------------------------------
+# | Copyright (C) Tilen Majerle, 2016
+# |
+# | This program is free software: you can redistribute it and/or modify
+# | it under the terms of the GNU General Public License as published by
+# | the Free Software Foundation, either version 3 of the License, or
+# | any later version.
+# |
+# | This program is distributed in the hope that it will be useful,
+# | but WITHOUT ANY WARRANTY; without even the implied warranty of
+# | MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# | GNU General Public License for more details.
+# |
+# | You should have received a copy of the GNU General Public License
+# | along with this program.  If not, see <http://www.gnu.org/licenses/>.
+# |----------------------------------------------------------------------
+#
+# Compiles files of directory to constant ESP8266_HTTPD_Asset_t table
+# with prepared response heads, ETags and optionally gzip compressed bodies.
+#
+# Usage: esp8266_httpd_assets.py [--gzip] [--no-identity] [--cache VALUE] [--line-size SIZE] directory name
+#
+# Generates name.c and name.h files with "name" table and "NAME_COUNT" define.
+# File index.html of each directory is also served on directory path.
+# Compressed files are followed by uncompressed copy for clients without gzip,
+# with --no-identity these clients get "406 Not Acceptable" response instead.
+# Paths which server can not match, because they are too long for ESP8266_REQUEST_LINE_SIZE
+# or clients would escape them, are reported as errors.
+#
+import argparse
+import gzip
+import mimetypes
+import os
+import re
+import zlib
+
+# Types of files which are not known on all systems
+TYPES = {
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".woff2": "font/woff2",
+}
+
+# Types which are not compressed again
+COMPRESSED = ("image/png", "image/jpeg", "image/gif", "font/woff2", "application/zip")
+
+# Default value of ESP8266_REQUEST_LINE_SIZE in esp8266_conf.h
+REQUEST_LINE_SIZE = 128
+
+# Characters clients send in path without escaping, server compares paths as received
+PATH_CHARS = re.compile(r"^[A-Za-z0-9/._~!$&'()*+,;=:@-]*$")
+
+
+def content_type(path):
+    # Get type of file from extension
+    ext = os.path.splitext(path)[1].lower()
+    if ext in TYPES:
+        return TYPES[ext]
+    ctype = mimetypes.guess_type(path)[0] or "application/octet-stream"
+    if ctype.startswith("text/"):
+        ctype += "; charset=utf-8"
+    return ctype
+
+
+def c_string(text):
+    # Escape string for C source
+    return '"' + text.replace("\\", "\\\\").replace('"', '\\"').replace("\r", "\\r").replace("\n", "\\n") + '"'
+
+
+def c_bytes(data):
+    # Format bytes as C array initializer, 16 per line
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("\t" + ", ".join("0x%02X" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def collect(root):
+    # Get all files with their request paths, sorted for stable output
+    files = []
+    for base, dirs, names in os.walk(root):
+        dirs.sort()
+        for name in sorted(names):
+            full = os.path.join(base, name)
+            path = "/" + os.path.relpath(full, root).replace(os.sep, "/")
+            files.append((path, full))
+    return files
+
+
+def path_error(path, line_size):
+    # Longest request line is "HEAD path HTTP/1.1", line is refused when it fills stack buffer
+    if not PATH_CHARS.match(path):
+        return "path %s has characters which clients escape" % path
+    if len("HEAD  HTTP/1.1") + len(path) >= line_size - 1:
+        return "path %s is too long for request line size %u, shorten it or increase ESP8266_REQUEST_LINE_SIZE" % (path, line_size)
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compile static files to ESP8266 HTTP server assets",
+                                     epilog="Clients without gzip support get uncompressed copy of compressed file. "
+                                            "When --no-identity is used, these clients get \"406 Not Acceptable\" response.")
+    parser.add_argument("directory", help="directory with files")
+    parser.add_argument("name", help="name of generated table and files")
+    parser.add_argument("--gzip", action="store_true", help="compress files with gzip when they get smaller")
+    parser.add_argument("--no-identity", action="store_true", help="do not store uncompressed copy of compressed files, saves flash")
+    parser.add_argument("--cache", default="no-cache", help="value of Cache-Control header, default no-cache")
+    parser.add_argument("--line-size", type=int, default=REQUEST_LINE_SIZE,
+                        help="value of ESP8266_REQUEST_LINE_SIZE, default %u" % REQUEST_LINE_SIZE)
+    args = parser.parse_args()
+
+    name = os.path.basename(args.name)
+    if not re.match(r"^[A-Za-z_][A-Za-z0-9_]*$", name):
+        parser.error("name must be valid C identifier")
+
+    # Check all paths before anything is generated
+    files = collect(args.directory)
+    for path, full in files:
+        error = path_error(path, args.line_size)
+        if error is not None:
+            parser.error(error)
+
+    assets = []
+    bodies = 0
+    for path, full in files:
+        with open(full, "rb") as f:
+            data = f.read()
+        ctype = content_type(path)
+
+        # Compress when it helps, fixed time makes output reproducible
+        variants = [(data, False)]
+        if args.gzip and ctype not in COMPRESSED:
+            packed = gzip.compress(data, 9, mtime=0)
+            if len(packed) < len(data):
+                variants = [(packed, True)]
+                if not args.no_identity:
+                    variants.append((data, False))
+
+        paths = [path]
+        if os.path.basename(path) == "index.html":
+            paths.insert(0, path[:-len("index.html")])
+        entries = []
+        for body, compressed in variants:
+            # Tag changes whenever sent body changes
+            etag = '"%08x"' % (zlib.crc32(body) & 0xFFFFFFFF)
+
+            # Prepared heads, connection header and blank line are added by server
+            common = "ETag: %s\r\nCache-Control: %s\r\n" % (etag, args.cache)
+            if len(variants) > 1 or compressed:
+                common += "Vary: Accept-Encoding\r\n"
+            head = "HTTP/1.1 200 OK\r\nContent-Length: %u\r\nContent-Type: %s\r\n" % (len(body), ctype)
+            if compressed:
+                head += "Content-Encoding: gzip\r\n"
+            head += common
+            not_modified = "HTTP/1.1 304 Not Modified\r\n" + common
+
+            symbol = "%s_%u" % (name, bodies)
+            bodies += 1
+            entries.append((head, not_modified, etag, symbol, body, compressed))
+
+        # Compressed entry is first, server falls back to next entry of the same path
+        for p in paths:
+            for entry in entries:
+                assets.append((p,) + entry)
+
+    # Source file
+    with open(args.name + ".c", "w", newline="\n") as f:
+        f.write("/* Generated with esp8266_httpd_assets.py, do not edit */\n")
+        f.write('#include "%s.h"\n\n' % name)
+        written = set()
+        for path, head, not_modified, etag, symbol, data, compressed in assets:
+            if symbol in written:
+                continue
+            written.add(symbol)
+            f.write("/* %s, %u bytes%s */\n" % (path, len(data), ", gzip" if compressed else ""))
+            f.write("static const uint8_t %s[%u] = {\n%s\n};\n\n" % (symbol, max(len(data), 1), c_bytes(data) or "\t0x00,"))
+        f.write("const ESP8266_HTTPD_Asset_t %s[%s_COUNT] = {\n" % (name, name.upper()))
+        for path, head, not_modified, etag, symbol, data, compressed in assets:
+            f.write("\t{\n")
+            f.write("\t\t%s,\n" % c_string(path))
+            f.write("\t\t%s,\n" % c_string(head))
+            f.write("\t\t%s,\n" % c_string(not_modified))
+            f.write("\t\t%s,\n" % c_string(etag))
+            f.write("\t\t%s,\n" % symbol)
+            f.write("\t\t%u,\n" % len(data))
+            f.write("\t\t%u\n" % (1 if compressed else 0))
+            f.write("\t},\n")
+        f.write("};\n")
+
+    # Header file
+    guard = name.upper() + "_H"
+    with open(args.name + ".h", "w", newline="\n") as f:
+        f.write("/* Generated with esp8266_httpd_assets.py, do not edit */\n")
+        f.write("#ifndef %s\n#define %s\n\n" % (guard, guard))
+        f.write('#include "esp8266_httpd.h"\n\n')
+        f.write("/* Number of assets in table */\n")
+        f.write("#define %s_COUNT %u\n\n" % (name.upper(), len(assets)))
+        f.write("/* Assets table for AssetsCount and Assets members of ESP8266_HTTPD_t structure */\n")
+        f.write("extern const ESP8266_HTTPD_Asset_t %s[%s_COUNT];\n\n" % (name, name.upper()))
+        f.write("#endif\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,166 @@
+/**
+ * |----------------------------------------------------------------------
+ * | Copyright (C) Tilen Majerle, 2016
+ * |
+ * | This program is free software: you can redistribute it and/or modify
+ * | it under the terms of the GNU General Public License as published by
+ * | the Free Software Foundation, either version 3 of the License, or
+ * | any later version.
+ * |
+ * | This program is distributed in the hope that it will be useful,
+ * | but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * | MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * | GNU General Public License for more details.
+ * |
+ * | You should have received a copy of the GNU General Public License
+ * | along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * |----------------------------------------------------------------------
+ *
+ * Host benchmark of esp8266_inflate decoder.
+ *
+ * Decodes gzip, zlib or raw deflate files in parts of the same size as +IPD packets
+ * and reports throughput of decoder. Format of each file is detected from its first bytes.
+ *
+ * Build on PC, low-level layer is not needed for decoder:
+ *
+ *   gcc -O2 -DESP8266_LL_H -I.. -o esp8266_inflate_bench esp8266_inflate_bench.c ../esp8266_inflate.c
+ *
+ * Fixtures can be made with standard tools:
+ *
+ *   gzip -9 -k file.html
+ *   python -c "import zlib,sys; sys.stdout.buffer.write(zlib.compress(open('file.html','rb').read()))" > file.zz
+ *
+ * Usage: esp8266_inflate_bench [-p part] [-n rounds] file...
+ */
+#include "esp8266_inflate.h"
+#include "stdlib.h"
+#include "time.h"
+
+/* Default size of input parts, maximal data size of one +IPD packet */
+#define BENCH_PART_SIZE       1460
+
+/* Default number of decoding rounds of each file */
+#define BENCH_ROUNDS          20
+
+/* Decoder is too large for stack */
+static ESP8266_INFLATE_t Inflate;
+
+/* Decodes whole file once, returns number of decompressed bytes or -1 on error */
+static long Decode(const uint8_t* data, long length, uint16_t part) {
+	ESP8266_INFLATE_Result_t result = ESP8266_INFLATE_NEED_INPUT;
+	const uint8_t* out;
+	const uint8_t* in;
+	long total = 0;
+	uint16_t count, used;
+	
+	/* Detect format from first bytes */
+	ESP8266_INFLATE_Init(&Inflate, ESP8266_INFLATE_FORMAT_AUTO);
+	
+	/* Feed data in parts as they would be received */
+	while (length > 0 && result != ESP8266_INFLATE_DONE) {
+		count = length > part ? part : (uint16_t)length;
+		in = data;
+		data += count;
+		length -= count;
+		
+		/* Decode part, window may be full before all data are used */
+		do {
+			result = ESP8266_INFLATE_Decode(&Inflate, in, count, &used);
+			in += used;
+			count -= used;
+			
+			/* Read output, data are only counted */
+			while ((used = ESP8266_INFLATE_Output(&Inflate, &out)) != 0) {
+				total += used;
+			}
+		} while (result == ESP8266_INFLATE_OUTPUT);
+		
+		/* Stop on invalid data */
+		if (result == ESP8266_INFLATE_ERROR) {
+			return -1;
+		}
+	}
+	
+	/* Stream must be complete */
+	return result == ESP8266_INFLATE_DONE ? total : -1;
+}
+
+/* Reads whole file to memory */
+static uint8_t* ReadFile(const char* name, long* length) {
+	FILE* f;
+	uint8_t* data;
+	
+	/* Open file and get its size */
+	f = fopen(name, "rb");
+	if (f == NULL) {
+		return NULL;
+	}
+	fseek(f, 0, SEEK_END);
+	*length = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	
+	/* Read content */
+	data = (uint8_t *)malloc(*length > 0 ? *length : 1);
+	if (data != NULL && fread(data, 1, *length, f) != (size_t)*length) {
+		free(data);
+		data = NULL;
+	}
+	fclose(f);
+	return data;
+}
+
+int main(int argc, char** argv) {
+	uint16_t part = BENCH_PART_SIZE;
+	int rounds = BENCH_ROUNDS;
+	int i, r, status = 0;
+	long length, total;
+	uint8_t* data;
+	clock_t start;
+	double seconds;
+	
+	/* Parse options */
+	for (i = 1; i < argc - 1 && argv[i][0] == '-'; i += 2) {
+		if (strcmp(argv[i], "-p") == 0) {
+			part = (uint16_t)atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "-n") == 0) {
+			rounds = atoi(argv[i + 1]);
+		} else {
+			break;
+		}
+	}
+	
+	/* Check arguments */
+	if (i >= argc || part == 0 || rounds <= 0) {
+		printf("Usage: %s [-p part] [-n rounds] file...\n", argv[0]);
+		return 1;
+	}
+	
+	/* Decode each file */
+	printf("%-32s %10s %10s %10s\n", "file", "in", "out", "MB/s");
+	for (; i < argc; i++) {
+		data = ReadFile(argv[i], &length);
+		if (data == NULL) {
+			printf("%-32s cannot read\n", argv[i]);
+			status = 1;
+			continue;
+		}
+		
+		/* Repeat decoding to get measurable time */
+		total = 0;
+		start = clock();
+		for (r = 0; r < rounds && total >= 0; r++) {
+			total = Decode(data, length, part);
+		}
+		seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+		
+		/* Report throughput of decompressed data */
+		if (total < 0) {
+			printf("%-32s invalid data\n", argv[i]);
+			status = 1;
+		} else {
+			printf("%-32s %10ld %10ld %10.1f\n", argv[i], length, total, seconds > 0 ? (double)total * rounds / seconds / 1000000.0 : 0.0);
+		}
+		free(data);
+	}
+	return status;
+}
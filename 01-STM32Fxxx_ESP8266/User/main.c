@@ -22,10 +22,18 @@
 #include "tm_stm32_delay.h"
 #include "tm_stm32_usart.h"
 #include "esp8266.h"
+#include "esp8266_http.h"
 
 /* ESP8266 working structure */
 ESP8266_t ESP8266;
 
+/* HTTP request for web page */
+ESP8266_HTTP_Request_t Request;
+
+/* HTTP functions */
+void HTTP_Sink(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const uint8_t* data, uint16_t length);
+void HTTP_Done(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, ESP8266_HTTP_Result_t result);
+
 int main(void) {
 	/* Init system */
 	TM_RCC_InitSystem();
@@ -80,14 +88,22 @@ int main(void) {
 	/* Get connected devices */
 	ESP8266_WifiGetConnected(&ESP8266);
 	
+	/* Set request parameters */
+	Request.Host = "stm32f4-discovery.com";
+	Request.Path = "/";
+	Request.Sink = HTTP_Sink;
+	Request.Done = HTTP_Done;
+	
 	while (1) {
 		/* Update ESP module */
 		ESP8266_Update(&ESP8266);
 		
 		/* Check for button */
 		if (TM_DISCO_ButtonOnPressed()) {
-			/* Starting with connection to web */
-			while (ESP8266_StartClientConnection(&ESP8266, "stm32f4_discovery", "stm32f4-discovery.com", 80, NULL));
+			/* Start request to web page */
+			if (!ESP8266_HTTP_IsBusy(&Request)) {
+				while (ESP8266_HTTP_Request(&ESP8266, &Request));
+			}
 		}
 	}
 }
@@ -160,78 +176,33 @@ void ESP8266_Callback_WifiDetected(ESP8266_t* ESP8266, ESP8266_APs_t* ESP8266_AP
 }
 
 /************************************/
-/*         CLIENT CALLBACKS         */
+/*           HTTP CLIENT            */
 /************************************/
-void ESP8266_Callback_ClientConnectionConnected(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
-	/* We are connected to external server */
-	printf("Client connected to server! Connection number: %s\r\n", Connection->Name);
-	
-	/* We are connected to server, request to sent header data to server */
-	ESP8266_RequestSendData(ESP8266, Connection);
-}
-
-/* Called when client connection fails to server */
-void ESP8266_Callback_ClientConnectionError(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
-	/* Fail with connection to server */
-	printf("An error occured when trying to connect on connection: %d\r\n", Connection->Number);
-}
-
-/* Called when data are ready to be sent to server */
-uint16_t ESP8266_Callback_ClientConnectionSendData(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer, uint16_t max_buffer_size) {
-	/* Format data to sent to server */
-	sprintf(Buffer, "GET / HTTP/1.1\r\n");
-	strcat(Buffer, "Host: stm32f4-discovery.com\r\n");
-	strcat(Buffer, "Connection: close\r\n");
-	strcat(Buffer, "\r\n");
-	
-	/* Return length of buffer */
-	return strlen(Buffer);
-}
-
-/* Called when data are send successfully */
-void ESP8266_Callback_ClientConnectionDataSent(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
-	printf("Data successfully sent as client!\r\n");
-}
-
-/* Called when error returned trying to sent data */
-void ESP8266_Callback_ClientConnectionDataSentError(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
-	printf("Error while sending data on connection %d!\r\n", Connection->Number);
-}
-
 uint32_t time = 0;
-void ESP8266_Callback_ClientConnectionDataReceived(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection, char* Buffer) {
-	/* Data received from server back to client */
-	printf("Data received from server on connection: %s; Number of bytes received: %d; %d / %d;\r\n",
-		Connection->Name,
-		Connection->BytesReceived,
-		Connection->TotalBytesReceived,
-		Connection->ContentLength
-	);
-	
-	/* Print message when first packet */
-	if (Connection->FirstPacket) {
-		/* Start counting time */
+
+/* Called when part of response body is received */
+void HTTP_Sink(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, const uint8_t* data, uint16_t length) {
+	/* Start counting time on first body data */
+	if (Request->BodyReceived == length) {
 		time = TM_DELAY_Time();
 		
 		/* Print first message */
-		printf("This is first packet received. Content length on this connection is: %d\r\n", Connection->ContentLength);
+		printf("Response status: %d; Content length: %d; Chunked: %d\r\n", Request->StatusCode, Request->ContentLength, Request->Chunked);
 	}
+	
+	/* Print progress */
+	printf("Body data received: %d; Total: %d\r\n", length, Request->BodyReceived);
 }
 
-/* Called when connection is closed */
-void ESP8266_Callback_ClientConnectionClosed(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
-	printf("Client connection closed, connection: %d; Total bytes received: %d; Content-Length header: %d\r\n",
-		Connection->Number, Connection->TotalBytesReceived, Connection->ContentLength
-	);
+/* Called when request is finished */
+void HTTP_Done(ESP8266_t* ESP8266, ESP8266_HTTP_Request_t* Request, ESP8266_HTTP_Result_t result) {
+	printf("Request finished with result: %d; Status: %d; Body bytes: %d\r\n", result, Request->StatusCode, Request->BodyReceived);
 	
 	/* Calculate time */
 	time = TM_DELAY_Time() - time;
 	
 	/* Print time we need to get data back from server */
-	printf("Time for data: %u ms; speed: %d kb/s\r\n", time, Connection->TotalBytesReceived / time);
-}
-
-/* Called when timeout is reached on connection to server */
-void ESP8266_Callback_ClientConnectionTimeout(ESP8266_t* ESP8266, ESP8266_Connection_t* Connection) {
-	printf("Timeout reached on connection: %d\r\n", Connection->Number);
+	if (time) {
+		printf("Time for data: %u ms; speed: %d kb/s\r\n", time, Request->BodyReceived / time);
+	}
 }